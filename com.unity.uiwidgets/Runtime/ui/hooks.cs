@@ -34,6 +34,8 @@ namespace Unity.UIWidgets.ui {
                 Window_drawFrame,
                 ui_._dispatchPlatformMessage,
                 ui_._dispatchPointerDataPacket);
+
+            Window_hookReportTimings(ui_._reportTimings);
         }
 
         
@@ -194,6 +196,9 @@ namespace Unity.UIWidgets.ui {
             Window_drawFrameCallback Window_drawFrame,
             ui_.Window_dispatchPlatformMessageCallback Window_dispatchPlatformMessage,
             ui_.Window_dispatchPointerDataPacketCallback Window_dispatchPointerDataPacket);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern void Window_hookReportTimings(ui_.Window_reportTimingsCallback Window_reportTimings);
     }
 
     public static partial class ui_ {
@@ -254,6 +259,45 @@ namespace Unity.UIWidgets.ui {
             }
         }
 
+        internal unsafe delegate void Window_reportTimingsCallback(long* timings, int frameCount,
+            int valuesPerFrame);
+
+        // Each frame is reported as its frame number, the timestamp of each FramePhase in microseconds, then its
+        // raster cache hit and miss counts. Must be kept in sync with FrameTiming::kReportedValueCount.
+        const int _kFramePhaseCount = 5;
+        const int _kReportedValueCount = _kFramePhaseCount + 3;
+
+        [MonoPInvokeCallback(typeof(Window_reportTimingsCallback))]
+        internal static unsafe void _reportTimings(long* timings, int frameCount, int valuesPerFrame) {
+            try {
+                D.assert(valuesPerFrame == _kReportedValueCount);
+                var window = Window.instance;
+                if (window.onReportTimings == null) {
+                    return;
+                }
+
+                var frameTimings = new List<FrameTiming>(frameCount);
+                for (int i = 0; i < frameCount; ++i) {
+                    long* frame = timings + i * valuesPerFrame;
+                    var timestamps = new List<long>(_kFramePhaseCount);
+                    for (int phase = 0; phase < _kFramePhaseCount; ++phase) {
+                        timestamps.Add(frame[1 + phase]);
+                    }
+
+                    frameTimings.Add(new FrameTiming(
+                        timestamps: timestamps,
+                        frameNumber: frame[0],
+                        rasterCacheHits: (int) frame[1 + _kFramePhaseCount],
+                        rasterCacheMisses: (int) frame[2 + _kFramePhaseCount]));
+                }
+
+                window.onReportTimings(frameTimings);
+            }
+            catch (Exception ex) {
+                Debug.LogException(ex);
+            }
+        }
+
         internal static void _invoke1<A>(Action<A> callback, Zone zone, A arg) {
             if (callback == null)
                 return;
@@ -440,14 +440,14 @@ namespace Unity.UIWidgets.ui {
         const int _kDitherOffset = _kDitherIndex << 2;
 
         // If you add more fields, remember to update _kDataByteCount.
-        const int _kDataByteCount = 56;
+        internal const int _kDataByteCount = 56;
 
-        object[] _objects;
+        internal object[] _objects;
         internal IntPtr[] _objectPtrs;
         const int _kShaderIndex = 0;
         const int _kColorFilterIndex = 1;
         const int _kImageFilterIndex = 2;
-        const int _kObjectCount = 3; // Must be one larger than the largest index.
+        internal const int _kObjectCount = 3; // Must be one larger than the largest index.
 
         public Paint() {
             if (enableDithering) {
@@ -899,6 +899,17 @@ namespace Unity.UIWidgets.ui {
         static extern IntPtr FrameInfo_image(IntPtr ptr);
     }
 
+    // The order in which image decodes are started. Must be kept in sync with
+    // ImageDecoder::Priority in image_decoder.h.
+    public enum DecodePriority {
+        // Images on screen.
+        visible,
+        // Images about to be scrolled into view.
+        prefetch,
+        // Images that are not expected to be shown soon.
+        background,
+    }
+
     public class Codec : NativeWrapperDisposable {
         internal Codec(IntPtr ptr) : base(ptr) {
         }
@@ -911,6 +922,20 @@ namespace Unity.UIWidgets.ui {
 
         public int repetitionCount => Codec_repetitionCount(_ptr);
 
+        // Decodes up to |frameCount| frames ahead of the frame being displayed,
+        // none by default. If |cacheAllFrames| is true, the decoded frames of
+        // small animations are kept so that later loops are not decoded again.
+        // Only affects animated images.
+        public void setLookAhead(int frameCount, bool cacheAllFrames = false) {
+            D.assert(frameCount >= 0);
+            Codec_setLookAhead(_ptr, frameCount, cacheAllFrames);
+        }
+
+        // Only affects single frame images whose decode has not started.
+        public void setDecodePriority(DecodePriority priority) {
+            Codec_setDecodePriority(_ptr, (int) priority);
+        }
+
         public Future<FrameInfo> getNextFrame() {
             return ui_._futurize<FrameInfo>(_getNextFrame);
         }
@@ -963,15 +988,68 @@ namespace Unity.UIWidgets.ui {
         }
 
 
+        // |list| is used without being copied, and must not be modified
+        // afterwards. The codec is instantiated on a worker thread.
+        internal static unsafe string _instantiateImageCodecFromBuffer(byte[] list, _Callback<Codec> callback,
+            int targetWidth, int targetHeight) {
+            D.assert(list != null);
+            GCHandle callbackHandle = GCHandle.Alloc(callback);
+            GCHandle listHandle = GCHandle.Alloc(list, GCHandleType.Pinned);
+
+            IntPtr error = Codec_instantiateImageCodecFromBuffer((byte*) listHandle.AddrOfPinnedObject(),
+                list.Length, ui_._releasePinnedBuffer, (IntPtr) listHandle,
+                _instantiateImageCodecCallback, (IntPtr) callbackHandle, targetWidth, targetHeight);
+            if (error != IntPtr.Zero) {
+                listHandle.Free();
+                callbackHandle.Free();
+                return Marshal.PtrToStringAnsi(error);
+            }
+
+            return null;
+        }
+
+        internal static string _instantiateImageCodecFromFile(string path, _Callback<Codec> callback,
+            int targetWidth, int targetHeight) {
+            GCHandle callbackHandle = GCHandle.Alloc(callback);
+
+            IntPtr error = Codec_instantiateImageCodecFromFile(path, _instantiateImageCodecCallback,
+                (IntPtr) callbackHandle, targetWidth, targetHeight);
+            if (error != IntPtr.Zero) {
+                callbackHandle.Free();
+                return Marshal.PtrToStringAnsi(error);
+            }
+
+            return null;
+        }
+
+        internal static string _instantiateImageCodecFromAsset(string assetName, _Callback<Codec> callback,
+            int targetWidth, int targetHeight) {
+            GCHandle callbackHandle = GCHandle.Alloc(callback);
+
+            IntPtr error = Codec_instantiateImageCodecFromAsset(assetName, _instantiateImageCodecCallback,
+                (IntPtr) callbackHandle, targetWidth, targetHeight);
+            if (error != IntPtr.Zero) {
+                callbackHandle.Free();
+                return Marshal.PtrToStringAnsi(error);
+            }
+
+            return null;
+        }
+
+        // Codecs instantiated on a worker thread are answered with null when the
+        // image could not be loaded or recognized, or when the isolate is gone.
         [MonoPInvokeCallback(typeof(Codec_instantiateImageCodecCallback))]
         static void _instantiateImageCodecCallback(IntPtr callbackHandle, IntPtr ptr) {
             GCHandle handle = (GCHandle) callbackHandle;
             var callback = (_Callback<Codec>) handle.Target;
             handle.Free();
 
+            if (!Isolate.checkExists()) {
+                return;
+            }
+
             try {
-                D.assert(ptr != IntPtr.Zero);
-                callback(new Codec(ptr));
+                callback(ptr == IntPtr.Zero ? null : new Codec(ptr));
             }
             catch (Exception ex) {
                 Debug.LogException(ex);
@@ -988,6 +1066,12 @@ namespace Unity.UIWidgets.ui {
         [DllImport(NativeBindings.dllName)]
         static extern int Codec_repetitionCount(IntPtr ptr);
 
+        [DllImport(NativeBindings.dllName)]
+        static extern void Codec_setLookAhead(IntPtr ptr, int frameCount, bool cacheAllFrames);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern void Codec_setDecodePriority(IntPtr ptr, int priority);
+
         delegate void Codec_getNextFrameCallback(IntPtr callbackHandle, IntPtr ptr);
 
         [DllImport(NativeBindings.dllName)]
@@ -999,13 +1083,143 @@ namespace Unity.UIWidgets.ui {
         static extern unsafe IntPtr Codec_instantiateImageCodec(byte* list, int listLength,
             Codec_instantiateImageCodecCallback callback,
             IntPtr callbackHandle, _ImageInfo imageInfo, bool hasImageInfo, int targetWidth, int targetHeight);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern unsafe IntPtr Codec_instantiateImageCodecFromBuffer(byte* data, int dataLength,
+            ui_._ReleaseExternalDataCallback releaseCallback, IntPtr releaseHandle,
+            Codec_instantiateImageCodecCallback callback, IntPtr callbackHandle,
+            int targetWidth, int targetHeight);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern IntPtr Codec_instantiateImageCodecFromFile(string path,
+            Codec_instantiateImageCodecCallback callback, IntPtr callbackHandle,
+            int targetWidth, int targetHeight);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern IntPtr Codec_instantiateImageCodecFromAsset(string assetName,
+            Codec_instantiateImageCodecCallback callback, IntPtr callbackHandle,
+            int targetWidth, int targetHeight);
+    }
+
+    // An image too large to be decoded at once, such as a map or a scanned
+    // document. Only the parts that are drawn are decoded, in tiles, at the
+    // resolution they are drawn at.
+    public class TiledImage : NativeWrapperDisposable {
+        TiledImage(IntPtr ptr) : base(ptr) {
+        }
+
+        public override void DisposePtr(IntPtr ptr) {
+            TiledImage_dispose(ptr);
+        }
+
+        // Returns null if |bytes| is not an encoded image. |bytes| is used
+        // without being copied and must not be modified afterwards. A
+        // |cacheMaxBytes| of zero uses the default budget of decoded tiles.
+        public static unsafe TiledImage fromBytes(byte[] bytes, int cacheMaxBytes = 0) {
+            D.assert(bytes != null);
+            GCHandle bytesHandle = GCHandle.Alloc(bytes, GCHandleType.Pinned);
+            IntPtr ptr = TiledImage_createFromBuffer((byte*) bytesHandle.AddrOfPinnedObject(), bytes.Length,
+                ui_._releasePinnedBuffer, (IntPtr) bytesHandle, cacheMaxBytes);
+            return ptr == IntPtr.Zero ? null : new TiledImage(ptr);
+        }
+
+        // Returns null if the file can not be read or is not an encoded image.
+        public static TiledImage fromFile(string path, int cacheMaxBytes = 0) {
+            D.assert(path != null);
+            IntPtr ptr = TiledImage_createFromFile(path, cacheMaxBytes);
+            return ptr == IntPtr.Zero ? null : new TiledImage(ptr);
+        }
+
+        public int width => TiledImage_width(_ptr);
+
+        public int height => TiledImage_height(_ptr);
+
+        // |callback| is invoked when tiles requested by drawing the image were
+        // decoded, so that the content drawing it can be repainted. It is kept
+        // until it is replaced or the image is disposed.
+        public void setTilesDecodedCallback(VoidCallback callback) {
+            D.assert(callback != null);
+            GCHandle callbackHandle = GCHandle.Alloc(callback);
+            TiledImage_setTilesDecodedCallback(_ptr, _tilesDecodedCallback,
+                _releaseCallbackHandle, (IntPtr) callbackHandle);
+        }
+
+        [MonoPInvokeCallback(typeof(TiledImage_tilesDecodedCallback))]
+        static void _tilesDecodedCallback(IntPtr callbackHandle) {
+            var callback = (VoidCallback) ((GCHandle) callbackHandle).Target;
+            try {
+                callback();
+            }
+            catch (Exception ex) {
+                Debug.LogException(ex);
+            }
+        }
+
+        [MonoPInvokeCallback(typeof(TiledImage_tilesDecodedCallback))]
+        static void _releaseCallbackHandle(IntPtr callbackHandle) {
+            ((GCHandle) callbackHandle).Free();
+        }
+
+        [DllImport(NativeBindings.dllName)]
+        static extern unsafe IntPtr TiledImage_createFromBuffer(byte* data, int dataLength,
+            ui_._ReleaseExternalDataCallback releaseCallback, IntPtr releaseHandle, int cacheMaxBytes);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern IntPtr TiledImage_createFromFile(string path, int cacheMaxBytes);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern void TiledImage_dispose(IntPtr ptr);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern int TiledImage_width(IntPtr ptr);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern int TiledImage_height(IntPtr ptr);
+
+        delegate void TiledImage_tilesDecodedCallback(IntPtr callbackHandle);
+
+        [DllImport(NativeBindings.dllName)]
+        static extern void TiledImage_setTilesDecodedCallback(IntPtr ptr,
+            TiledImage_tilesDecodedCallback callback, TiledImage_tilesDecodedCallback release,
+            IntPtr callbackHandle);
     }
 
     public static partial class ui_ {
+        internal delegate void _ReleaseExternalDataCallback(IntPtr releaseHandle);
+
+        // Unpins a buffer that native code wrapped without copying it, once
+        // native code no longer uses it. The handle is the pinned GCHandle of
+        // the buffer.
+        [MonoPInvokeCallback(typeof(_ReleaseExternalDataCallback))]
+        internal static void _releasePinnedBuffer(IntPtr releaseHandle) {
+            ((GCHandle) releaseHandle).Free();
+        }
+
+        // |list| is used without being copied, and must not be modified
+        // afterwards. The format is recognized on a worker thread.
         public static Future<Codec> instantiateImageCodec(byte[] list, int? targetWidth = null,
             int? targetHeight = null) {
             return _futurize(
-                (_Callback<Codec> callback) => Codec._instantiateImageCodec(list, callback, null,
+                (_Callback<Codec> callback) => Codec._instantiateImageCodecFromBuffer(list, callback,
+                    targetWidth ?? _kDoNotResizeDimension, targetHeight ?? _kDoNotResizeDimension)
+            );
+        }
+
+        // The file is mapped into memory and recognized on a worker thread.
+        public static Future<Codec> instantiateImageCodecFromFile(string path, int? targetWidth = null,
+            int? targetHeight = null) {
+            return _futurize(
+                (_Callback<Codec> callback) => Codec._instantiateImageCodecFromFile(path, callback,
+                    targetWidth ?? _kDoNotResizeDimension, targetHeight ?? _kDoNotResizeDimension)
+            );
+        }
+
+        // The asset is read from the asset bundle of the engine and recognized on
+        // a worker thread.
+        public static Future<Codec> instantiateImageCodecFromAsset(string assetName, int? targetWidth = null,
+            int? targetHeight = null) {
+            return _futurize(
+                (_Callback<Codec> callback) => Codec._instantiateImageCodecFromAsset(assetName, callback,
                     targetWidth ?? _kDoNotResizeDimension, targetHeight ?? _kDoNotResizeDimension)
             );
         }
@@ -2322,6 +2536,38 @@ namespace Unity.UIWidgets.ui {
         intersect,
     }
 
+    // Must be kept in sync with the CanvasOp enum in canvas.cc.
+    static class _CanvasOp {
+        internal const int setPaint = 0;
+        internal const int save = 1;
+        internal const int saveLayerWithoutBounds = 2;
+        internal const int saveLayer = 3;
+        internal const int restore = 4;
+        internal const int translate = 5;
+        internal const int scale = 6;
+        internal const int rotate = 7;
+        internal const int skew = 8;
+        internal const int transform = 9;
+        internal const int clipRect = 10;
+        internal const int clipRRect = 11;
+        internal const int clipPath = 12;
+        internal const int drawColor = 13;
+        internal const int drawLine = 14;
+        internal const int drawPaint = 15;
+        internal const int drawRect = 16;
+        internal const int drawRRect = 17;
+        internal const int drawDRRect = 18;
+        internal const int drawOval = 19;
+        internal const int drawCircle = 20;
+        internal const int drawArc = 21;
+        internal const int drawPath = 22;
+        internal const int drawImage = 23;
+        internal const int drawImageRect = 24;
+        internal const int drawImageNine = 25;
+        internal const int drawPicture = 26;
+        internal const int drawShadow = 27;
+    }
+
     public class Canvas : NativeWrapper {
         public Canvas(PictureRecorder recorder, Rect cullRect = null) {
             D.assert(recorder != null);
@@ -2333,6 +2579,7 @@ namespace Unity.UIWidgets.ui {
             _setPtr(Canvas_constructor(recorder._ptr, cullRect.left, cullRect.top,
                 cullRect.right,
                 cullRect.bottom));
+            recorder._canvas = this;
         }
 
         public override void DisposePtr(IntPtr ptr) {
@@ -2340,242 +2587,303 @@ namespace Unity.UIWidgets.ui {
         }
 
         public virtual void save() {
-            Canvas_save(_ptr);
+            _writeOp(_CanvasOp.save);
+            _didWriteOp();
         }
 
-        public virtual unsafe void saveLayer(Rect bounds, Paint paint) {
+        public virtual void saveLayer(Rect bounds, Paint paint) {
             D.assert(paint != null);
+            int paintIndex = _writePaint(paint);
             if (bounds == null) {
-                fixed (IntPtr* objectsPtr = paint._objectPtrs)
-                fixed (byte* dataPtr = paint._data)
-                    Canvas_saveLayerWithoutBounds(_ptr, objectsPtr, dataPtr);
+                _writeOp(_CanvasOp.saveLayerWithoutBounds);
             }
             else {
                 D.assert(PaintingUtils._rectIsValid(bounds));
-                fixed (IntPtr* objectsPtr = paint._objectPtrs)
-                fixed (byte* dataPtr = paint._data)
-                    Canvas_saveLayer(_ptr, bounds.left, bounds.top, bounds.right, bounds.bottom,
-                        objectsPtr, dataPtr);
+                _writeOp(_CanvasOp.saveLayer);
+                _writeRect(bounds);
             }
+
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
         public virtual void restore() {
-            Canvas_restore(_ptr);
+            _writeOp(_CanvasOp.restore);
+            _didWriteOp();
         }
 
         public virtual int getSaveCount() {
+            _flushCommands();
             return Canvas_getSaveCount(_ptr);
         }
 
         public virtual void translate(float dx, float dy) {
-            Canvas_translate(_ptr, dx, dy);
+            _writeOp(_CanvasOp.translate);
+            _writeFloat(dx);
+            _writeFloat(dy);
+            _didWriteOp();
         }
 
         public virtual void scale(float sx, float? sy = null) {
-            Canvas_scale(_ptr, sx, sy ?? sx);
+            _writeOp(_CanvasOp.scale);
+            _writeFloat(sx);
+            _writeFloat(sy ?? sx);
+            _didWriteOp();
         }
 
         public virtual void rotate(float radians) {
-            Canvas_rotate(_ptr, radians);
+            _writeOp(_CanvasOp.rotate);
+            _writeFloat(radians);
+            _didWriteOp();
         }
 
         public virtual void skew(float sx, float sy) {
-            Canvas_skew(_ptr, sx, sy);
+            _writeOp(_CanvasOp.skew);
+            _writeFloat(sx);
+            _writeFloat(sy);
+            _didWriteOp();
         }
 
-        public virtual unsafe void transform(float[] matrix4) {
+        public virtual void transform(float[] matrix4) {
             D.assert(matrix4 != null);
             if (matrix4.Length != 16)
                 throw new ArgumentException("\"matrix4\" must have 16 entries.");
-            fixed (float* matrx4Ptr = matrix4)
-                Canvas_transform(_ptr, matrx4Ptr);
+            _writeOp(_CanvasOp.transform);
+            _writeFloats(matrix4);
+            _didWriteOp();
         }
 
         public virtual void clipRect(Rect rect, ClipOp clipOp = ClipOp.intersect, bool doAntiAlias = true) {
             D.assert(PaintingUtils._rectIsValid(rect));
-            Canvas_clipRect(_ptr, rect.left, rect.top, rect.right, rect.bottom, (int) clipOp, doAntiAlias);
+            _writeOp(_CanvasOp.clipRect);
+            _writeRect(rect);
+            _writeInt((int) clipOp);
+            _writeBool(doAntiAlias);
+            _didWriteOp();
         }
 
-        public virtual unsafe void clipRRect(RRect rrect, bool doAntiAlias = true) {
+        public virtual void clipRRect(RRect rrect, bool doAntiAlias = true) {
             D.assert(PaintingUtils._rrectIsValid(rrect));
-            fixed (float* rrectPtr = rrect._value32)
-                Canvas_clipRRect(_ptr, rrectPtr, doAntiAlias);
+            _writeOp(_CanvasOp.clipRRect);
+            _writeFloats(rrect._value32);
+            _writeBool(doAntiAlias);
+            _didWriteOp();
         }
 
         public virtual void clipPath(Path path, bool doAntiAlias = true) {
             D.assert(path != null);
-            Canvas_clipPath(_ptr, path._ptr, doAntiAlias);
+            _writeOp(_CanvasOp.clipPath);
+            _writeObject(path);
+            _writeBool(doAntiAlias);
+            _didWriteObjectOp();
         }
 
         public virtual void drawColor(Color color, BlendMode blendMode) {
             D.assert(color != null);
 
-            Canvas_drawColor(_ptr, color.value, (int) blendMode);
+            _writeOp(_CanvasOp.drawColor);
+            _writeInt((int) color.value);
+            _writeInt((int) blendMode);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawLine(Offset p1, Offset p2, Paint paint) {
+        public virtual void drawLine(Offset p1, Offset p2, Paint paint) {
             D.assert(PaintingUtils._offsetIsValid(p1));
             D.assert(PaintingUtils._offsetIsValid(p2));
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawLine(_ptr, p1.dx, p1.dy, p2.dx, p2.dy, objectsPtr, dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawLine);
+            _writeFloat(p1.dx);
+            _writeFloat(p1.dy);
+            _writeFloat(p2.dx);
+            _writeFloat(p2.dy);
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawPaint(Paint paint) {
+        public virtual void drawPaint(Paint paint) {
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawPaint(_ptr, objectsPtr, dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawPaint);
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawRect(Rect rect, Paint paint) {
+        public virtual void drawRect(Rect rect, Paint paint) {
             D.assert(PaintingUtils._rectIsValid(rect));
             D.assert(paint != null);
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawRect(_ptr, rect.left, rect.top, rect.right, rect.bottom,
-                    objectsPtr, dataPtr);
+
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawRect);
+            _writeRect(rect);
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawRRect(RRect rrect, Paint paint) {
+        public virtual void drawRRect(RRect rrect, Paint paint) {
             D.assert(PaintingUtils._rrectIsValid(rrect));
             D.assert(paint != null);
 
-            fixed (float* rrectPtr = rrect._value32)
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawRRect(_ptr, rrectPtr, objectsPtr,
-                    dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawRRect);
+            _writeFloats(rrect._value32);
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawDRRect(RRect outer, RRect inner, Paint paint) {
+        public virtual void drawDRRect(RRect outer, RRect inner, Paint paint) {
             D.assert(PaintingUtils._rrectIsValid(outer));
             D.assert(PaintingUtils._rrectIsValid(inner));
             D.assert(paint != null);
 
-            fixed (float* outerPtr = outer._value32)
-            fixed (float* innerPtr = inner._value32)
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawDRRect(_ptr, outerPtr, innerPtr, objectsPtr,
-                    dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawDRRect);
+            _writeFloats(outer._value32);
+            _writeFloats(inner._value32);
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawOval(Rect rect, Paint paint) {
+        public virtual void drawOval(Rect rect, Paint paint) {
             D.assert(PaintingUtils._rectIsValid(rect));
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawOval(_ptr, rect.left, rect.top, rect.right, rect.bottom,
-                    objectsPtr,
-                    dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawOval);
+            _writeRect(rect);
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawCircle(Offset c, float radius, Paint paint) {
+        public virtual void drawCircle(Offset c, float radius, Paint paint) {
             D.assert(PaintingUtils._offsetIsValid(c));
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawCircle(_ptr, c.dx, c.dy, radius, objectsPtr,
-                    dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawCircle);
+            _writeFloat(c.dx);
+            _writeFloat(c.dy);
+            _writeFloat(radius);
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawArc(Rect rect, float startAngle, float sweepAngle, bool useCenter, Paint paint) {
+        public virtual void drawArc(Rect rect, float startAngle, float sweepAngle, bool useCenter, Paint paint) {
             D.assert(PaintingUtils._rectIsValid(rect));
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawArc(_ptr, rect.left, rect.top, rect.right, rect.bottom, startAngle,
-                    sweepAngle, useCenter, objectsPtr,
-                    dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawArc);
+            _writeRect(rect);
+            _writeFloat(startAngle);
+            _writeFloat(sweepAngle);
+            _writeBool(useCenter);
+            _writeInt(paintIndex);
+            _didWriteOp();
         }
 
-        public virtual unsafe void drawPath(Path path, Paint paint) {
+        public virtual void drawPath(Path path, Paint paint) {
             D.assert(path != null);
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawPath(_ptr, path._ptr, objectsPtr,
-                    dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawPath);
+            _writeObject(path);
+            _writeInt(paintIndex);
+            _didWriteObjectOp();
         }
 
-        public virtual unsafe void drawImage(Image image, Offset p, Paint paint) {
+        public virtual void drawImage(Image image, Offset p, Paint paint) {
             D.assert(image != null);
             D.assert(PaintingUtils._offsetIsValid(p));
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawImage(_ptr, image._ptr, p.dx, p.dy, objectsPtr,
-                    dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawImage);
+            _writeObject(image);
+            _writeFloat(p.dx);
+            _writeFloat(p.dy);
+            _writeInt(paintIndex);
+            _didWriteObjectOp();
         }
 
-        public virtual unsafe void drawImageRect(Image image, Rect src, Rect dst, Paint paint) {
+        public virtual void drawImageRect(Image image, Rect src, Rect dst, Paint paint) {
             D.assert(image != null);
             D.assert(PaintingUtils._rectIsValid(src));
             D.assert(PaintingUtils._rectIsValid(dst));
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawImageRect(_ptr, image._ptr,
-                    src.left,
-                    src.top,
-                    src.right,
-                    src.bottom,
-                    dst.left,
-                    dst.top,
-                    dst.right,
-                    dst.bottom,
-                    objectsPtr,
-                    dataPtr);
-        }
-
-        public virtual unsafe void drawImageNine(Image image, Rect center, Rect dst, Paint paint) {
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawImageRect);
+            _writeObject(image);
+            _writeRect(src);
+            _writeRect(dst);
+            _writeInt(paintIndex);
+            _didWriteObjectOp();
+        }
+
+        public virtual unsafe void drawTiledImageRect(TiledImage image, Rect src, Rect dst, Paint paint) {
+            D.assert(image != null);
+            D.assert(PaintingUtils._rectIsValid(src));
+            D.assert(PaintingUtils._rectIsValid(dst));
+            D.assert(paint != null);
+
+            _flushCommands();
+            fixed (IntPtr* objectPtrs = paint._objectPtrs)
+            fixed (byte* dataPtr = paint._data) {
+                Canvas_drawTiledImageRect(_ptr, image._ptr,
+                    src.left, src.top, src.right, src.bottom,
+                    dst.left, dst.top, dst.right, dst.bottom,
+                    objectPtrs, dataPtr);
+            }
+        }
+
+        public virtual void drawImageNine(Image image, Rect center, Rect dst, Paint paint) {
             D.assert(image != null);
             D.assert(PaintingUtils._rectIsValid(center));
             D.assert(PaintingUtils._rectIsValid(dst));
             D.assert(paint != null);
 
-            fixed (IntPtr* objectsPtr = paint._objectPtrs)
-            fixed (byte* dataPtr = paint._data)
-                Canvas_drawImageNine(_ptr, image._ptr,
-                    center.left,
-                    center.top,
-                    center.right,
-                    center.bottom,
-                    dst.left,
-                    dst.top,
-                    dst.right,
-                    dst.bottom,
-                    objectsPtr,
-                    dataPtr);
+            int paintIndex = _writePaint(paint);
+            _writeOp(_CanvasOp.drawImageNine);
+            _writeObject(image);
+            _writeRect(center);
+            _writeRect(dst);
+            _writeInt(paintIndex);
+            _didWriteObjectOp();
         }
 
         public virtual void drawPicture(Picture picture) {
             D.assert(picture != null);
-            Canvas_drawPicture(_ptr, picture._ptr);
+            _writeOp(_CanvasOp.drawPicture);
+            _writeObject(picture);
+            _didWriteObjectOp();
         }
 
 
         public virtual void drawParagraph(Paragraph paragraph, Offset offset) {
             D.assert(paragraph != null);
             D.assert(PaintingUtils._offsetIsValid(offset));
+            _flushCommands();
             paragraph._paint(this, offset.dx, offset.dy);
         }
+
+        public virtual void drawEditableParagraph(EditableParagraph paragraph, Offset offset) {
+            D.assert(paragraph != null);
+            D.assert(PaintingUtils._offsetIsValid(offset));
+            _flushCommands();
+            paragraph._paint(this, offset.dx, offset.dy);
+        }
+
         public virtual void drawPoints(PointMode pointMode, List<Offset> points, Paint paint) {
             unsafe
             {
                 D.assert(points != null);
                 D.assert(paint != null);
                 float[] list = PaintingUtils._encodePointList(points);
+                _flushCommands();
                 fixed (IntPtr* objectPtrs = paint._objectPtrs)
                 fixed (byte* dataPtr = paint._data)
                 fixed (float* listPtr = list) {
@@ -2588,6 +2896,7 @@ namespace Unity.UIWidgets.ui {
             D.assert(paint != null);
             if (points.Length % 2 != 0)
                 throw new ArgumentException("\"points\" must have an even number of values.");
+            _flushCommands();
             fixed (IntPtr* objectPtrs = paint._objectPtrs)
             fixed (byte* dataPtr = paint._data)
             fixed (float* pointsPtr = points) {
@@ -2599,6 +2908,7 @@ namespace Unity.UIWidgets.ui {
             D.assert(vertices != null);
             D.assert(paint != null);
 
+            _flushCommands();
             fixed (IntPtr* objectPtrs = paint._objectPtrs)
             fixed (byte* dataPtr = paint._data) {
                 Canvas_drawVertices(_ptr, vertices._ptr, (int) blendMode,
@@ -2649,6 +2959,7 @@ namespace Unity.UIWidgets.ui {
 
             uint[] colorBuffer = colors.isEmpty() ? null : PaintingUtils._encodeColorList(colors);
 
+            _flushCommands();
             fixed (IntPtr* objectPtrs = paint._objectPtrs)
             fixed (byte* paintDataPtr = paint._data)
             fixed (float* rstTransformsPtr = rstTransformBuffer,
@@ -2687,6 +2998,7 @@ namespace Unity.UIWidgets.ui {
                 throw new ArgumentException(
                     "If non-null, \"colors\" length must be one fourth the length of \"rstTransforms\" and \"rects\".");
 
+            _flushCommands();
             fixed (IntPtr* objectPtrs = paint._objectPtrs)
             fixed (byte* paintDataPtr = paint._data)
             fixed (float* rstTransformsPtr = rstTransforms,
@@ -2706,125 +3018,185 @@ namespace Unity.UIWidgets.ui {
         public virtual void drawShadow(Path path, Color color, float elevation, bool transparentOccluder) {
             D.assert(path != null);
             D.assert(color != null);
-            Canvas_drawShadow(_ptr, path._ptr, color.value, elevation, transparentOccluder);
-        }
-
-        [DllImport(NativeBindings.dllName)]
-        static extern IntPtr Canvas_constructor(IntPtr recorder,
-            float left,
-            float top,
-            float right,
-            float bottom);
-
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_dispose(IntPtr ptr);
-
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_save(IntPtr ptr);
+            _writeOp(_CanvasOp.drawShadow);
+            _writeObject(path);
+            _writeInt((int) color.value);
+            _writeFloat(elevation);
+            _writeBool(transparentOccluder);
+            _didWriteObjectOp();
+        }
+
+        // Commands are encoded into _ops and replayed natively by
+        // Canvas_flushCommands, one call per batch rather than one per command.
+        // See the CanvasOp encoding in canvas.cc.
+        const int _kFlushWordCount = 16 * 1024;
+        const int _kMaxPaintSlots = 4096;
+
+        int[] _ops = new int[1024];
+        int _opCount;
+        readonly List<IntPtr> _opObjects = new List<IntPtr>();
+        // Keeps the wrappers of _opObjects alive until the batch is flushed.
+        readonly List<object> _opObjectOwners = new List<object>();
+        int _paintSlotCount;
+
+        // The paint written last, and a copy of what it held then. Drawing with
+        // the same unchanged paint again reuses its slot.
+        Paint _lastPaint;
+        int _lastPaintSlot;
+        readonly byte[] _lastPaintData = new byte[Paint._kDataByteCount];
+        readonly IntPtr[] _lastPaintObjects = new IntPtr[Paint._kObjectCount];
+
+        internal unsafe void _flushCommands() {
+            if (_opCount == 0) {
+                return;
+            }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void
-            Canvas_saveLayerWithoutBounds(IntPtr ptr, IntPtr* paintObject, byte* paintData);
+            IntPtr[] objects = _opObjects.ToArray();
+            try {
+                fixed (int* opsPtr = _ops)
+                fixed (IntPtr* objectsPtr = objects)
+                    Canvas_flushCommands(_ptr, (byte*) opsPtr, _opCount * 4, objectsPtr, objects.Length);
+            }
+            finally {
+                _opCount = 0;
+                _opObjects.Clear();
+                _opObjectOwners.Clear();
+                _paintSlotCount = 0;
+                _lastPaint = null;
+            }
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_saveLayer(IntPtr ptr,
-            float left, float top, float right, float bottom, IntPtr* paintObject, byte* paintData);
+        void _ensureOpCapacity(int words) {
+            if (_opCount + words > _ops.Length) {
+                Array.Resize(ref _ops, Math.Max(_ops.Length * 2, _opCount + words));
+            }
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_restore(IntPtr ptr);
+        void _writeInt(int value) {
+            _ensureOpCapacity(1);
+            _ops[_opCount++] = value;
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern int Canvas_getSaveCount(IntPtr ptr);
+        unsafe void _writeFloat(float value) {
+            _writeInt(*(int*) &value);
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_translate(IntPtr ptr,
-            float x, float y);
+        void _writeFloats(float[] values) {
+            _ensureOpCapacity(values.Length);
+            Buffer.BlockCopy(values, 0, _ops, _opCount * 4, values.Length * 4);
+            _opCount += values.Length;
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_scale(IntPtr ptr,
-            float sx, float sy);
+        void _writeBool(bool value) {
+            _writeInt(value ? 1 : 0);
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_rotate(IntPtr ptr,
-            float radians);
+        void _writeRect(Rect rect) {
+            _writeFloat(rect.left);
+            _writeFloat(rect.top);
+            _writeFloat(rect.right);
+            _writeFloat(rect.bottom);
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_skew(IntPtr ptr,
-            float sx, float sy);
+        void _writeOp(int op) {
+            _writeInt(op);
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_transform(IntPtr ptr,
-            float* matrix4);
+        void _writeObject(IntPtr ptr, object owner) {
+            if (ptr == IntPtr.Zero) {
+                _writeInt(-1);
+                return;
+            }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_clipRect(IntPtr ptr,
-            float left, float top, float right, float bottom, int clipOp, bool doAntiAlias);
+            _writeInt(_opObjects.Count);
+            _opObjects.Add(ptr);
+            _opObjectOwners.Add(owner);
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_clipRRect(IntPtr ptr,
-            float* rrect, bool doAntiAlias);
+        void _writeObject(NativeWrapper obj) {
+            _writeObject(obj._ptr, obj);
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_clipPath(IntPtr ptr,
-            IntPtr path, bool doAntiAlias);
+        // Must be called before the command using the paint is written, as it
+        // may flush the batch. Returns the paint slot, or -1 for no paint.
+        int _writePaint(Paint paint) {
+            if (paint == null) {
+                return -1;
+            }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_drawColor(IntPtr ptr,
-            uint color, int blendMode);
+            if (ReferenceEquals(paint, _lastPaint) && _isLastPaintUnchanged()) {
+                return _lastPaintSlot;
+            }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawLine(IntPtr ptr,
-            float x1, float y1, float x2, float y2, IntPtr* paintObject, byte* paintData);
+            if (_paintSlotCount == _kMaxPaintSlots) {
+                _flushCommands();
+            }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawPaint(IntPtr ptr,
-            IntPtr* paintObject, byte* paintData);
+            int slot = _paintSlotCount++;
+            _writeOp(_CanvasOp.setPaint);
+            _writeInt(slot);
+            for (int i = 0; i < Paint._kObjectCount; i++) {
+                IntPtr ptr = paint._objectPtrs?[i] ?? IntPtr.Zero;
+                _writeObject(ptr, paint._objects?[i]);
+                _lastPaintObjects[i] = ptr;
+            }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawRect(IntPtr ptr,
-            float left, float top, float right, float bottom, IntPtr* paintObject, byte* paintData);
+            _ensureOpCapacity(Paint._kDataByteCount / 4);
+            Buffer.BlockCopy(paint._data, 0, _ops, _opCount * 4, Paint._kDataByteCount);
+            _opCount += Paint._kDataByteCount / 4;
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawRRect(IntPtr ptr,
-            float* rrect, IntPtr* paintObject, byte* paintData);
+            Buffer.BlockCopy(paint._data, 0, _lastPaintData, 0, Paint._kDataByteCount);
+            _lastPaint = paint;
+            _lastPaintSlot = slot;
+            return slot;
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawDRRect(IntPtr ptr,
-            float* outer, float* inner, IntPtr* paintObject, byte* paintData);
+        bool _isLastPaintUnchanged() {
+            for (int i = 0; i < Paint._kObjectCount; i++) {
+                if ((_lastPaint._objectPtrs?[i] ?? IntPtr.Zero) != _lastPaintObjects[i]) {
+                    return false;
+                }
+            }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawOval(IntPtr ptr,
-            float left, float top, float right, float bottom, IntPtr* paintObject, byte* paintData);
+            for (int i = 0; i < Paint._kDataByteCount; i++) {
+                if (_lastPaint._data[i] != _lastPaintData[i]) {
+                    return false;
+                }
+            }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawCircle(IntPtr ptr,
-            float x, float y, float radius, IntPtr* paintObject, byte* paintData);
+            return true;
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawArc(IntPtr ptr,
-            float left, float top, float right, float bottom,
-            float startAngle, float sweepAngle, bool useCenter, IntPtr* paintObject, byte* paintData);
+        void _didWriteOp() {
+            if (_opCount >= _kFlushWordCount) {
+                _flushCommands();
+            }
+        }
 
-        [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawPath(IntPtr ptr,
-            IntPtr path, IntPtr* paintObject, byte* paintData);
+        // Paths may be changed, and images and pictures disposed, as soon as the
+        // call returns, so the commands that refer to them are replayed at once.
+        void _didWriteObjectOp() {
+            _flushCommands();
+        }
 
         [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawImage(IntPtr ptr,
-            IntPtr image, float x, float y, IntPtr* paintObject, byte* paintData);
+        static extern IntPtr Canvas_constructor(IntPtr recorder,
+            float left,
+            float top,
+            float right,
+            float bottom);
 
         [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawImageRect(IntPtr ptr,
-            IntPtr image, float srcLeft, float srcTop, float srcRight, float srcBottom,
-            float dstLeft, float dstTop, float dstRight, float dstBottom, IntPtr* paintObject, byte* paintData);
+        static extern void Canvas_dispose(IntPtr ptr);
 
         [DllImport(NativeBindings.dllName)]
-        static extern unsafe void Canvas_drawImageNine(IntPtr ptr,
-            IntPtr image, float centerLeft, float centerTop, float centerRight, float centerBottom,
-            float dstLeft, float dstTop, float dstRight, float dstBottom, IntPtr* paintObject, byte* paintData);
+        static extern int Canvas_getSaveCount(IntPtr ptr);
 
         [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_drawPicture(IntPtr ptr, IntPtr picture);
+        static extern unsafe void Canvas_drawTiledImageRect(IntPtr ptr, IntPtr image,
+            float srcLeft, float srcTop, float srcRight, float srcBottom,
+            float dstLeft, float dstTop, float dstRight, float dstBottom,
+            IntPtr* paintObjects, byte* paintData);
 
         [DllImport(NativeBindings.dllName)]
         static extern unsafe void Canvas_drawPoints(IntPtr ptr,
@@ -2840,8 +3212,8 @@ namespace Unity.UIWidgets.ui {
             float* rects, int rectsLength, uint* colors, int colorsLength, int blendMode, float* cullRect);
 
         [DllImport(NativeBindings.dllName)]
-        static extern void Canvas_drawShadow(IntPtr ptr, IntPtr path, uint color, float elevation,
-            bool transparentOccluder);
+        static extern unsafe void Canvas_flushCommands(IntPtr ptr, byte* ops, int length,
+            IntPtr* objects, int objectCount);
     }
 
     public class Picture : NativeWrapperDisposable {
@@ -2915,9 +3287,13 @@ namespace Unity.UIWidgets.ui {
             PictureRecorder_dispose(ptr);
         }
 
+        internal Canvas _canvas;
+
         public bool isRecording => PictureRecorder_isRecording(_ptr);
 
         public Picture endRecording() {
+            _canvas?._flushCommands();
+            _canvas = null;
             return new Picture(PictureRecorder_endRecording(_ptr));
         }
 
@@ -3105,6 +3481,7 @@ namespace Unity.UIWidgets.ui {
         }
 
         public void paint(Canvas canvas, Offset offset, float width, float height, float frame) {
+            canvas._flushCommands();
             Skottie_Paint(_ptr, canvas._ptr, offset.dx, offset.dy, width, height, frame);
         }
         
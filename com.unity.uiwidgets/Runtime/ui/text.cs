@@ -1,4 +1,4 @@
-using System;
+﻿using System;
 using System.Collections.Generic;
 using System.Linq;
 using System.Runtime.InteropServices;
@@ -658,16 +658,47 @@ namespace Unity.UIWidgets.ui {
             return _futurize((_Callback<object> callback) => {
                 // var completer = new Promise(true);
                 var completerHandle = GCHandle.Alloc(value: callback);
+                IntPtr error;
                 fixed (byte* listPtr = list) {
-                    Font_LoadFontFromList(list: listPtr, size: list.Length, callback: _loadFontCallback,
+                    error = Font_LoadFontFromList(list: listPtr, size: list.Length, callback: _loadFontCallback,
                         (IntPtr) completerHandle,
                         fontFamily: fontFamily);
                 }
 
+                if (error != IntPtr.Zero) {
+                    completerHandle.Free();
+                    return Marshal.PtrToStringAnsi(ptr: error);
+                }
+
+                return null;
+            });
+        }
+
+        public static Future loadFontFromFile(string path, string fontFamily = null) {
+            return _futurize((_Callback<object> callback) => {
+                var completerHandle = GCHandle.Alloc(value: callback);
+                IntPtr error = Font_LoadFontFromFile(path: path, callback: _loadFontCallback,
+                    (IntPtr) completerHandle,
+                    fontFamily: fontFamily);
+                if (error != IntPtr.Zero) {
+                    completerHandle.Free();
+                    return Marshal.PtrToStringAnsi(ptr: error);
+                }
+
                 return null;
             });
         }
 
+        // Fonts loaded between these calls refresh the font caches once, when the
+        // outermost batch ends, instead of after every font.
+        public static void beginFontLoadBatch() {
+            Font_BeginLoadBatch();
+        }
+
+        public static void endFontLoadBatch() {
+            Font_EndLoadBatch();
+        }
+
         [MonoPInvokeCallback(typeof(_loadFontFromListCallback))]
         static void _loadFontCallback(IntPtr callbackHandle) {
             var completerHandle = (GCHandle) callbackHandle;
@@ -688,10 +719,21 @@ namespace Unity.UIWidgets.ui {
         }
 
         [DllImport(dllName: NativeBindings.dllName)]
-        static extern unsafe void Font_LoadFontFromList(byte* list, int size, _loadFontFromListCallback callback,
+        static extern unsafe IntPtr Font_LoadFontFromList(byte* list, int size, _loadFontFromListCallback callback,
+            IntPtr callbackHandle,
+            string fontFamily);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern IntPtr Font_LoadFontFromFile(string path, _loadFontFromListCallback callback,
             IntPtr callbackHandle,
             string fontFamily);
 
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern void Font_BeginLoadBatch();
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern void Font_EndLoadBatch();
+
 
         public static float[] toFloatArrayAndFree(this Float32List data) {
             var result = new float[data.length];
@@ -1560,12 +1602,15 @@ namespace Unity.UIWidgets.ui {
         static extern void Paragraph_layout(IntPtr ptr, float width);
 
         [DllImport(dllName: NativeBindings.dllName)]
-        static extern Float32List Paragraph_getRectsForRange(IntPtr ptr, int start, int end,
-            int boxHeightStyle,
-            int boxWidthStyle);
+        static extern unsafe void Paragraph_layoutBatch(IntPtr* items, float* widths, int count);
 
         [DllImport(dllName: NativeBindings.dllName)]
-        static extern Float32List Paragraph_getRectsForPlaceholders(IntPtr ptr);
+        static extern unsafe int Paragraph_getRectsForRangeIntoBuffer(IntPtr ptr, int start, int end,
+            int boxHeightStyle, int boxWidthStyle, float* buffer, int capacity);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern unsafe int Paragraph_getRectsForPlaceholdersIntoBuffer(IntPtr ptr, float* buffer,
+            int capacity);
 
         [DllImport(dllName: NativeBindings.dllName)]
         static extern unsafe void Paragraph_getPositionForOffset(IntPtr ptr, float dx, float dy, int* encodedPtr);
@@ -1580,7 +1625,7 @@ namespace Unity.UIWidgets.ui {
         static extern void Paragraph_paint(IntPtr ptr, IntPtr canvas, float x, float y);
 
         [DllImport(dllName: NativeBindings.dllName)]
-        static extern Float32List Paragraph_computeLineMetrics(IntPtr ptr);
+        static extern unsafe int Paragraph_computeLineMetricsIntoBuffer(IntPtr ptr, float* buffer, int capacity);
 
         [DllImport(dllName: NativeBindings.dllName)]
         static extern void Paragraph_dispose(IntPtr ptr);
@@ -1593,6 +1638,26 @@ namespace Unity.UIWidgets.ui {
             Paragraph_layout(ptr: _ptr, width: width);
         }
 
+        // Lays out each of |paragraphs| with the constraints at the same index.
+        // The paragraphs must be distinct. Those that were not laid out at the
+        // same width before are spread over the engine's worker threads.
+        public static unsafe void layoutBatch(IList<Paragraph> paragraphs,
+            IList<ParagraphConstraints> constraints) {
+            D.assert(paragraphs.Count == constraints.Count);
+            var count = paragraphs.Count;
+            var items = new IntPtr[count];
+            var widths = new float[count];
+            for (var i = 0; i < count; i++) {
+                items[i] = paragraphs[i]._ptr;
+                widths[i] = constraints[i].width;
+            }
+
+            fixed (IntPtr* itemsPtr = items)
+            fixed (float* widthsPtr = widths) {
+                Paragraph_layoutBatch(items: itemsPtr, widths: widthsPtr, count: count);
+            }
+        }
+
         List<TextBox> _decodeTextBoxes(float[] encoded, int size) {
             var count = size / 5;
             var boxes = new List<TextBox>();
@@ -1646,28 +1711,52 @@ namespace Unity.UIWidgets.ui {
             return Paragraph_didExceedMaxLines(ptr: _ptr);
         }
 
-        public List<TextBox> getBoxesForRange(int start, int end,
+        // Filled by the queries below, which are only made on the UI thread. The
+        // native side returns the size of the result and leaves the buffer alone
+        // when it is too small, in which case it is grown and the query repeated.
+        static float[] _queryBuffer = new float[64];
+
+        static void _growQueryBuffer(int size) {
+            _queryBuffer = new float[Mathf.Max(size, _queryBuffer.Length * 2)];
+        }
+
+        public unsafe List<TextBox> getBoxesForRange(int start, int end,
             BoxHeightStyle boxHeightStyle = BoxHeightStyle.tight,
             BoxWidthStyle boxWidthStyle = BoxWidthStyle.tight) {
-            var data = _getBoxesForRange(start: start, end: end, (int) boxHeightStyle, (int) boxWidthStyle)
-                .toFloatArrayAndFree();
-            return _decodeTextBoxes(encoded: data, size: data.Length);
-        }
+            int size;
+            while (true) {
+                // See paragraph.cc for the layout of the result.
+                fixed (float* buffer = _queryBuffer) {
+                    size = Paragraph_getRectsForRangeIntoBuffer(ptr: _ptr, start: start, end: end,
+                        (int) boxHeightStyle, (int) boxWidthStyle, buffer: buffer, capacity: _queryBuffer.Length);
+                }
 
-        // See paragraph.cc for the layout of this return value.
-        Float32List _getBoxesForRange(int start, int end, int boxHeightStyle, int boxWidthStyle) {
-            return Paragraph_getRectsForRange(ptr: _ptr, start: start, end: end, boxHeightStyle: boxHeightStyle,
-                boxWidthStyle: boxWidthStyle);
-        }
+                if (size <= _queryBuffer.Length) {
+                    break;
+                }
 
+                _growQueryBuffer(size: size);
+            }
 
-        public List<TextBox> getBoxesForPlaceholders() {
-            var data = _getBoxesForPlaceholders().toFloatArrayAndFree();
-            return _decodeTextBoxes(encoded: data, size: data.Length);
+            return _decodeTextBoxes(encoded: _queryBuffer, size: size);
         }
 
-        Float32List _getBoxesForPlaceholders() {
-            return Paragraph_getRectsForPlaceholders(ptr: _ptr);
+        public unsafe List<TextBox> getBoxesForPlaceholders() {
+            int size;
+            while (true) {
+                fixed (float* buffer = _queryBuffer) {
+                    size = Paragraph_getRectsForPlaceholdersIntoBuffer(ptr: _ptr, buffer: buffer,
+                        capacity: _queryBuffer.Length);
+                }
+
+                if (size <= _queryBuffer.Length) {
+                    break;
+                }
+
+                _growQueryBuffer(size: size);
+            }
+
+            return _decodeTextBoxes(encoded: _queryBuffer, size: size);
         }
 
         public unsafe TextPosition getPositionForOffset(Offset offset) {
@@ -1713,9 +1802,23 @@ namespace Unity.UIWidgets.ui {
             Paragraph_paint(ptr: _ptr, canvas: canvas._ptr, x: x, y: y);
         }
 
-        public List<LineMetrics> computeLineMetrics() {
-            var data = _computeLineMetrics().toFloatArrayAndFree();
-            var count = data.Length / 9;
+        public unsafe List<LineMetrics> computeLineMetrics() {
+            int size;
+            while (true) {
+                fixed (float* buffer = _queryBuffer) {
+                    size = Paragraph_computeLineMetricsIntoBuffer(ptr: _ptr, buffer: buffer,
+                        capacity: _queryBuffer.Length);
+                }
+
+                if (size <= _queryBuffer.Length) {
+                    break;
+                }
+
+                _growQueryBuffer(size: size);
+            }
+
+            var data = _queryBuffer;
+            var count = size / 9;
             var position = 0;
             var metrics = new List<LineMetrics>();
 
@@ -1735,9 +1838,140 @@ namespace Unity.UIWidgets.ui {
 
             return metrics;
         }
+    }
+
+    // A paragraph of plain text in a single style that is edited in place, for
+    // text fields and editors showing long documents. Only the blocks of text
+    // between hard line breaks touched by an edit are laid out again. Maximum
+    // line counts and ellipses are not supported.
+    public class EditableParagraph : NativeWrapper {
+        internal EditableParagraph(IntPtr ptr) {
+            _setPtr(ptr: ptr);
+        }
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern void EditableParagraph_replace(IntPtr ptr, int offset, int length,
+            [MarshalAs(unmanagedType: UnmanagedType.LPWStr)]
+            string text);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern int EditableParagraph_textLength(IntPtr ptr);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern float EditableParagraph_width(IntPtr ptr);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern float EditableParagraph_height(IntPtr ptr);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern float EditableParagraph_longestLine(IntPtr ptr);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern float EditableParagraph_minIntrinsicWidth(IntPtr ptr);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern float EditableParagraph_maxIntrinsicWidth(IntPtr ptr);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern void EditableParagraph_layout(IntPtr ptr, float width);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern void EditableParagraph_paint(IntPtr ptr, IntPtr canvas, float x, float y);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern Float32List EditableParagraph_getRectsForRange(IntPtr ptr, int start, int end,
+            int boxHeightStyle, int boxWidthStyle);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern unsafe void EditableParagraph_getPositionForOffset(IntPtr ptr, float dx, float dy,
+            int* encodedPtr);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern unsafe void EditableParagraph_getLineBoundary(IntPtr ptr, int offset, int* boundaryPtr);
+
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern void EditableParagraph_dispose(IntPtr ptr);
+
+        public override void DisposePtr(IntPtr ptr) {
+            EditableParagraph_dispose(ptr: ptr);
+        }
+
+        // Replaces the |length| code units at |offset| with |text|. The edited
+        // blocks are laid out again by the next call to layout.
+        public void replace(int offset, int length, string text) {
+            D.assert(offset >= 0 && length >= 0 && offset + length <= textLength);
+            EditableParagraph_replace(ptr: _ptr, offset: offset, length: length, text: text);
+        }
+
+        public int textLength => EditableParagraph_textLength(ptr: _ptr);
+
+        public float width() {
+            return EditableParagraph_width(ptr: _ptr);
+        }
+
+        public float height() {
+            return EditableParagraph_height(ptr: _ptr);
+        }
+
+        public float longestLine() {
+            return EditableParagraph_longestLine(ptr: _ptr);
+        }
+
+        public float minIntrinsicWidth() {
+            return EditableParagraph_minIntrinsicWidth(ptr: _ptr);
+        }
+
+        public float maxIntrinsicWidth() {
+            return EditableParagraph_maxIntrinsicWidth(ptr: _ptr);
+        }
+
+        public void layout(ParagraphConstraints constraints) {
+            EditableParagraph_layout(ptr: _ptr, width: constraints.width);
+        }
+
+        public List<TextBox> getBoxesForRange(int start, int end,
+            BoxHeightStyle boxHeightStyle = BoxHeightStyle.tight,
+            BoxWidthStyle boxWidthStyle = BoxWidthStyle.tight) {
+            // See editable_paragraph.cc for the layout of the result.
+            var encoded = EditableParagraph_getRectsForRange(ptr: _ptr, start: start, end: end,
+                (int) boxHeightStyle, (int) boxWidthStyle).toFloatArrayAndFree();
+            var count = encoded.Length / 5;
+            var boxes = new List<TextBox>(count);
+            var position = 0;
+            for (var index = 0; index < count; index += 1) {
+                boxes.Add(TextBox.fromLTRBD(
+                    encoded[position++],
+                    encoded[position++],
+                    encoded[position++],
+                    encoded[position++],
+                    (TextDirection) encoded[position++]
+                ));
+            }
+
+            return boxes;
+        }
+
+        public unsafe TextPosition getPositionForOffset(Offset offset) {
+            var encoded = new int[2];
+            fixed (int* encodedPtr = encoded) {
+                EditableParagraph_getPositionForOffset(ptr: _ptr, dx: offset.dx, dy: offset.dy,
+                    encodedPtr: encodedPtr);
+            }
+
+            return new TextPosition(encoded[0], (TextAffinity) encoded[1]);
+        }
+
+        public unsafe TextRange getLineBoundary(TextPosition position) {
+            var boundary = new int[2];
+            fixed (int* boundaryPtr = boundary) {
+                EditableParagraph_getLineBoundary(ptr: _ptr, offset: position.offset, boundaryPtr: boundaryPtr);
+            }
+
+            return new TextRange(boundary[0], boundary[1]);
+        }
 
-        Float32List _computeLineMetrics() {
-            return Paragraph_computeLineMetrics(ptr: _ptr);
+        internal void _paint(Canvas canvas, float x, float y) {
+            EditableParagraph_paint(ptr: _ptr, canvas: canvas._ptr, x: x, y: y);
         }
     }
 
@@ -1825,6 +2059,9 @@ namespace Unity.UIWidgets.ui {
         [DllImport(dllName: NativeBindings.dllName)]
         static extern IntPtr ParagraphBuilder_build(IntPtr ptr);
 
+        [DllImport(dllName: NativeBindings.dllName)]
+        static extern IntPtr ParagraphBuilder_buildEditable(IntPtr ptr);
+
         [DllImport(dllName: NativeBindings.dllName)]
         static extern void ParagraphBuilder_dispose(IntPtr ptr);
 
@@ -1989,5 +2226,12 @@ namespace Unity.UIWidgets.ui {
         IntPtr _build() {
             return ParagraphBuilder_build(ptr: _ptr);
         }
+
+        // Builds an editable paragraph from the text added so far, in the style
+        // pushed last. Placeholders are ignored. Called instead of build.
+        public EditableParagraph buildEditable() {
+            var ptr = ParagraphBuilder_buildEditable(ptr: _ptr);
+            return ptr == IntPtr.Zero ? null : new EditableParagraph(ptr);
+        }
     }
 }
\ No newline at end of file
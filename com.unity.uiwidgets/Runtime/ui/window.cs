@@ -26,6 +26,7 @@ namespace Unity.UIWidgets.ui {
     delegate void _SetNeedsReportTimingsFunc(IntPtr ptr, bool value);
 
     public enum FramePhase {
+        vsyncStart,
         buildStart,
         buildFinish,
         rasterStart,
@@ -33,11 +34,21 @@ namespace Unity.UIWidgets.ui {
     }
 
     public class FrameTiming {
-        public FrameTiming(List<long> timestamps) {
+        public FrameTiming(List<long> timestamps, long frameNumber = 0, int rasterCacheHits = 0,
+            int rasterCacheMisses = 0) {
             D.assert(timestamps.Count == Enum.GetNames(typeof(FramePhase)).Length);
             _timestamps = timestamps;
+            this.frameNumber = frameNumber;
+            this.rasterCacheHits = rasterCacheHits;
+            this.rasterCacheMisses = rasterCacheMisses;
         }
 
+        public readonly long frameNumber;
+
+        public readonly int rasterCacheHits;
+
+        public readonly int rasterCacheMisses;
+
         public long timestampInMicroseconds(FramePhase phase) => _timestamps[(int) phase];
 
         TimeSpan _rawDuration(FramePhase phase) => TimeSpan.FromMilliseconds(_timestamps[(int) phase] / 1000.0);
@@ -46,7 +57,9 @@ namespace Unity.UIWidgets.ui {
 
         public TimeSpan rasterDuration => _rawDuration(FramePhase.rasterFinish) - _rawDuration(FramePhase.rasterStart);
 
-        public TimeSpan totalSpan => _rawDuration(FramePhase.rasterFinish) - _rawDuration(FramePhase.buildStart);
+        public TimeSpan vsyncOverhead => _rawDuration(FramePhase.buildStart) - _rawDuration(FramePhase.vsyncStart);
+
+        public TimeSpan totalSpan => _rawDuration(FramePhase.rasterFinish) - _rawDuration(FramePhase.vsyncStart);
 
         List<long> _timestamps; // in microseconds
 
@@ -54,7 +67,7 @@ namespace Unity.UIWidgets.ui {
 
         public override string ToString() {
             return
-                $"{GetType()}(buildDuration: {_formatMS(buildDuration)}, rasterDuration: {_formatMS(rasterDuration)}, totalSpan: {_formatMS(totalSpan)})";
+                $"{GetType()}(frameNumber: {frameNumber}, buildDuration: {_formatMS(buildDuration)}, rasterDuration: {_formatMS(rasterDuration)}, vsyncOverhead: {_formatMS(vsyncOverhead)}, totalSpan: {_formatMS(totalSpan)}, rasterCacheHits: {rasterCacheHits}, rasterCacheMisses: {rasterCacheMisses})";
         }
     }
 
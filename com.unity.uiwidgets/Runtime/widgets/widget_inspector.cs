@@ -286,6 +286,11 @@ namespace Unity.UIWidgets.widgets {
             _screenshot.drawImageRect(image, src, dst, paint);
         }
 
+        public override void drawTiledImageRect(TiledImage image, Rect src, Rect dst, Paint paint) {
+            _main.drawTiledImageRect(image, src, dst, paint);
+            _screenshot.drawTiledImageRect(image, src, dst, paint);
+        }
+
         public override void drawLine(Offset p1, Offset p2, Paint paint) {
             _main.drawLine(p1, p2, paint);
             _screenshot.drawLine(p1, p2, paint);
@@ -306,6 +311,11 @@ namespace Unity.UIWidgets.widgets {
             _screenshot.drawParagraph(paragraph, offset);
         }
 
+        public override void drawEditableParagraph(ui.EditableParagraph paragraph, Offset offset) {
+            _main.drawEditableParagraph(paragraph, offset);
+            _screenshot.drawEditableParagraph(paragraph, offset);
+        }
+
         public override void drawPath(Path path, Paint paint) {
             _main.drawPath(path, paint);
             _screenshot.drawPath(path, paint);
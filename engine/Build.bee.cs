@@ -339,6 +339,8 @@ class Build
                 "src/flow/layers/transform_layer.h",
                 "src/flow/compositor_context.cc",
                 "src/flow/compositor_context.h",
+                "src/flow/diff_context.cc",
+                "src/flow/diff_context.h",
                 "src/flow/embedded_views.cc",
                 "src/flow/embedded_views.h",
                 "src/flow/instrumentation.cc",
@@ -366,19 +368,31 @@ class Build
 
                 "src/lib/ui/text/icu_util.h",
                 "src/lib/ui/text/icu_util.cc",
+                "src/lib/ui/text/line_metrics_index.cc",
+                "src/lib/ui/text/line_metrics_index.h",
                 "src/lib/ui/text/asset_manager_font_provider.cc",
                 "src/lib/ui/text/asset_manager_font_provider.h",
+                "src/lib/ui/text/editable_paragraph.cc",
+                "src/lib/ui/text/editable_paragraph.h",
                 "src/lib/ui/text/paragraph_builder.cc",
                 "src/lib/ui/text/paragraph_builder.h",
                 "src/lib/ui/text/font_collection.cc",
                 "src/lib/ui/text/font_collection.h",
+                "src/lib/ui/text/glyph_cache_prewarmer.cc",
+                "src/lib/ui/text/glyph_cache_prewarmer.h",
                 "src/lib/ui/text/paragraph.cc",
                 "src/lib/ui/text/paragraph.h",
+                "src/lib/ui/text/paragraph_cache.cc",
+                "src/lib/ui/text/paragraph_cache.h",
 
                 "src/lib/ui/painting/canvas.cc",
                 "src/lib/ui/painting/canvas.h",
                 "src/lib/ui/painting/codec.cc",
                 "src/lib/ui/painting/codec.h",
+                "src/lib/ui/painting/compressed_texture.cc",
+                "src/lib/ui/painting/compressed_texture.h",
+                "src/lib/ui/painting/decoded_image_cache.cc",
+                "src/lib/ui/painting/decoded_image_cache.h",
                 "src/lib/ui/painting/color_filter.cc",
                 "src/lib/ui/painting/color_filter.h",
                 "src/lib/ui/painting/engine_layer.cc",
@@ -395,6 +409,8 @@ class Build
                 "src/lib/ui/painting/image_encoding.h",
                 "src/lib/ui/painting/image_filter.cc",
                 "src/lib/ui/painting/image_filter.h",
+                "src/lib/ui/painting/image_resizer.cc",
+                "src/lib/ui/painting/image_resizer.h",
                 "src/lib/ui/painting/image_shader.cc",
                 "src/lib/ui/painting/image_shader.h",
                 "src/lib/ui/painting/matrix.cc",
@@ -407,6 +423,8 @@ class Build
                 "src/lib/ui/painting/path_measure.h",
                 "src/lib/ui/painting/paint.cc",
                 "src/lib/ui/painting/paint.h",
+                "src/lib/ui/painting/paint_cache.cc",
+                "src/lib/ui/painting/paint_cache.h",
                 "src/lib/ui/painting/picture.cc",
                 "src/lib/ui/painting/picture.h",
                 "src/lib/ui/painting/picture_recorder.cc",
@@ -419,6 +437,8 @@ class Build
                 "src/lib/ui/painting/single_frame_codec.h",
                 "src/lib/ui/painting/skottie.cc",
                 "src/lib/ui/painting/skottie.h",
+                "src/lib/ui/painting/tiled_image.cc",
+                "src/lib/ui/painting/tiled_image.h",
                 "src/lib/ui/painting/vertices.cc",
                 "src/lib/ui/painting/vertices.h",
 
@@ -439,6 +459,8 @@ class Build
                 "src/lib/ui/window/window.cc",
                 "src/lib/ui/window/window.h",
 
+                "src/lib/ui/external_data.cc",
+                "src/lib/ui/external_data.h",
                 "src/lib/ui/io_manager.h",
                 "src/lib/ui/snapshot_delegate.h",
                 "src/lib/ui/ui_mono_state.cc",
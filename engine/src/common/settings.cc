@@ -44,6 +44,7 @@ std::string Settings::ToString() const {
   stream << "observatory_host: " << observatory_host << std::endl;
   stream << "observatory_port: " << observatory_port << std::endl;
   stream << "use_test_fonts: " << use_test_fonts << std::endl;
+  stream << "glyph_prewarm_asset: " << glyph_prewarm_asset << std::endl;
   stream << "enable_software_rendering: " << enable_software_rendering
          << std::endl;
   stream << "log_tag: " << log_tag << std::endl;
@@ -52,6 +53,27 @@ std::string Settings::ToString() const {
   stream << "icu_data_path: " << icu_data_path << std::endl;
   stream << "assets_dir: " << assets_dir << std::endl;
   stream << "assets_path: " << assets_path << std::endl;
+  stream << "raster_cache_max_bytes: " << raster_cache_max_bytes << std::endl;
+  stream << "raster_cache_max_unused_frames: "
+         << raster_cache_max_unused_frames << std::endl;
+  stream << "raster_cache_max_variants_per_id: "
+         << raster_cache_max_variants_per_id << std::endl;
+  stream << "raster_cache_deferred_population: "
+         << raster_cache_deferred_population << std::endl;
+  stream << "decoded_image_cache_max_bytes: "
+         << decoded_image_cache_max_bytes << std::endl;
+  stream << "image_resize_quality: " << static_cast<int>(image_resize_quality)
+         << std::endl;
+  stream << "image_decoder_max_concurrent_decodes: "
+         << image_decoder_max_concurrent_decodes << std::endl;
+  stream << "enable_partial_repaint: " << enable_partial_repaint << std::endl;
+  stream << "enable_parallel_preroll: " << enable_parallel_preroll
+         << std::endl;
+  stream << "frame_pipeline_depth: " << frame_pipeline_depth << std::endl;
+  stream << "enable_adaptive_frame_pipeline_depth: "
+         << enable_adaptive_frame_pipeline_depth << std::endl;
+  stream << "max_frame_pipeline_depth: " << max_frame_pipeline_depth
+         << std::endl;
   stream << "frame_rasterized_callback set: " << !!frame_rasterized_callback
          << std::endl;
   stream << "old_gen_heap_size: " << old_gen_heap_size << std::endl;
@@ -16,18 +16,45 @@ namespace uiwidgets {
 
 class FrameTiming {
  public:
-  enum Phase { kBuildStart, kBuildFinish, kRasterStart, kRasterFinish, kCount };
-
-  static constexpr Phase kPhases[kCount] = {kBuildStart, kBuildFinish,
-                                            kRasterStart, kRasterFinish};
+  enum Phase {
+    kVsyncStart,
+    kBuildStart,
+    kBuildFinish,
+    kRasterStart,
+    kRasterFinish,
+    kCount
+  };
+
+  static constexpr Phase kPhases[kCount] = {
+      kVsyncStart, kBuildStart, kBuildFinish, kRasterStart, kRasterFinish};
+
+  // The number of values a frame is reported as: its frame number, the time
+  // of each phase in microseconds since the epoch, then its raster cache hit
+  // and miss counts.
+  static constexpr size_t kReportedValueCount = kCount + 3;
 
   fml::TimePoint Get(Phase phase) const { return data_[phase]; }
   fml::TimePoint Set(Phase phase, fml::TimePoint value) {
     return data_[phase] = value;
   }
 
+  int64_t frame_number() const { return frame_number_; }
+  void set_frame_number(int64_t frame_number) { frame_number_ = frame_number; }
+
+  // Raster cache lookups made while painting the frame that found, or did not
+  // find, a cached image.
+  size_t raster_cache_hits() const { return raster_cache_hits_; }
+  size_t raster_cache_misses() const { return raster_cache_misses_; }
+  void set_raster_cache_stats(size_t hits, size_t misses) {
+    raster_cache_hits_ = hits;
+    raster_cache_misses_ = misses;
+  }
+
  private:
   fml::TimePoint data_[kCount];
+  int64_t frame_number_ = 0;
+  size_t raster_cache_hits_ = 0;
+  size_t raster_cache_misses_ = 0;
 };
 
 using TaskObserverAdd =
@@ -46,6 +73,17 @@ using MappingsCallback =
 
 using FrameRasterizedCallback = std::function<void(const FrameTiming&)>;
 
+// How the image decoder resizes images decoded to a target size.
+enum class ImageResizeQuality {
+  // Bilinear sampling of the decoded image. Fastest, but aliases when
+  // images are reduced more than twice.
+  kLow,
+  // Box filtering by the integer part of the reduction, then bilinear.
+  kMedium,
+  // Box filtering to less than four times the target size, then Lanczos.
+  kHigh,
+};
+
 struct Settings {
   Settings();
 
@@ -124,6 +162,9 @@ struct Settings {
 
   // Font settings
   bool use_test_fonts = false;
+  // The asset listing the glyphs rasterized into the glyph cache on startup,
+  // see GlyphCachePrewarmer. Empty to skip prewarming.
+  std::string glyph_prewarm_asset;
 
   // All shells in the process share the same VM. The last shell to shutdown
   // should typically shut down the VM as well. However, applications depend on
@@ -181,6 +222,52 @@ struct Settings {
   std::string assets_path;
   std::string font_data;
 
+  // Raster cache settings
+  // The byte budget of the raster cache. Entries that were not used in the
+  // last frame are only evicted ahead of time when the cache exceeds it.
+  size_t raster_cache_max_bytes = 64 * 1024 * 1024;
+  // The number of frames a raster cache entry is kept after its last use. A
+  // value of 1 evicts every entry that was not used in the previous frame.
+  size_t raster_cache_max_unused_frames = 30;
+  // The number of transforms a single picture or layer is cached at, beyond
+  // which the least recently used one is evicted.
+  size_t raster_cache_max_variants_per_id = 4;
+  // Whether pictures are rasterized into the raster cache after the frame that
+  // requested them was submitted, instead of synchronously during Preroll.
+  bool raster_cache_deferred_population = false;
+
+  // Image decoder settings
+  // The byte budget of the decoded images shared between codecs decoding the
+  // same bytes, see DecodedImageCache. Zero disables sharing.
+  size_t decoded_image_cache_max_bytes = 32 * 1024 * 1024;
+  ImageResizeQuality image_resize_quality = ImageResizeQuality::kMedium;
+  // The number of decodes the image decoder runs at once, the others waiting
+  // in its priority queue. Zero uses one per worker thread.
+  size_t image_decoder_max_concurrent_decodes = 0;
+
+  // Whether the rasterizer repaints only the region that changed since the
+  // previous frame, on surfaces that keep their contents between frames. Off
+  // by default, as it relies on the embedder reporting every re-created
+  // render target.
+  bool enable_partial_repaint = false;
+
+  // Whether the Preroll of layers with many children is spread over the
+  // engine's concurrent worker threads. Raster cache population stays on the
+  // raster thread.
+  bool enable_parallel_preroll = false;
+
+  // Frame pipeline settings
+  // The number of frames the UI thread may build ahead of the raster thread.
+  // Frames are always rasterized one at a time when the platform and raster
+  // task runners are merged.
+  uint32_t frame_pipeline_depth = 2;
+  // Whether the pipeline grows, up to |max_frame_pipeline_depth|, when the
+  // raster thread falls behind and UI frames are dropped, and shrinks back to
+  // |frame_pipeline_depth| once rasterization keeps up again. Every extra
+  // frame in the pipeline adds a frame of latency.
+  bool enable_adaptive_frame_pipeline_depth = false;
+  uint32_t max_frame_pipeline_depth = 3;
+
   // Callback to handle the timings of a rasterized frame. This is called as
   // soon as a frame is rasterized.
   FrameRasterizedCallback frame_rasterized_callback;
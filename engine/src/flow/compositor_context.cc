@@ -1,5 +1,6 @@
 #include "flow/compositor_context.h"
 
+#include "flow/diff_context.h"
 #include "flow/layers/layer_tree.h"
 #include "include/core/SkCanvas.h"
 
@@ -58,6 +59,33 @@ CompositorContext::ScopedFrame::~ScopedFrame() {
   context_.EndFrame(*this, instrumentation_enabled_);
 }
 
+void CompositorContext::ScopedFrame::EnablePartialRepaint(
+    const LayerTree* previous_layer_tree) {
+  partial_repaint_enabled_ = true;
+  previous_layer_tree_ = previous_layer_tree;
+}
+
+bool CompositorContext::ScopedFrame::ComputeDamage(LayerTree& layer_tree) {
+  TRACE_EVENT0("uiwidgets", "CompositorContext::ScopedFrame::ComputeDamage");
+
+  const SkISize frame_size = canvas()->getBaseLayerSize();
+  layer_tree.RecordDiff(root_surface_transformation_, frame_size);
+
+  if (!previous_layer_tree_ || !previous_layer_tree_->diff_context()) {
+    return false;
+  }
+  SkIRect damage;
+  if (!DiffContext::ComputeDamage(*previous_layer_tree_->diff_context(),
+                                  *layer_tree.diff_context(), &damage)) {
+    return false;
+  }
+  if (!damage.intersect(SkIRect::MakeSize(frame_size))) {
+    damage.setEmpty();
+  }
+  damage_ = damage;
+  return true;
+}
+
 RasterStatus CompositorContext::ScopedFrame::Raster(
     LayerTree& layer_tree, bool ignore_raster_cache) {
   TRACE_EVENT0("uiwidgets", "CompositorContext::ScopedFrame::Raster");
@@ -72,20 +100,50 @@ RasterStatus CompositorContext::ScopedFrame::Raster(
   if (post_preroll_result == PostPrerollResult::kResubmitFrame) {
     return RasterStatus::kResubmit;
   }
-  // Clearing canvas after preroll reduces one render target switch when preroll
-  // paints some raster cache.
-  if (canvas()) {
-    if (needs_save_layer) {
-      FML_LOG(INFO) << "Using SaveLayer to protect non-readback surface";
-      SkRect bounds = SkRect::Make(layer_tree.frame_size());
-      SkPaint paint;
-      paint.setBlendMode(SkBlendMode::kSrc);
-      canvas()->saveLayer(&bounds, &paint);
+
+  if (!canvas()) {
+    damage_.setEmpty();
+    layer_tree.Paint(*this, ignore_raster_cache);
+    return RasterStatus::kSuccess;
+  }
+
+  damage_ = SkIRect::MakeSize(canvas()->getBaseLayerSize());
+
+  // Platform views are composited by the embedder outside of the canvas, and
+  // the readback save layer covers the whole frame, so both repaint it all.
+  bool partial_repaint = partial_repaint_enabled_ && !view_embedder_ &&
+                         !needs_save_layer && ComputeDamage(layer_tree);
+  if (partial_repaint) {
+    if (damage_.isEmpty()) {
+      TRACE_EVENT_INSTANT0("uiwidgets", "Frame unchanged, skipping paint");
+      return RasterStatus::kSuccess;
     }
+
+    // The damage is in device space, while the canvas carries the root
+    // surface transformation.
+    canvas()->save();
+    const SkMatrix matrix = canvas()->getTotalMatrix();
+    canvas()->resetMatrix();
+    canvas()->clipRect(SkRect::Make(damage_));
+    canvas()->setMatrix(matrix);
     canvas()->clear(SK_ColorTRANSPARENT);
+    layer_tree.Paint(*this, ignore_raster_cache);
+    canvas()->restore();
+    return RasterStatus::kSuccess;
+  }
+
+  // Clearing canvas after preroll reduces one render target switch when preroll
+  // paints some raster cache.
+  if (needs_save_layer) {
+    FML_LOG(INFO) << "Using SaveLayer to protect non-readback surface";
+    SkRect bounds = SkRect::Make(layer_tree.frame_size());
+    SkPaint paint;
+    paint.setBlendMode(SkBlendMode::kSrc);
+    canvas()->saveLayer(&bounds, &paint);
   }
+  canvas()->clear(SK_ColorTRANSPARENT);
   layer_tree.Paint(*this, ignore_raster_cache);
-  if (canvas() && needs_save_layer) {
+  if (needs_save_layer) {
     canvas()->restore();
   }
   return RasterStatus::kSuccess;
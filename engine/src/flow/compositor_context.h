@@ -7,6 +7,7 @@
 #include "flow/instrumentation.h"
 #include "flow/raster_cache.h"
 #include "flow/texture.h"
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/raster_thread_merger.h"
 #include "include/core/SkCanvas.h"
@@ -56,6 +57,13 @@ class CompositorContext {
 
     GrContext* gr_context() const { return gr_context_; }
 
+    // Makes Raster repaint only the region of the canvas where |layer_tree|
+    // differs from |previous_layer_tree|, which must be the tree last
+    // rasterized into the same, still intact, surface. A null
+    // |previous_layer_tree| repaints everything, but still records the tree
+    // for the next frame to be compared against.
+    void EnablePartialRepaint(const LayerTree* previous_layer_tree);
+
     virtual RasterStatus Raster(LayerTree& layer_tree,
                                 bool ignore_raster_cache);
 
@@ -68,6 +76,11 @@ class CompositorContext {
     const bool instrumentation_enabled_;
     const bool surface_supports_readback_;
     fml::RefPtr<fml::RasterThreadMerger> raster_thread_merger_;
+    bool partial_repaint_enabled_ = false;
+    const LayerTree* previous_layer_tree_ = nullptr;
+    SkIRect damage_ = SkIRect::MakeEmpty();
+
+    bool ComputeDamage(LayerTree& layer_tree);
 
     FML_DISALLOW_COPY_AND_ASSIGN(ScopedFrame);
   };
@@ -89,6 +102,17 @@ class CompositorContext {
 
   RasterCache& raster_cache() { return raster_cache_; }
 
+  // Enables spreading the Preroll of containers with many children over the
+  // workers of |loop|. Pass null to preroll on the raster thread only.
+  void SetParallelPrerollLoop(
+      std::shared_ptr<fml::ConcurrentMessageLoop> loop) {
+    parallel_preroll_loop_ = std::move(loop);
+  }
+
+  fml::ConcurrentMessageLoop* parallel_preroll_loop() const {
+    return parallel_preroll_loop_.get();
+  }
+
   TextureRegistry& texture_registry() { return texture_registry_; }
 
   const Counter& frame_count() const { return frame_count_; }
@@ -103,6 +127,7 @@ class CompositorContext {
   Counter frame_count_;
   Stopwatch raster_time_;
   Stopwatch ui_time_;
+  std::shared_ptr<fml::ConcurrentMessageLoop> parallel_preroll_loop_;
 
   void BeginFrame(ScopedFrame& frame, bool enable_instrumentation);
 
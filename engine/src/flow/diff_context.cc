@@ -0,0 +1,224 @@
+#include "flow/diff_context.h"
+
+#include <unordered_map>
+
+#include "flutter/fml/hash_combine.h"
+#include "flutter/fml/logging.h"
+
+namespace uiwidgets {
+
+namespace {
+
+size_t HashEntry(const DiffContext::Entry& entry) {
+  return fml::HashCombine(entry.fingerprint, entry.bounds.fLeft,
+                          entry.bounds.fTop, entry.bounds.fRight,
+                          entry.bounds.fBottom);
+}
+
+bool EntriesMatch(const DiffContext::Entry& lhs,
+                  const DiffContext::Entry& rhs) {
+  return !lhs.is_volatile && !rhs.is_volatile &&
+         lhs.fingerprint == rhs.fingerprint && lhs.bounds == rhs.bounds;
+}
+
+}  // namespace
+
+DiffContext::DiffContext(const SkMatrix& root_transformation,
+                         const SkISize& frame_size)
+    : matrix_(root_transformation),
+      clip_(SkIRect::MakeSize(frame_size)),
+      state_(fml::HashCombine()),
+      frame_size_(frame_size) {
+  if (matrix_.hasPerspective()) {
+    supported_ = false;
+  }
+}
+
+DiffContext::~DiffContext() = default;
+
+DiffContext::AutoSubtreeRestore::AutoSubtreeRestore(DiffContext* context)
+    : context_(context),
+      matrix_(context->matrix_),
+      clip_(context->clip_),
+      state_(context->state_) {}
+
+DiffContext::AutoSubtreeRestore::~AutoSubtreeRestore() {
+  context_->matrix_ = matrix_;
+  context_->clip_ = clip_;
+  context_->state_ = state_;
+}
+
+void DiffContext::PushTransform(const SkMatrix& transform) {
+  matrix_.preConcat(transform);
+  // Bounds mapped through a perspective transform are not reliable enough to
+  // limit a repaint to.
+  if (matrix_.hasPerspective()) {
+    supported_ = false;
+  }
+}
+
+void DiffContext::ClipRect(const SkRect& clip_bounds) {
+  SkIRect device_clip = matrix_.mapRect(clip_bounds).roundOut();
+  if (!clip_.intersect(device_clip)) {
+    clip_.setEmpty();
+  }
+}
+
+void DiffContext::AddState(size_t hash) {
+  state_ = fml::HashCombine(state_, hash);
+}
+
+bool DiffContext::MapBounds(const SkRect& local_bounds,
+                            SkIRect* device_bounds) const {
+  SkIRect bounds = matrix_.mapRect(local_bounds).roundOut();
+  // Anti-aliased edges may touch one pixel outside of the mapped bounds.
+  bounds.outset(1, 1);
+  if (!bounds.intersect(clip_)) {
+    return false;
+  }
+  *device_bounds = bounds;
+  return true;
+}
+
+void DiffContext::AddLeaf(const SkRect& local_bounds, size_t fingerprint) {
+  SkIRect bounds;
+  if (!MapBounds(local_bounds, &bounds)) {
+    return;
+  }
+  // The transform is part of the fingerprint, as content may be drawn
+  // differently (rotated, mirrored) into the same device bounds.
+  size_t hash = fml::HashCombine(state_, fingerprint);
+  for (int i = 0; i < 9; i++) {
+    hash = fml::HashCombine(hash, matrix_[i]);
+  }
+  entries_.push_back({hash, bounds, false});
+}
+
+void DiffContext::AddVolatileLeaf(const SkRect& local_bounds) {
+  SkIRect bounds;
+  if (!MapBounds(local_bounds, &bounds)) {
+    return;
+  }
+  entries_.push_back({0, bounds, true});
+}
+
+void DiffContext::EndGroup(size_t group_start, const SkRect& local_bounds,
+                           size_t fingerprint) {
+  FML_DCHECK(group_start <= entries_.size());
+
+  SkIRect bounds;
+  if (!MapBounds(local_bounds, &bounds)) {
+    bounds.setEmpty();
+  }
+  bool is_volatile = false;
+  size_t hash = fml::HashCombine(state_, fingerprint);
+  for (int i = 0; i < 9; i++) {
+    hash = fml::HashCombine(hash, matrix_[i]);
+  }
+  for (size_t i = group_start; i < entries_.size(); i++) {
+    const Entry& entry = entries_[i];
+    hash = fml::HashCombine(hash, HashEntry(entry));
+    is_volatile |= entry.is_volatile;
+    bounds.join(entry.bounds);
+  }
+  entries_.resize(group_start);
+  if (bounds.isEmpty()) {
+    return;
+  }
+  entries_.push_back({hash, bounds, is_volatile});
+}
+
+size_t DiffContext::HashRect(const SkRect& rect) {
+  return fml::HashCombine(rect.fLeft, rect.fTop, rect.fRight, rect.fBottom);
+}
+
+size_t DiffContext::HashRRect(const SkRRect& rrect) {
+  size_t hash = HashRect(rrect.rect());
+  for (int i = 0; i < 4; i++) {
+    const SkVector& radii = rrect.radii(static_cast<SkRRect::Corner>(i));
+    hash = fml::HashCombine(hash, radii.fX, radii.fY);
+  }
+  return hash;
+}
+
+size_t DiffContext::HashPath(const SkPath& path) {
+  size_t hash = fml::HashCombine(static_cast<int>(path.getFillType()));
+  const int point_count = path.countPoints();
+  for (int i = 0; i < point_count; i++) {
+    const SkPoint point = path.getPoint(i);
+    hash = fml::HashCombine(hash, point.fX, point.fY);
+  }
+  SkPath::Iter iter(path, false);
+  SkPoint points[4];
+  for (SkPath::Verb verb = iter.next(points); verb != SkPath::kDone_Verb;
+       verb = iter.next(points)) {
+    hash = fml::HashCombine(hash, static_cast<int>(verb));
+    // Conics carry weights that are not part of the points.
+    if (verb == SkPath::kConic_Verb) {
+      hash = fml::HashCombine(hash, iter.conicWeight());
+    }
+  }
+  return hash;
+}
+
+bool DiffContext::ComputeDamage(const DiffContext& previous,
+                                const DiffContext& current, SkIRect* damage) {
+  if (!previous.supported_ || !current.supported_ ||
+      previous.frame_size_ != current.frame_size_) {
+    return false;
+  }
+
+  struct Candidates {
+    std::vector<size_t> indices;
+    size_t cursor = 0;
+  };
+  std::unordered_map<size_t, Candidates> previous_index;
+  for (size_t i = 0; i < previous.entries_.size(); i++) {
+    const Entry& entry = previous.entries_[i];
+    if (!entry.is_volatile) {
+      previous_index[HashEntry(entry)].indices.push_back(i);
+    }
+  }
+
+  // Entries are matched in paint order. Once an entry of the previous frame
+  // is matched, the ones painted before it can no longer match, so that
+  // content changing its stacking order is repainted.
+  std::vector<bool> matched(previous.entries_.size(), false);
+  size_t next_previous = 0;
+  SkIRect result = SkIRect::MakeEmpty();
+  for (const Entry& entry : current.entries_) {
+    bool is_matched = false;
+    if (!entry.is_volatile) {
+      auto found = previous_index.find(HashEntry(entry));
+      if (found != previous_index.end()) {
+        Candidates& candidates = found->second;
+        while (candidates.cursor < candidates.indices.size() &&
+               candidates.indices[candidates.cursor] < next_previous) {
+          candidates.cursor++;
+        }
+        if (candidates.cursor < candidates.indices.size()) {
+          size_t index = candidates.indices[candidates.cursor];
+          if (EntriesMatch(previous.entries_[index], entry)) {
+            matched[index] = true;
+            next_previous = index + 1;
+            is_matched = true;
+          }
+        }
+      }
+    }
+    if (!is_matched) {
+      result.join(entry.bounds);
+    }
+  }
+
+  for (size_t i = 0; i < previous.entries_.size(); i++) {
+    if (!matched[i]) {
+      result.join(previous.entries_[i].bounds);
+    }
+  }
+
+  *damage = result;
+  return true;
+}
+
+}  // namespace uiwidgets
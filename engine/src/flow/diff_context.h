@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkRRect.h"
+#include "include/core/SkRect.h"
+
+namespace uiwidgets {
+
+// Records what a layer tree paints, in device space, so that two consecutive
+// frames can be compared and only the region that changed is repainted.
+//
+// Layers describe themselves through Layer::Diff once Preroll has computed
+// their paint bounds. Leaf content is recorded as entries made of a
+// fingerprint (what is drawn and with which ancestor effects) and the device
+// bounds it covers. Layers that cannot be described this way mark the context
+// as unsupported, which forces a full repaint.
+class DiffContext {
+ public:
+  struct Entry {
+    size_t fingerprint;
+    SkIRect bounds;
+    // Content that may change without the layer tree changing, such as
+    // external textures. Never matches an entry of another frame.
+    bool is_volatile;
+  };
+
+  DiffContext(const SkMatrix& root_transformation, const SkISize& frame_size);
+
+  ~DiffContext();
+
+  // Saves the transform, clip and ancestor state on construction and restores
+  // them on destruction.
+  class AutoSubtreeRestore {
+   public:
+    explicit AutoSubtreeRestore(DiffContext* context);
+
+    ~AutoSubtreeRestore();
+
+   private:
+    DiffContext* context_;
+    SkMatrix matrix_;
+    SkIRect clip_;
+    size_t state_;
+
+    FML_DISALLOW_COPY_AND_ASSIGN(AutoSubtreeRestore);
+  };
+
+  void PushTransform(const SkMatrix& transform);
+
+  // Restricts the content below to |clip_bounds|, in local coordinates. The
+  // exact shape of non rectangular clips is expected to be folded into the
+  // ancestor state with AddState.
+  void ClipRect(const SkRect& clip_bounds);
+
+  // Folds parameters of the current layer into the fingerprint of everything
+  // recorded below it.
+  void AddState(size_t hash);
+
+  // Records leaf content covering |local_bounds|.
+  void AddLeaf(const SkRect& local_bounds, size_t fingerprint);
+
+  // Records leaf content that has to be repainted on every frame.
+  void AddVolatileLeaf(const SkRect& local_bounds);
+
+  // Records a subtree as a single entry. Used by layers whose effect is not
+  // confined to the bounds of their children (image filters, shadows), so
+  // that any change below them repaints the whole layer. Entries recorded
+  // since the matching BeginGroup are folded into one, covering them and
+  // |local_bounds|.
+  size_t BeginGroup() const { return entries_.size(); }
+  void EndGroup(size_t group_start, const SkRect& local_bounds,
+                size_t fingerprint);
+
+  void MarkUnsupported() { supported_ = false; }
+
+  bool supported() const { return supported_; }
+
+  const std::vector<Entry>& entries() const { return entries_; }
+
+  const SkISize& frame_size() const { return frame_size_; }
+
+  static size_t HashRect(const SkRect& rect);
+  static size_t HashRRect(const SkRRect& rrect);
+  // Hashes the geometry of |path|, so that equal paths recorded into
+  // different SkPath objects are recognized as such.
+  static size_t HashPath(const SkPath& path);
+
+  // Computes the device region painted differently by |current| than by
+  // |previous|. Returns false when the frames cannot be compared, in which
+  // case the whole frame has to be repainted. An empty |damage| means the
+  // frames are identical.
+  static bool ComputeDamage(const DiffContext& previous,
+                            const DiffContext& current, SkIRect* damage);
+
+ private:
+  SkMatrix matrix_;
+  SkIRect clip_;
+  size_t state_;
+  SkISize frame_size_;
+  bool supported_ = true;
+  std::vector<Entry> entries_;
+
+  bool MapBounds(const SkRect& local_bounds, SkIRect* device_bounds) const;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(DiffContext);
+};
+
+}  // namespace uiwidgets
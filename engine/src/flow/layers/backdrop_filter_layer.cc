@@ -1,5 +1,7 @@
 #include "flow/layers/backdrop_filter_layer.h"
 
+#include "flutter/fml/hash_combine.h"
+
 namespace uiwidgets {
 
 BackdropFilterLayer::BackdropFilterLayer(sk_sp<SkImageFilter> filter)
@@ -22,4 +24,15 @@ void BackdropFilterLayer::Paint(PaintContext& context) const {
   PaintChildren(context);
 }
 
+void BackdropFilterLayer::Diff(DiffContext* context) const {
+  // The filter reads whatever was painted below it, which a change anywhere
+  // in the frame may affect.
+  context->MarkUnsupported();
+}
+
+bool BackdropFilterLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(fingerprint->hash, filter_.get());
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
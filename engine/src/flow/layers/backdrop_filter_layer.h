@@ -10,6 +10,8 @@ class BackdropFilterLayer : public ContainerLayer {
   void Preroll(PrerollContext* context, const SkMatrix& matrix) override;
 
   void Paint(PaintContext& context) const override;
+  void Diff(DiffContext* context) const override;
+  bool Fingerprint(LayerFingerprint* fingerprint) const override;
 
  private:
   sk_sp<SkImageFilter> filter_;
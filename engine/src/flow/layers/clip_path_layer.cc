@@ -1,5 +1,7 @@
 #include "flow/layers/clip_path_layer.h"
 
+#include "flutter/fml/hash_combine.h"
+
 namespace uiwidgets {
 
 ClipPathLayer::ClipPathLayer(const SkPath& clip_path, Clip clip_behavior)
@@ -53,4 +55,23 @@ void ClipPathLayer::Paint(PaintContext& context) const {
   }
 }
 
+void ClipPathLayer::Diff(DiffContext* context) const {
+  if (!children_inside_clip_) {
+    return;
+  }
+
+  DiffContext::AutoSubtreeRestore subtree(context);
+  context->ClipRect(clip_path_.getBounds());
+  context->AddState(fml::HashCombine(DiffContext::HashPath(clip_path_),
+                                     static_cast<int>(clip_behavior_)));
+  DiffChildren(context);
+}
+
+bool ClipPathLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(
+      fingerprint->hash, DiffContext::HashPath(clip_path_),
+      static_cast<int>(clip_behavior_));
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
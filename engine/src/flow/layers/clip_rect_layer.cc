@@ -1,5 +1,7 @@
 #include "flow/layers/clip_rect_layer.h"
 
+#include "flutter/fml/hash_combine.h"
+
 namespace uiwidgets {
 
 ClipRectLayer::ClipRectLayer(const SkRect& clip_rect, Clip clip_behavior)
@@ -52,4 +54,23 @@ void ClipRectLayer::Paint(PaintContext& context) const {
   }
 }
 
+void ClipRectLayer::Diff(DiffContext* context) const {
+  if (!children_inside_clip_) {
+    return;
+  }
+
+  DiffContext::AutoSubtreeRestore subtree(context);
+  context->ClipRect(clip_rect_);
+  context->AddState(fml::HashCombine(DiffContext::HashRect(clip_rect_),
+                                     static_cast<int>(clip_behavior_)));
+  DiffChildren(context);
+}
+
+bool ClipRectLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(
+      fingerprint->hash, DiffContext::HashRect(clip_rect_),
+      static_cast<int>(clip_behavior_));
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
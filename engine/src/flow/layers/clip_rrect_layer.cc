@@ -1,5 +1,7 @@
 #include "flow/layers/clip_rrect_layer.h"
 
+#include "flutter/fml/hash_combine.h"
+
 namespace uiwidgets {
 
 ClipRRectLayer::ClipRRectLayer(const SkRRect& clip_rrect, Clip clip_behavior)
@@ -53,4 +55,23 @@ void ClipRRectLayer::Paint(PaintContext& context) const {
   }
 }
 
+void ClipRRectLayer::Diff(DiffContext* context) const {
+  if (!children_inside_clip_) {
+    return;
+  }
+
+  DiffContext::AutoSubtreeRestore subtree(context);
+  context->ClipRect(clip_rrect_.getBounds());
+  context->AddState(fml::HashCombine(DiffContext::HashRRect(clip_rrect_),
+                                     static_cast<int>(clip_behavior_)));
+  DiffChildren(context);
+}
+
+bool ClipRRectLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(
+      fingerprint->hash, DiffContext::HashRRect(clip_rrect_),
+      static_cast<int>(clip_behavior_));
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
@@ -1,5 +1,7 @@
 #include "flow/layers/color_filter_layer.h"
 
+#include "flutter/fml/hash_combine.h"
+
 namespace uiwidgets {
 
 ColorFilterLayer::ColorFilterLayer(sk_sp<SkColorFilter> filter)
@@ -24,4 +26,18 @@ void ColorFilterLayer::Paint(PaintContext& context) const {
   PaintChildren(context);
 }
 
+void ColorFilterLayer::Diff(DiffContext* context) const {
+  // A color filter may change the transparent pixels of the saveLayer too, so
+  // the layer is diffed as a whole.
+  size_t group_start = context->BeginGroup();
+  DiffChildren(context);
+  context->EndGroup(group_start, paint_bounds(),
+                    std::hash<SkColorFilter*>()(filter_.get()));
+}
+
+bool ColorFilterLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(fingerprint->hash, filter_.get());
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
@@ -11,6 +11,8 @@ class ColorFilterLayer : public ContainerLayer {
   void Preroll(PrerollContext* context, const SkMatrix& matrix) override;
 
   void Paint(PaintContext& context) const override;
+  void Diff(DiffContext* context) const override;
+  bool Fingerprint(LayerFingerprint* fingerprint) const override;
 
  private:
   sk_sp<SkColorFilter> filter_;
@@ -1,7 +1,18 @@
 #include "flow/layers/container_layer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include "flutter/fml/hash_combine.h"
+#include "flutter/fml/synchronization/count_down_latch.h"
+
 namespace uiwidgets {
 
+// The number of children each thread has to preroll at least before the
+// Preroll of a container is spread over worker threads.
+static constexpr size_t kMinChildrenPerPrerollChunk = 8;
+
 ContainerLayer::ContainerLayer() {}
 
 void ContainerLayer::Add(std::shared_ptr<Layer> layer) {
@@ -22,12 +33,21 @@ void ContainerLayer::Paint(PaintContext& context) const {
   PaintChildren(context);
 }
 
+void ContainerLayer::Diff(DiffContext* context) const {
+  DiffChildren(context);
+}
+
 void ContainerLayer::PrerollChildren(PrerollContext* context,
                                      const SkMatrix& child_matrix,
                                      SkRect* child_paint_bounds) {
   // Platform views have no children, so context->has_platform_view should
   // always be false.
   FML_DCHECK(!context->has_platform_view);
+  if (CanPrerollChildrenInParallel(context)) {
+    PrerollChildrenInParallel(context, child_matrix, child_paint_bounds);
+    return;
+  }
+
   bool child_has_platform_view = false;
   for (auto& layer : layers_) {
     // Reset context->has_platform_view to false so that layers aren't treated
@@ -49,6 +69,123 @@ void ContainerLayer::PrerollChildren(PrerollContext* context,
   context->has_platform_view = child_has_platform_view;
 }
 
+bool ContainerLayer::CanPrerollChildrenInParallel(
+    const PrerollContext* context) const {
+  // A Preroll running on a worker does not fork again, and platform views
+  // have to be registered with the view embedder in paint order.
+  return context->concurrent_message_loop != nullptr &&
+         context->raster_cache_requests == nullptr &&
+         context->view_embedder == nullptr &&
+         layers_.size() >= 2 * kMinChildrenPerPrerollChunk;
+}
+
+void ContainerLayer::PrerollChildrenInParallel(PrerollContext* context,
+                                               const SkMatrix& child_matrix,
+                                               SkRect* child_paint_bounds) {
+  TRACE_EVENT0("uiwidgets", "ContainerLayer::PrerollChildrenInParallel");
+
+  fml::ConcurrentMessageLoop* loop = context->concurrent_message_loop;
+  // The calling thread prerolls chunks itself too.
+  const size_t max_chunk_count = layers_.size() / kMinChildrenPerPrerollChunk;
+  const size_t chunk_count = std::max<size_t>(
+      1, std::min(loop->GetWorkerCount() + 1, max_chunk_count));
+  const size_t chunk_size = (layers_.size() + chunk_count - 1) / chunk_count;
+
+  // Each chunk of consecutive children is prerolled with a fork of |context|
+  // owning its mutators stack and queueing its raster cache requests.
+  struct Chunk {
+    size_t begin;
+    size_t end;
+    MutatorsStack mutators_stack;
+    RasterCacheRequestQueue raster_cache_requests;
+    bool surface_needs_readback;
+  };
+
+  // The chunks are claimed one at a time by the calling thread and by the
+  // tasks posted to the workers. The calling thread keeps claiming until none
+  // are left, then only waits for the chunks that workers are prerolling, so
+  // a pool busy with other work does not stall the raster thread. Tasks that
+  // start late find nothing left and return without touching |context|,
+  // which is why the state is shared with them.
+  struct Preroll {
+    explicit Preroll(size_t chunk_count)
+        : chunks(chunk_count), done(chunk_count) {}
+
+    // Prerolls chunks until all of them were claimed.
+    void Run() {
+      for (size_t chunk = next_chunk.fetch_add(1); chunk < chunks.size();
+           chunk = next_chunk.fetch_add(1)) {
+        preroll_chunk(&chunks[chunk]);
+        done.CountDown();
+      }
+    }
+
+    std::vector<Chunk> chunks;
+    std::function<void(Chunk*)> preroll_chunk;
+    std::atomic<size_t> next_chunk{0};
+    fml::CountDownLatch done;
+  };
+  auto preroll = std::make_shared<Preroll>(chunk_count);
+  for (size_t i = 0; i < chunk_count; i++) {
+    Chunk& chunk = preroll->chunks[i];
+    chunk.begin = std::min(i * chunk_size, layers_.size());
+    chunk.end = std::min(chunk.begin + chunk_size, layers_.size());
+    chunk.mutators_stack = context->mutators_stack;
+  }
+
+  preroll->preroll_chunk = [this, context, &child_matrix](Chunk* chunk) {
+    PrerollContext fork = {context->raster_cache,
+                           context->gr_context,
+                           context->view_embedder,
+                           chunk->mutators_stack,
+                           context->dst_color_space,
+                           context->cull_rect,
+                           context->surface_needs_readback,
+                           context->raster_time,
+                           context->ui_time,
+                           context->texture_registry,
+                           context->checkerboard_offscreen_layers,
+                           context->frame_physical_depth,
+                           context->frame_device_pixel_ratio,
+                           context->total_elevation,
+                           false,
+                           context->is_opaque,
+                           nullptr,
+                           &chunk->raster_cache_requests};
+    for (size_t i = chunk->begin; i < chunk->end; i++) {
+      layers_[i]->Preroll(&fork, child_matrix);
+    }
+    chunk->surface_needs_readback = fork.surface_needs_readback;
+  };
+
+  auto task_runner = loop->GetTaskRunner();
+  for (size_t i = 1; i < chunk_count; i++) {
+    task_runner->PostTask([preroll]() { preroll->Run(); });
+  }
+  preroll->Run();
+  preroll->done.Wait();
+
+  // Merge the chunks back in paint order, so that raster cache entries are
+  // prepared in the same order as by a serial Preroll.
+  for (Chunk& chunk : preroll->chunks) {
+    if (chunk.surface_needs_readback) {
+      context->surface_needs_readback = true;
+    }
+    if (context->raster_cache) {
+      chunk.raster_cache_requests.Replay(context);
+    }
+  }
+  for (auto& layer : layers_) {
+    if (layer->needs_system_composite()) {
+      set_needs_system_composite(true);
+    }
+    child_paint_bounds->join(layer->paint_bounds());
+  }
+
+  // Platform views are never prerolled in parallel.
+  context->has_platform_view = false;
+}
+
 void ContainerLayer::PaintChildren(PaintContext& context) const {
   FML_DCHECK(needs_painting());
 
@@ -61,4 +198,25 @@ void ContainerLayer::PaintChildren(PaintContext& context) const {
   }
 }
 
+void ContainerLayer::DiffChildren(DiffContext* context) const {
+  for (auto& layer : layers_) {
+    if (!context->supported()) {
+      return;
+    }
+    if (layer->needs_painting()) {
+      layer->Diff(context);
+    }
+  }
+}
+
+bool ContainerLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(fingerprint->hash, layers_.size());
+  for (auto& layer : layers_) {
+    if (!layer->Fingerprint(fingerprint)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace uiwidgets
@@ -14,6 +14,8 @@ class ContainerLayer : public Layer {
 
   void Preroll(PrerollContext* context, const SkMatrix& matrix) override;
   void Paint(PaintContext& context) const override;
+  void Diff(DiffContext* context) const override;
+  bool Fingerprint(LayerFingerprint* fingerprint) const override;
 
   const std::vector<std::shared_ptr<Layer>>& layers() const { return layers_; }
 
@@ -21,6 +23,7 @@ class ContainerLayer : public Layer {
   void PrerollChildren(PrerollContext* context, const SkMatrix& child_matrix,
                        SkRect* child_paint_bounds);
   void PaintChildren(PaintContext& context) const;
+  void DiffChildren(DiffContext* context) const;
 
   // For OpacityLayer to restructure to have a single child.
   void ClearChildren() { layers_.clear(); }
@@ -28,6 +31,11 @@ class ContainerLayer : public Layer {
  private:
   std::vector<std::shared_ptr<Layer>> layers_;
 
+  bool CanPrerollChildrenInParallel(const PrerollContext* context) const;
+  void PrerollChildrenInParallel(PrerollContext* context,
+                                 const SkMatrix& child_matrix,
+                                 SkRect* child_paint_bounds);
+
   FML_DISALLOW_COPY_AND_ASSIGN(ContainerLayer);
 };
 
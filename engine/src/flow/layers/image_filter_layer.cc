@@ -1,5 +1,7 @@
 #include "flow/layers/image_filter_layer.h"
 
+#include "flutter/fml/hash_combine.h"
+
 namespace uiwidgets {
 
 ImageFilterLayer::ImageFilterLayer(sk_sp<SkImageFilter> filter)
@@ -66,4 +68,18 @@ void ImageFilterLayer::Paint(PaintContext& context) const {
   PaintChildren(context);
 }
 
+void ImageFilterLayer::Diff(DiffContext* context) const {
+  // The filter output may extend past the children (blurs), so the layer is
+  // diffed as a whole.
+  size_t group_start = context->BeginGroup();
+  DiffChildren(context);
+  context->EndGroup(group_start, paint_bounds(),
+                    std::hash<SkImageFilter*>()(filter_.get()));
+}
+
+bool ImageFilterLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(fingerprint->hash, filter_.get());
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
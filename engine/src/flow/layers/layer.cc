@@ -23,6 +23,10 @@ uint64_t Layer::NextUniqueID() {
 
 void Layer::Preroll(PrerollContext* context, const SkMatrix& matrix) {}
 
+void Layer::Diff(DiffContext* context) const { context->MarkUnsupported(); }
+
+bool Layer::Fingerprint(LayerFingerprint* fingerprint) const { return false; }
+
 Layer::AutoPrerollSaveLayerState::AutoPrerollSaveLayerState(
     PrerollContext* preroll_context, bool save_layer_is_active,
     bool layer_itself_performs_readback)
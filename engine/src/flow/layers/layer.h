@@ -3,12 +3,14 @@
 #include <memory>
 #include <vector>
 
+#include "flow/diff_context.h"
 #include "flow/embedded_views.h"
 #include "flow/instrumentation.h"
 #include "flow/raster_cache.h"
 #include "flow/texture.h"
 #include "flutter/fml/build_config.h"
 #include "flutter/fml/compiler_specific.h"
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/logging.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/trace_event.h"
@@ -24,6 +26,22 @@
 
 namespace uiwidgets {
 
+// What Layer::Fingerprint folds a layer tree into. The hash covers every
+// layer parameter; the unique IDs of the pictures painted by the tree, in
+// paint order, are kept as they are, so that two trees only compare equal
+// when they paint the very same pictures, whatever the hash says.
+struct LayerFingerprint {
+  size_t hash = 0;
+  std::vector<uint32_t> picture_ids;
+
+  bool operator==(const LayerFingerprint& other) const {
+    return hash == other.hash && picture_ids == other.picture_ids;
+  }
+  bool operator!=(const LayerFingerprint& other) const {
+    return !(*this == other);
+  }
+};
+
 static constexpr SkRect kGiantRect = SkRect::MakeLTRB(-1E9F, -1E9F, 1E9F, 1E9F);
 
 // This should be an exact copy of the Clip enum in painting.dart.
@@ -53,6 +71,14 @@ struct PrerollContext {
   float total_elevation = 0.0f;
   bool has_platform_view = false;
   bool is_opaque = true;
+
+  // When set, containers with many children spread the Preroll of their
+  // subtrees over the workers of this loop.
+  fml::ConcurrentMessageLoop* concurrent_message_loop = nullptr;
+
+  // Set on the contexts of a Preroll running on a worker thread. Raster cache
+  // preparations are queued here, see RasterCacheRequestQueue.
+  RasterCacheRequestQueue* raster_cache_requests = nullptr;
 };
 
 // Represents a single composited layer. Created on the UI thread but then
@@ -142,6 +168,19 @@ class Layer {
 
   virtual void Paint(PaintContext& context) const = 0;
 
+  // Describes what this layer paints for damage computation. Called after
+  // Preroll, only on layers that need painting. The default implementation
+  // makes the frame fall back to a full repaint.
+  virtual void Diff(DiffContext* context) const;
+
+  // Folds the parameters and children of this layer into |fingerprint|, so
+  // that trees built with the same layers and pictures can be recognized
+  // before rasterizing them. Returns false when the layer may paint something
+  // different without being rebuilt (platform views, live textures), in which
+  // case |fingerprint| is meaningless. The default implementation returns
+  // false.
+  virtual bool Fingerprint(LayerFingerprint* fingerprint) const;
+
   bool needs_system_composite() const { return needs_system_composite_; }
   void set_needs_system_composite(bool value) {
     needs_system_composite_ = value;
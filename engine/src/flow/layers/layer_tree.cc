@@ -16,8 +16,12 @@ LayerTree::LayerTree(const SkISize& frame_size, float frame_physical_depth,
       checkerboard_raster_cache_images_(false),
       checkerboard_offscreen_layers_(false) {}
 
-void LayerTree::RecordBuildTime(fml::TimePoint build_start,
+void LayerTree::RecordBuildTime(int64_t frame_number,
+                                fml::TimePoint vsync_start,
+                                fml::TimePoint build_start,
                                 fml::TimePoint target_time) {
+  frame_number_ = frame_number;
+  vsync_start_ = vsync_start;
   build_start_ = build_start;
   target_time_ = target_time;
   build_finish_ = fml::TimePoint::Now();
@@ -51,6 +55,7 @@ bool LayerTree::Preroll(CompositorContext::ScopedFrame& frame,
       checkerboard_offscreen_layers_,
       frame_physical_depth_,
       frame_device_pixel_ratio_};
+  context.concurrent_message_loop = frame.context().parallel_preroll_loop();
 
   root_layer_->Preroll(&context, frame.root_surface_transformation());
   return context.surface_needs_readback;
@@ -91,6 +96,24 @@ void LayerTree::Paint(CompositorContext::ScopedFrame& frame,
   if (root_layer_->needs_painting()) root_layer_->Paint(context);
 }
 
+void LayerTree::RecordDiff(const SkMatrix& root_surface_transformation,
+                           const SkISize& frame_size) {
+  TRACE_EVENT0("uiwidgets", "LayerTree::RecordDiff");
+
+  // Paint bounds of retained layers are recomputed by the Preroll of every
+  // tree they are part of, so the record has to be taken now rather than
+  // when this tree is compared against the next one.
+  diff_context_ =
+      std::make_unique<DiffContext>(root_surface_transformation, frame_size);
+  if (!root_layer_) {
+    diff_context_->MarkUnsupported();
+    return;
+  }
+  if (root_layer_->needs_painting()) {
+    root_layer_->Diff(diff_context_.get());
+  }
+}
+
 sk_sp<SkPicture> LayerTree::Flatten(const SkRect& bounds) {
   TRACE_EVENT0("uiwidgets", "LayerTree::Flatten");
 
@@ -3,6 +3,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <optional>
 
 #include "flow/compositor_context.h"
 #include "flow/layers/layer.h"
@@ -33,6 +34,15 @@ class LayerTree {
 
   sk_sp<SkPicture> Flatten(const SkRect& bounds);
 
+  // Records what this tree paints into a frame of |frame_size| for damage
+  // computation. Must be called after Preroll, which computes the paint
+  // bounds the record is made of.
+  void RecordDiff(const SkMatrix& root_surface_transformation,
+                  const SkISize& frame_size);
+
+  // The record made by RecordDiff, or null if the tree was never diffed.
+  const DiffContext* diff_context() const { return diff_context_.get(); }
+
   Layer* root_layer() const { return root_layer_.get(); }
 
   void set_root_layer(std::shared_ptr<Layer> root_layer) {
@@ -43,7 +53,12 @@ class LayerTree {
   float frame_physical_depth() const { return frame_physical_depth_; }
   float frame_device_pixel_ratio() const { return frame_device_pixel_ratio_; }
 
-  void RecordBuildTime(fml::TimePoint build_start, fml::TimePoint target_time);
+  // Records the build of this tree for frame |frame_number|, which the vsync
+  // of |vsync_start| started and whose building began at |build_start|.
+  void RecordBuildTime(int64_t frame_number, fml::TimePoint vsync_start,
+                       fml::TimePoint build_start, fml::TimePoint target_time);
+  int64_t frame_number() const { return frame_number_; }
+  fml::TimePoint vsync_start() const { return vsync_start_; }
   fml::TimePoint build_start() const { return build_start_; }
   fml::TimePoint build_finish() const { return build_finish_; }
   fml::TimeDelta build_time() const { return build_finish_ - build_start_; }
@@ -70,8 +85,22 @@ class LayerTree {
 
   double device_pixel_ratio() const { return frame_device_pixel_ratio_; }
 
+  // The fingerprint of the layers making up this tree, see
+  // Layer::Fingerprint. Unset when the tree may paint differently from
+  // another tree with the same layers.
+  void set_fingerprint(std::optional<LayerFingerprint> fingerprint) {
+    fingerprint_ = std::move(fingerprint);
+  }
+  const std::optional<LayerFingerprint>& fingerprint() const {
+    return fingerprint_;
+  }
+
  private:
   std::shared_ptr<Layer> root_layer_;
+  std::unique_ptr<DiffContext> diff_context_;
+  std::optional<LayerFingerprint> fingerprint_;
+  int64_t frame_number_ = 0;
+  fml::TimePoint vsync_start_;
   fml::TimePoint build_start_;
   fml::TimePoint build_finish_;
   fml::TimePoint target_time_;
@@ -1,5 +1,6 @@
 #include "flow/layers/opacity_layer.h"
 
+#include "flutter/fml/hash_combine.h"
 #include "flutter/fml/trace_event.h"
 #include "include/core/SkPaint.h"
 
@@ -105,4 +106,17 @@ ContainerLayer* OpacityLayer::GetChildContainer() const {
   return static_cast<ContainerLayer*>(layers()[0].get());
 }
 
+void OpacityLayer::Diff(DiffContext* context) const {
+  DiffContext::AutoSubtreeRestore subtree(context);
+  context->PushTransform(SkMatrix::MakeTrans(offset_.fX, offset_.fY));
+  context->AddState(std::hash<int>()(alpha_));
+  DiffChildren(context);
+}
+
+bool OpacityLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(
+      fingerprint->hash, static_cast<int>(alpha_), offset_.fX, offset_.fY);
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
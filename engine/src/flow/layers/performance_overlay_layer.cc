@@ -87,4 +87,8 @@ void PerformanceOverlayLayer::Paint(PaintContext& context) const {
                      options_ & kDisplayEngineStatistics, "UI", font_path_);
 }
 
+void PerformanceOverlayLayer::Diff(DiffContext* context) const {
+  context->AddVolatileLeaf(paint_bounds());
+}
+
 }  // namespace uiwidgets
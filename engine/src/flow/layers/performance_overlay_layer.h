@@ -25,6 +25,7 @@ class PerformanceOverlayLayer : public Layer {
                                    const char* font_path = nullptr);
 
   void Paint(PaintContext& context) const override;
+  void Diff(DiffContext* context) const override;
 
  private:
   int options_;
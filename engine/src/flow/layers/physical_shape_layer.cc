@@ -1,6 +1,7 @@
 #include "flow/layers/physical_shape_layer.h"
 
 #include "flow/paint_utils.h"
+#include "flutter/fml/hash_combine.h"
 #include "include/utils/SkShadowUtils.h"
 
 namespace uiwidgets {
@@ -176,4 +177,28 @@ void PhysicalShapeLayer::DrawShadow(SkCanvas* canvas, const SkPath& path,
       dpr * kLightRadius, ambientColor, spotColor, flags);
 }
 
+void PhysicalShapeLayer::Diff(DiffContext* context) const {
+  // The shadow depends on the whole shape, so the layer is diffed as a whole.
+  size_t group_start = context->BeginGroup();
+  {
+    DiffContext::AutoSubtreeRestore subtree(context);
+    if (clip_behavior_ != Clip::none) {
+      context->ClipRect(path_.getBounds());
+    }
+    DiffChildren(context);
+  }
+  context->EndGroup(
+      group_start, paint_bounds(),
+      fml::HashCombine(color_, shadow_color_, elevation_,
+                       DiffContext::HashPath(path_),
+                       static_cast<int>(clip_behavior_)));
+}
+
+bool PhysicalShapeLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(
+      fingerprint->hash, color_, shadow_color_, elevation_,
+      DiffContext::HashPath(path_), static_cast<int>(clip_behavior_));
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
@@ -1,5 +1,6 @@
 #include "flow/layers/picture_layer.h"
 
+#include "flutter/fml/hash_combine.h"
 #include "flutter/fml/logging.h"
 
 namespace uiwidgets {
@@ -24,8 +25,7 @@ void PictureLayer::Preroll(PrerollContext* context, const SkMatrix& matrix) {
 #ifndef SUPPORT_FRACTIONAL_TRANSLATION
     ctm = RasterCache::GetIntegralTransCTM(ctm);
 #endif
-    cache->Prepare(context->gr_context, sk_picture, ctm,
-                   context->dst_color_space, is_complex_, will_change_);
+    cache->Prepare(context, sk_picture, ctm, is_complex_, will_change_);
   }
 
   SkRect bounds = sk_picture->cullRect().makeOffset(offset_.x(), offset_.y());
@@ -57,4 +57,17 @@ void PictureLayer::Paint(PaintContext& context) const {
   picture()->playback(context.leaf_nodes_canvas);
 }
 
+void PictureLayer::Diff(DiffContext* context) const {
+  context->AddLeaf(paint_bounds(), fml::HashCombine(picture()->uniqueID(),
+                                                    offset_.x(), offset_.y()));
+}
+
+bool PictureLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(
+      fingerprint->hash, picture()->uniqueID(), offset_.x(), offset_.y(),
+      is_complex_, will_change_);
+  fingerprint->picture_ids.push_back(picture()->uniqueID());
+  return true;
+}
+
 }  // namespace uiwidgets
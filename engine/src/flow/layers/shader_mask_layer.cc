@@ -1,5 +1,7 @@
 #include "flow/layers/shader_mask_layer.h"
 
+#include "flutter/fml/hash_combine.h"
+
 namespace uiwidgets {
 
 ShaderMaskLayer::ShaderMaskLayer(sk_sp<SkShader> shader,
@@ -29,4 +31,20 @@ void ShaderMaskLayer::Paint(PaintContext& context) const {
       SkRect::MakeWH(mask_rect_.width(), mask_rect_.height()), paint);
 }
 
+void ShaderMaskLayer::Diff(DiffContext* context) const {
+  size_t group_start = context->BeginGroup();
+  DiffChildren(context);
+  context->EndGroup(
+      group_start, paint_bounds(),
+      fml::HashCombine(shader_.get(), DiffContext::HashRect(mask_rect_),
+                       static_cast<int>(blend_mode_)));
+}
+
+bool ShaderMaskLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  fingerprint->hash = fml::HashCombine(
+      fingerprint->hash, shader_.get(), DiffContext::HashRect(mask_rect_),
+      static_cast<int>(blend_mode_));
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
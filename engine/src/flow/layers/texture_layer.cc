@@ -1,6 +1,7 @@
 #include "flow/layers/texture_layer.h"
 
 #include "flow/texture.h"
+#include "flutter/fml/hash_combine.h"
 
 namespace uiwidgets {
 
@@ -28,4 +29,26 @@ void TextureLayer::Paint(PaintContext& context) const {
                  context.gr_context);
 }
 
+void TextureLayer::Diff(DiffContext* context) const {
+  // Unless frozen, the texture may have received a new frame without the
+  // layer tree changing.
+  if (freeze_) {
+    context->AddLeaf(paint_bounds(), std::hash<int64_t>()(texture_id_));
+  } else {
+    context->AddVolatileLeaf(paint_bounds());
+  }
+}
+
+bool TextureLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  // External textures are not required to report new frames, so only a
+  // frozen texture is known to show the same content as before.
+  if (!freeze_) {
+    return false;
+  }
+  fingerprint->hash = fml::HashCombine(
+      fingerprint->hash, texture_id_, offset_.x(), offset_.y(), size_.width(),
+      size_.height());
+  return true;
+}
+
 }  // namespace uiwidgets
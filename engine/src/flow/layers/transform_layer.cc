@@ -1,5 +1,7 @@
 #include "flow/layers/transform_layer.h"
 
+#include "flutter/fml/hash_combine.h"
+
 namespace uiwidgets {
 
 TransformLayer::TransformLayer(const SkMatrix& transform)
@@ -56,4 +58,17 @@ void TransformLayer::Paint(PaintContext& context) const {
   PaintChildren(context);
 }
 
+void TransformLayer::Diff(DiffContext* context) const {
+  DiffContext::AutoSubtreeRestore subtree(context);
+  context->PushTransform(transform_);
+  DiffChildren(context);
+}
+
+bool TransformLayer::Fingerprint(LayerFingerprint* fingerprint) const {
+  for (int i = 0; i < 9; i++) {
+    fingerprint->hash = fml::HashCombine(fingerprint->hash, transform_[i]);
+  }
+  return ContainerLayer::Fingerprint(fingerprint);
+}
+
 }  // namespace uiwidgets
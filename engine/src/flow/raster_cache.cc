@@ -1,10 +1,12 @@
 #include "flow/raster_cache.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "flow/layers/layer.h"
 #include "flow/paint_utils.h"
 #include "flutter/fml/logging.h"
+#include "flutter/fml/time/time_point.h"
 #include "flutter/fml/trace_event.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkImage.h"
@@ -134,12 +136,62 @@ RasterCacheResult RasterizePicture(SkPicture* picture, GrContext* context,
                    [=](SkCanvas* canvas) { canvas->drawPicture(picture); });
 }
 
+RasterCacheRequestQueue::RasterCacheRequestQueue() = default;
+
+RasterCacheRequestQueue::~RasterCacheRequestQueue() = default;
+
+void RasterCacheRequestQueue::PreparePicture(
+    SkPicture* picture, const SkMatrix& transformation_matrix, bool is_complex,
+    bool will_change) {
+  requests_.push_back(
+      {picture, nullptr, transformation_matrix, is_complex, will_change});
+}
+
+void RasterCacheRequestQueue::PrepareLayer(Layer* layer, const SkMatrix& ctm) {
+  requests_.push_back({nullptr, layer, ctm, false, false});
+}
+
+void RasterCacheRequestQueue::Replay(PrerollContext* context) {
+  FML_DCHECK(context->raster_cache);
+  FML_DCHECK(context->raster_cache_requests == nullptr);
+  // Layers only request caching when no platform view was found below them.
+  const bool has_platform_view = context->has_platform_view;
+  context->has_platform_view = false;
+  for (const Request& request : requests_) {
+    if (request.picture) {
+      context->raster_cache->Prepare(
+          context->gr_context, request.picture, request.matrix,
+          context->dst_color_space, request.is_complex, request.will_change);
+    } else {
+      context->raster_cache->Prepare(context, request.layer, request.matrix);
+    }
+  }
+  context->has_platform_view = has_platform_view;
+  requests_.clear();
+}
+
+void RasterCache::Prepare(PrerollContext* context, SkPicture* picture,
+                          const SkMatrix& transformation_matrix,
+                          bool is_complex, bool will_change) {
+  if (context->raster_cache_requests) {
+    context->raster_cache_requests->PreparePicture(
+        picture, transformation_matrix, is_complex, will_change);
+    return;
+  }
+  Prepare(context->gr_context, picture, transformation_matrix,
+          context->dst_color_space, is_complex, will_change);
+}
+
 void RasterCache::Prepare(PrerollContext* context, Layer* layer,
                           const SkMatrix& ctm) {
+  if (context->raster_cache_requests) {
+    context->raster_cache_requests->PrepareLayer(layer, ctm);
+    return;
+  }
   LayerRasterCacheKey cache_key(layer->unique_id(), ctm);
-  Entry& entry = layer_cache_[cache_key];
+  Entry& entry = FindOrCreateEntry(layer_cache_, layer_variants_, cache_key);
   entry.access_count++;
-  entry.used_this_frame = true;
+  entry.last_used_frame = current_frame_;
   if (!entry.image.is_valid()) {
     entry.image = Rasterize(
         context->gr_context, ctm, context->dst_color_space,
@@ -196,13 +248,25 @@ bool RasterCache::Prepare(GrContext* context, SkPicture* picture,
   PictureRasterCacheKey cache_key(picture->uniqueID(), transformation_matrix);
 
   // Creates an entry, if not present prior.
-  Entry& entry = picture_cache_[cache_key];
+  Entry& entry =
+      FindOrCreateEntry(picture_cache_, picture_variants_, cache_key);
+  entry.last_used_frame = current_frame_;
   if (entry.access_count < access_threshold_) {
     // Frame threshold has not yet been reached.
     return false;
   }
 
   if (!entry.image.is_valid()) {
+    if (deferred_population_) {
+      if (!entry.population_pending) {
+        entry.population_pending = true;
+        pending_pictures_.push_back({cache_key, sk_ref_sp(picture),
+                                     transformation_matrix,
+                                     sk_ref_sp(dst_color_space)});
+      }
+      // Keep drawing the picture until the cached image is ready.
+      return false;
+    }
     entry.image = RasterizePicture(picture, context, transformation_matrix,
                                    dst_color_space, checkerboard_images_);
     picture_cached_this_frame_++;
@@ -210,17 +274,69 @@ bool RasterCache::Prepare(GrContext* context, SkPicture* picture,
   return true;
 }
 
+void RasterCache::SetDeferredPopulation(bool deferred) {
+  deferred_population_ = deferred;
+  if (!deferred) {
+    for (auto& item : picture_cache_) {
+      item.second.population_pending = false;
+    }
+    pending_pictures_.clear();
+  }
+}
+
+size_t RasterCache::PopulatePending(GrContext* context,
+                                    fml::TimeDelta time_budget) {
+  if (pending_pictures_.empty()) {
+    return 0;
+  }
+  TRACE_EVENT0("uiwidgets", "RasterCache::PopulatePending");
+
+  const fml::TimePoint deadline = fml::TimePoint::Now() + time_budget;
+  size_t populated = 0;
+  size_t consumed = 0;
+  for (; consumed < pending_pictures_.size(); consumed++) {
+    if (populated > 0 && (populated >= picture_cache_limit_per_frame_ ||
+                          fml::TimePoint::Now() >= deadline)) {
+      break;
+    }
+    PendingPicture& pending = pending_pictures_[consumed];
+    auto it = picture_cache_.find(pending.key);
+    if (it == picture_cache_.end()) {
+      // The entry was evicted while the job was pending.
+      continue;
+    }
+    Entry& entry = it->second;
+    entry.population_pending = false;
+    if (entry.image.is_valid()) {
+      continue;
+    }
+    entry.image =
+        RasterizePicture(pending.picture.get(), context, pending.matrix,
+                         pending.dst_color_space.get(), checkerboard_images_);
+    populated++;
+  }
+  pending_pictures_.erase(pending_pictures_.begin(),
+                          pending_pictures_.begin() + consumed);
+  return populated;
+}
+
 RasterCacheResult RasterCache::Get(const SkPicture& picture,
                                    const SkMatrix& ctm) const {
   PictureRasterCacheKey cache_key(picture.uniqueID(), ctm);
   auto it = picture_cache_.find(cache_key);
   if (it == picture_cache_.end()) {
+    miss_count_++;
     return RasterCacheResult();
   }
 
   Entry& entry = it->second;
   entry.access_count++;
-  entry.used_this_frame = true;
+  entry.last_used_frame = current_frame_;
+  if (entry.image.is_valid()) {
+    hit_count_++;
+  } else {
+    miss_count_++;
+  }
 
   return entry.image;
 }
@@ -229,32 +345,92 @@ RasterCacheResult RasterCache::Get(Layer* layer, const SkMatrix& ctm) const {
   LayerRasterCacheKey cache_key(layer->unique_id(), ctm);
   auto it = layer_cache_.find(cache_key);
   if (it == layer_cache_.end()) {
+    miss_count_++;
     return RasterCacheResult();
   }
 
   Entry& entry = it->second;
   entry.access_count++;
-  entry.used_this_frame = true;
+  entry.last_used_frame = current_frame_;
+  if (entry.image.is_valid()) {
+    hit_count_++;
+  } else {
+    miss_count_++;
+  }
 
   return entry.image;
 }
 
 void RasterCache::SweepAfterFrame() {
-  SweepOneCacheAfterFrame(picture_cache_);
-  SweepOneCacheAfterFrame(layer_cache_);
+  size_t cached_bytes =
+      SweepOneCacheAfterFrame(picture_cache_, picture_variants_) +
+      SweepOneCacheAfterFrame(layer_cache_, layer_variants_);
+
+  if (cached_bytes > max_bytes_) {
+    TRACE_EVENT0("uiwidgets", "RasterCache::EvictUnderPressure");
+    auto pictures = CollectEvictionCandidates(picture_cache_);
+    auto layers = CollectEvictionCandidates(layer_cache_);
+    auto picture = pictures.begin();
+    auto layer = layers.begin();
+    while (cached_bytes > max_bytes_ &&
+           (picture != pictures.end() || layer != layers.end())) {
+      bool evict_picture = layer == layers.end() ||
+                           (picture != pictures.end() &&
+                            picture->first <= layer->first);
+      if (evict_picture) {
+        cached_bytes -= picture->second->second.image_bytes();
+        EraseEntry(picture_cache_, picture_variants_, picture->second);
+        ++picture;
+      } else {
+        cached_bytes -= layer->second->second.image_bytes();
+        EraseEntry(layer_cache_, layer_variants_, layer->second);
+        ++layer;
+      }
+    }
+  }
+
+  current_frame_++;
   picture_cached_this_frame_ = 0;
+  last_frame_hit_count_ = hit_count_;
+  last_frame_miss_count_ = miss_count_;
+  hit_count_ = 0;
+  miss_count_ = 0;
   TraceStatsToTimeline();
 }
 
 void RasterCache::Clear() {
   picture_cache_.clear();
   layer_cache_.clear();
+  picture_variants_.clear();
+  layer_variants_.clear();
+  pending_pictures_.clear();
+}
+
+void RasterCache::SetRetentionPolicy(size_t max_bytes,
+                                     size_t max_unused_frames) {
+  max_bytes_ = max_bytes;
+  max_unused_frames_ = std::max<size_t>(max_unused_frames, 1);
+}
+
+void RasterCache::SetMaxVariantsPerID(size_t max_variants_per_id) {
+  max_variants_per_id_ = std::max<size_t>(max_variants_per_id, 1);
 }
 
 size_t RasterCache::GetCachedEntriesCount() const {
   return layer_cache_.size() + picture_cache_.size();
 }
 
+size_t RasterCache::GetCachedBytes() const {
+  size_t bytes = 0;
+  for (const auto& item : layer_cache_) {
+    bytes += item.second.image_bytes();
+  }
+  for (const auto& item : picture_cache_) {
+    bytes += item.second.image_bytes();
+  }
+  return bytes;
+}
+
 void RasterCache::SetCheckboardCacheImages(bool checkerboard) {
   if (checkerboard_images_ == checkerboard) {
     return;
@@ -276,15 +452,13 @@ void RasterCache::TraceStatsToTimeline() const {
   size_t picture_cache_bytes = 0;
 
   for (const auto& item : layer_cache_) {
-    const auto dimensions = item.second.image.image_dimensions();
     layer_cache_count++;
-    layer_cache_bytes += dimensions.width() * dimensions.height() * 4;
+    layer_cache_bytes += item.second.image_bytes();
   }
 
   for (const auto& item : picture_cache_) {
-    const auto dimensions = item.second.image.image_dimensions();
     picture_cache_count++;
-    picture_cache_bytes += dimensions.width() * dimensions.height() * 4;
+    picture_cache_bytes += item.second.image_bytes();
   }
 
   FML_TRACE_COUNTER("uiwidgets", "RasterCache",
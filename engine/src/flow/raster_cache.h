@@ -1,13 +1,19 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "flow/instrumentation.h"
 #include "flow/raster_cache_key.h"
+#include "flutter/fml/logging.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/memory/weak_ptr.h"
+#include "flutter/fml/time/time_delta.h"
 #include "include/core/SkImage.h"
+#include "include/core/SkPicture.h"
 #include "include/core/SkSize.h"
 
 namespace uiwidgets {
@@ -37,6 +43,40 @@ class RasterCacheResult {
 
 struct PrerollContext;
 
+// Raster cache preparations requested by a Preroll running on a worker
+// thread. The raster cache and the GrContext may only be used on the raster
+// thread, so the requests are recorded here and replayed there, in the order
+// they were made, once the parallel Preroll has been joined.
+class RasterCacheRequestQueue {
+ public:
+  RasterCacheRequestQueue();
+
+  ~RasterCacheRequestQueue();
+
+  void PreparePicture(SkPicture* picture, const SkMatrix& transformation_matrix,
+                      bool is_complex, bool will_change);
+
+  void PrepareLayer(Layer* layer, const SkMatrix& ctm);
+
+  // Forwards the requests to the raster cache of |context|, which must be the
+  // PrerollContext of the raster thread.
+  void Replay(PrerollContext* context);
+
+ private:
+  struct Request {
+    // Exactly one of |picture| and |layer| is set.
+    SkPicture* picture;
+    Layer* layer;
+    SkMatrix matrix;
+    bool is_complex;
+    bool will_change;
+  };
+
+  std::vector<Request> requests_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(RasterCacheRequestQueue);
+};
+
 class RasterCache {
  public:
   // The default max number of picture raster caches to be generated per frame.
@@ -45,6 +85,16 @@ class RasterCache {
   // multiple frames.
   static constexpr int kDefaultPictureCacheLimitPerFrame = 3;
 
+  // The default byte budget and number of frames an entry is kept around
+  // after its last use. See |SetRetentionPolicy|.
+  static constexpr size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+  static constexpr size_t kDefaultMaxUnusedFrames = 30;
+
+  // The max number of transforms a single picture or layer is cached at.
+  // Animated scales and rotations create a new entry on every frame, so the
+  // least recently used transform of an ID is evicted beyond this limit.
+  static constexpr size_t kDefaultMaxVariantsPerID = 4;
+
   explicit RasterCache(
       size_t access_threshold = 3,
       size_t picture_cache_limit_per_frame = kDefaultPictureCacheLimitPerFrame);
@@ -77,49 +127,189 @@ class RasterCache {
                SkColorSpace* dst_color_space, bool is_complex,
                bool will_change);
 
+  // Prepares |picture| with the GrContext and color space of |context|. When
+  // |context| belongs to a Preroll running on a worker thread, the request is
+  // queued on its |raster_cache_requests| instead.
+  void Prepare(PrerollContext* context, SkPicture* picture,
+               const SkMatrix& transformation_matrix, bool is_complex,
+               bool will_change);
+
   void Prepare(PrerollContext* context, Layer* layer, const SkMatrix& ctm);
 
+  // When deferred population is enabled, pictures that cross the access
+  // threshold during Preroll are not rasterized right away. A population job
+  // is recorded instead and the frame keeps drawing the picture directly until
+  // |PopulatePending| has produced the cached image. Layers are always cached
+  // synchronously since they need the PrerollContext of the frame.
+  void SetDeferredPopulation(bool deferred);
+
+  bool HasPendingPopulation() const { return !pending_pictures_.empty(); }
+
+  // Rasterizes pending pictures until |time_budget| is used up (at least one
+  // picture is rasterized per call) and returns the number of cached pictures.
+  // Called on the raster thread after the frame was submitted, with
+  // |context| current.
+  size_t PopulatePending(GrContext* context, fml::TimeDelta time_budget);
+
   RasterCacheResult Get(const SkPicture& picture, const SkMatrix& ctm) const;
 
   RasterCacheResult Get(Layer* layer, const SkMatrix& ctm) const;
 
+  // Evicts entries that have not been used for |max_unused_frames_| frames.
+  // If the remaining entries exceed the byte budget, the least recently used
+  // entries that were not used in this frame are evicted until the cache fits
+  // the budget again.
   void SweepAfterFrame();
 
   void Clear();
 
+  // Entries that are not used in a frame are kept for up to
+  // |max_unused_frames| frames so that content that leaves the screen briefly
+  // does not have to be rasterized again, as long as the cached images stay
+  // within |max_bytes|. A |max_unused_frames| of 1 evicts every entry that was
+  // not used in the last frame.
+  void SetRetentionPolicy(size_t max_bytes, size_t max_unused_frames);
+
+  void SetMaxVariantsPerID(size_t max_variants_per_id);
+
   void SetCheckboardCacheImages(bool checkerboard);
 
   size_t GetCachedEntriesCount() const;
 
+  size_t GetCachedBytes() const;
+
+  // The number of lookups made by Get during the last swept frame that
+  // returned a cached image, and that did not.
+  size_t GetLastFrameHitCount() const { return last_frame_hit_count_; }
+  size_t GetLastFrameMissCount() const { return last_frame_miss_count_; }
+
  private:
   struct Entry {
-    bool used_this_frame = false;
+    size_t last_used_frame = 0;
     size_t access_count = 0;
+    bool population_pending = false;
     RasterCacheResult image;
+
+    size_t image_bytes() const {
+      const auto dimensions = image.image_dimensions();
+      return dimensions.width() * dimensions.height() * 4;
+    }
   };
 
-  template <class Cache>
-  static void SweepOneCacheAfterFrame(Cache& cache) {
-    std::vector<typename Cache::iterator> dead;
+  // Returns the entry for |key|, creating it if needed. When the ID of |key|
+  // is already cached at |max_variants_per_id_| transforms, the least
+  // recently used of them is evicted first, unless all of them were used in
+  // the current frame, whose Paint may still look them up.
+  template <class Cache, class Index>
+  Entry& FindOrCreateEntry(Cache& cache, Index& index,
+                           const typename Cache::key_type& key) {
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+      return it->second;
+    }
+    auto& variants = index[key.id()];
+    if (variants.size() >= max_variants_per_id_) {
+      auto lru = variants.end();
+      size_t lru_frame = current_frame_;
+      for (auto variant = variants.begin(); variant != variants.end();
+           ++variant) {
+        size_t last_used_frame = cache.at(*variant).last_used_frame;
+        if (last_used_frame < lru_frame) {
+          lru = variant;
+          lru_frame = last_used_frame;
+        }
+      }
+      if (lru != variants.end()) {
+        cache.erase(*lru);
+        variants.erase(lru);
+      }
+    }
+    variants.push_back(key);
+    return cache[key];
+  }
 
-    for (auto it = cache.begin(); it != cache.end(); ++it) {
-      Entry& entry = it->second;
-      if (!entry.used_this_frame) {
-        dead.push_back(it);
+  template <class Cache, class Index>
+  static typename Cache::iterator EraseEntry(Cache& cache, Index& index,
+                                             typename Cache::iterator it) {
+    auto variants = index.find(it->first.id());
+    FML_DCHECK(variants != index.end());
+    if (variants != index.end()) {
+      auto& keys = variants->second;
+      typename Cache::key_equal equal;
+      auto key = std::find_if(
+          keys.begin(), keys.end(),
+          [&](const auto& candidate) { return equal(candidate, it->first); });
+      FML_DCHECK(key != keys.end());
+      if (key != keys.end()) {
+        keys.erase(key);
+      }
+      if (keys.empty()) {
+        index.erase(variants);
+      }
+    }
+    return cache.erase(it);
+  }
+
+  // Drops the entries that are too old and returns the bytes held by the
+  // remaining ones.
+  template <class Cache, class Index>
+  size_t SweepOneCacheAfterFrame(Cache& cache, Index& index) {
+    size_t bytes = 0;
+    for (auto it = cache.begin(); it != cache.end();) {
+      const Entry& entry = it->second;
+      if (current_frame_ - entry.last_used_frame >= max_unused_frames_) {
+        it = EraseEntry(cache, index, it);
+      } else {
+        bytes += entry.image_bytes();
+        ++it;
       }
-      entry.used_this_frame = false;
     }
+    return bytes;
+  }
 
-    for (auto it : dead) {
-      cache.erase(it);
+  // Returns the entries that may be evicted under memory pressure, i.e. the
+  // ones holding an image that were not used in the current frame, least
+  // recently used first.
+  template <class Cache>
+  std::vector<std::pair<size_t, typename Cache::iterator>>
+  CollectEvictionCandidates(Cache& cache) const {
+    std::vector<std::pair<size_t, typename Cache::iterator>> candidates;
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+      const Entry& entry = it->second;
+      if (entry.last_used_frame != current_frame_ && entry.image.is_valid()) {
+        candidates.emplace_back(entry.last_used_frame, it);
+      }
     }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return candidates;
   }
 
   const size_t access_threshold_;
   const size_t picture_cache_limit_per_frame_;
   size_t picture_cached_this_frame_ = 0;
+  size_t max_bytes_ = kDefaultMaxBytes;
+  size_t max_unused_frames_ = kDefaultMaxUnusedFrames;
+  size_t max_variants_per_id_ = kDefaultMaxVariantsPerID;
+  bool deferred_population_ = false;
+  struct PendingPicture {
+    PictureRasterCacheKey key;
+    sk_sp<SkPicture> picture;
+    SkMatrix matrix;
+    sk_sp<SkColorSpace> dst_color_space;
+  };
+  std::vector<PendingPicture> pending_pictures_;
+  // Starts at 1 so that new entries are never considered used in a frame
+  // before they are actually accessed.
+  size_t current_frame_ = 1;
+  mutable size_t hit_count_ = 0;
+  mutable size_t miss_count_ = 0;
+  size_t last_frame_hit_count_ = 0;
+  size_t last_frame_miss_count_ = 0;
   mutable PictureRasterCacheKey::Map<Entry> picture_cache_;
   mutable LayerRasterCacheKey::Map<Entry> layer_cache_;
+  PictureRasterCacheKey::IDIndex picture_variants_;
+  LayerRasterCacheKey::IDIndex layer_variants_;
   bool checkerboard_images_;
 
   void TraceStatsToTimeline() const;
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cmath>
+#include <functional>
 #include <unordered_map>
+#include <vector>
 
 #include "flow/matrix_decomposition.h"
 #include "flutter/fml/logging.h"
@@ -21,9 +24,18 @@ class RasterCacheKey {
   ID id() const { return id_; }
   const SkMatrix& matrix() const { return matrix_; }
 
+  // Hashes the ID together with the matrix so that the same ID cached at
+  // several scales or rotations does not end up in a single bucket chain.
+  // Matrix values are quantized before hashing so that values comparing equal
+  // (such as 0 and -0) always hash the same.
   struct Hash {
-    uint32_t operator()(RasterCacheKey const& key) const {
-      return std::hash<ID>()(key.id_);
+    size_t operator()(RasterCacheKey const& key) const {
+      size_t hash = std::hash<ID>()(key.id_);
+      for (int i = 0; i < 9; i++) {
+        int64_t value = Quantize(key.matrix_[i]);
+        hash = CombineHash(hash, std::hash<int64_t>()(value));
+      }
+      return hash;
     }
   };
 
@@ -37,7 +49,23 @@ class RasterCacheKey {
   template <class Value>
   using Map = std::unordered_map<RasterCacheKey, Value, Hash, Equal>;
 
+  // Secondary index from an ID to all of the keys it is cached with.
+  using IDIndex = std::unordered_map<ID, std::vector<RasterCacheKey>>;
+
  private:
+  static constexpr SkScalar kHashQuantization = 1024;
+
+  static int64_t Quantize(SkScalar value) {
+    if (!SkScalarIsFinite(value)) {
+      return 0;
+    }
+    return static_cast<int64_t>(std::round(value * kHashQuantization));
+  }
+
+  static size_t CombineHash(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+  }
+
   ID id_;
 
   // ctm where only fractional (0-1) translations are preserved:
@@ -65,6 +65,8 @@ class SkiaGPUObject {
 
   sk_sp<SkiaObjectType> get() const { return object_; }
 
+  fml::RefPtr<SkiaUnrefQueue> queue() const { return queue_; }
+
   void reset() {
     if (object_ && queue_) {
       queue_->Unref(object_.release());
@@ -11,16 +11,19 @@ namespace uiwidgets {
 fml::RefPtr<Scene> Scene::create(std::shared_ptr<Layer> rootLayer,
                                  uint32_t rasterizerTracingThreshold,
                                  bool checkerboardRasterCacheImages,
-                                 bool checkerboardOffscreenLayers) {
+                                 bool checkerboardOffscreenLayers,
+                                 std::optional<LayerFingerprint> fingerprint) {
   return fml::MakeRefCounted<Scene>(
       std::move(rootLayer), rasterizerTracingThreshold,
-      checkerboardRasterCacheImages, checkerboardOffscreenLayers);
+      checkerboardRasterCacheImages, checkerboardOffscreenLayers,
+      std::move(fingerprint));
 }
 
 Scene::Scene(std::shared_ptr<Layer> rootLayer,
              uint32_t rasterizerTracingThreshold,
              bool checkerboardRasterCacheImages,
-             bool checkerboardOffscreenLayers) {
+             bool checkerboardOffscreenLayers,
+             std::optional<LayerFingerprint> fingerprint) {
   auto viewport_metrics = UIMonoState::Current()->window()->viewport_metrics();
 
   layer_tree_ = std::make_unique<LayerTree>(
@@ -33,6 +36,7 @@ Scene::Scene(std::shared_ptr<Layer> rootLayer,
   layer_tree_->set_checkerboard_raster_cache_images(
       checkerboardRasterCacheImages);
   layer_tree_->set_checkerboard_offscreen_layers(checkerboardOffscreenLayers);
+  layer_tree_->set_fingerprint(std::move(fingerprint));
 }
 
 Scene::~Scene() {}
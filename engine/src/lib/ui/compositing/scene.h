@@ -3,6 +3,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <optional>
 
 #include "flow/layers/layer_tree.h"
 #include "lib/ui/painting/picture.h"
@@ -17,7 +18,8 @@ class Scene : public fml::RefCountedThreadSafe<Scene> {
   static fml::RefPtr<Scene> create(std::shared_ptr<Layer> rootLayer,
                                    uint32_t rasterizerTracingThreshold,
                                    bool checkerboardRasterCacheImages,
-                                   bool checkerboardOffscreenLayers);
+                                   bool checkerboardOffscreenLayers,
+                                   std::optional<LayerFingerprint> fingerprint);
 
   std::unique_ptr<LayerTree> takeLayerTree();
 
@@ -31,7 +33,8 @@ class Scene : public fml::RefCountedThreadSafe<Scene> {
   explicit Scene(std::shared_ptr<Layer> rootLayer,
                  uint32_t rasterizerTracingThreshold,
                  bool checkerboardRasterCacheImages,
-                 bool checkerboardOffscreenLayers);
+                 bool checkerboardOffscreenLayers,
+                 std::optional<LayerFingerprint> fingerprint);
 
   std::unique_ptr<LayerTree> layer_tree_;
 };
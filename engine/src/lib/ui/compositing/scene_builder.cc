@@ -18,6 +18,8 @@
 #include "flow/layers/shader_mask_layer.h"
 #include "flow/layers/texture_layer.h"
 #include "flow/layers/transform_layer.h"
+#include "flutter/fml/hash_combine.h"
+#include "flutter/fml/trace_event.h"
 #include "include/core/SkColorFilter.h"
 #include "lib/ui/painting/matrix.h"
 #include "lib/ui/painting/shader.h"
@@ -174,9 +176,22 @@ void SceneBuilder::setCheckerboardOffscreenLayers(bool checkerboard) {
 fml::RefPtr<Scene> SceneBuilder::build() {
   FML_DCHECK(layer_stack_.size() >= 1);
 
+  std::optional<LayerFingerprint> fingerprint;
+  {
+    TRACE_EVENT0("uiwidgets", "SceneBuilder::Fingerprint");
+    LayerFingerprint layers;
+    layers.hash = fml::HashCombine(rasterizer_tracing_threshold_,
+                                   checkerboard_raster_cache_images_,
+                                   checkerboard_offscreen_layers_);
+    if (layer_stack_[0]->Fingerprint(&layers)) {
+      fingerprint = std::move(layers);
+    }
+  }
+
   return Scene::create(layer_stack_[0], rasterizer_tracing_threshold_,
                        checkerboard_raster_cache_images_,
-                       checkerboard_offscreen_layers_);
+                       checkerboard_offscreen_layers_,
+                       std::move(fingerprint));
 }
 
 void SceneBuilder::AddLayer(std::shared_ptr<Layer> layer) {
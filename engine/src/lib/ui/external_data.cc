@@ -0,0 +1,68 @@
+#include "external_data.h"
+
+#include "flutter/fml/file.h"
+#include "flutter/fml/make_copyable.h"
+#include "lib/ui/ui_mono_state.h"
+#include "runtime/mono_state.h"
+
+namespace uiwidgets {
+
+namespace {
+
+struct ExternalData {
+  std::weak_ptr<MonoState> mono_state;
+  fml::RefPtr<fml::TaskRunner> ui_task_runner;
+  ReleaseExternalDataCallback release_callback;
+  Mono_Handle release_handle;
+};
+
+void ReleaseExternalData(const void* ptr, void* context) {
+  std::unique_ptr<ExternalData> data(static_cast<ExternalData*>(context));
+  fml::RefPtr<fml::TaskRunner> ui_task_runner = data->ui_task_runner;
+  fml::TaskRunner::RunNowOrPostTask(
+      ui_task_runner, fml::MakeCopyable([data = std::move(data)]() {
+        std::shared_ptr<MonoState> mono_state = data->mono_state.lock();
+        if (!mono_state) {
+          return;
+        }
+        MonoState::Scope scope(mono_state);
+        data->release_callback(data->release_handle);
+      }));
+}
+
+void MappingReleaseProc(const void* ptr, void* context) {
+  delete reinterpret_cast<fml::Mapping*>(context);
+}
+
+}  // namespace
+
+sk_sp<SkData> MakeSkDataFromExternalBuffer(
+    const void* data, size_t size,
+    ReleaseExternalDataCallback release_callback, Mono_Handle release_handle) {
+  auto* context = new ExternalData{
+      MonoState::Current()->GetWeakPtr(),
+      UIMonoState::Current()->GetTaskRunners().GetUITaskRunner(),
+      release_callback, release_handle};
+  return SkData::MakeWithProc(data, size, ReleaseExternalData, context);
+}
+
+sk_sp<SkData> MakeSkDataFromMapping(std::unique_ptr<fml::Mapping> mapping) {
+  if (!mapping || mapping->GetSize() == 0) {
+    return nullptr;
+  }
+  const uint8_t* bytes = mapping->GetMapping();
+  const size_t size = mapping->GetSize();
+  return SkData::MakeWithProc(bytes, size, MappingReleaseProc,
+                              mapping.release());
+}
+
+sk_sp<SkData> MakeSkDataFromFile(const std::string& path) {
+  auto mapping = std::make_unique<fml::FileMapping>(
+      fml::OpenFile(path.c_str(), false, fml::FilePermission::kRead));
+  if (!mapping->IsValid()) {
+    return nullptr;
+  }
+  return MakeSkDataFromMapping(std::move(mapping));
+}
+
+}  // namespace uiwidgets
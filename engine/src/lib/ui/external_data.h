@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "flutter/fml/mapping.h"
+#include "include/core/SkData.h"
+#include "runtime/mono_api.h"
+
+namespace uiwidgets {
+
+typedef void (*ReleaseExternalDataCallback)(Mono_Handle release_handle);
+
+// Wraps a buffer owned by managed code without copying it. The buffer must
+// stay pinned until |release_callback| is called, which happens on the UI
+// thread once the returned data is destroyed, possibly on another thread.
+// Must be called on the UI thread.
+sk_sp<SkData> MakeSkDataFromExternalBuffer(
+    const void* data, size_t size,
+    ReleaseExternalDataCallback release_callback, Mono_Handle release_handle);
+
+// Wraps |mapping|, which is destroyed with the returned data. Returns null if
+// the mapping is missing or empty.
+sk_sp<SkData> MakeSkDataFromMapping(std::unique_ptr<fml::Mapping> mapping);
+
+// Maps the file at |path| into memory. Returns null if it can not be mapped.
+sk_sp<SkData> MakeSkDataFromFile(const std::string& path);
+
+}  // namespace uiwidgets
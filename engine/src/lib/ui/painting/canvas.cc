@@ -2,8 +2,12 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <string.h>
+
+#include <vector>
 
 #include "flow/layers/physical_shape_layer.h"
+#include "flutter/fml/trace_event.h"
 #include "image.h"
 #include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
@@ -184,6 +188,28 @@ void Canvas::drawImageRect(const CanvasImage* image, float src_left,
                          SkCanvas::kFast_SrcRectConstraint);
 }
 
+void Canvas::drawTiledImageRect(TiledImage* image, float src_left,
+                                float src_top, float src_right,
+                                float src_bottom, float dst_left,
+                                float dst_top, float dst_right,
+                                float dst_bottom, const Paint& paint) {
+  if (!canvas_) return;
+  if (!image)
+    Mono_ThrowException(
+        "Canvas.drawTiledImageRect called with non-genuine TiledImage.");
+  SkRect src = SkRect::MakeLTRB(src_left, src_top, src_right, src_bottom);
+  SkRect dst = SkRect::MakeLTRB(dst_left, dst_top, dst_right, dst_bottom);
+  SkPaint sk_paint;
+  if (paint.paint()) {
+    sk_paint = *paint.paint();
+  }
+  image->Draw(canvas_, src, dst, sk_paint,
+              UIMonoState::Current()
+                  ->window()
+                  ->viewport_metrics()
+                  .device_pixel_ratio);
+}
+
 void Canvas::drawImageNine(const CanvasImage* image, float center_left,
                            float center_top, float center_right,
                            float center_bottom, float dst_left, float dst_top,
@@ -266,6 +292,404 @@ void Canvas::drawShadow(const CanvasPath* path, SkColor color, float elevation,
                                  transparentOccluder, dpr);
 }
 
+// Op codes for the command stream replayed by Canvas::flushCommands.
+// Must be kept in sync with the _CanvasOp constants in painting.cs.
+//
+// The stream is a sequence of 4 byte words. Every command starts with its op
+// code, followed by its arguments in the same order as the corresponding
+// Canvas_* entry point. Floats are inlined, enums and booleans are encoded as
+// uint32, native objects are int32 indices into the |objects| array and
+// paints are int32 indices into the batch paint table (-1 for no paint).
+//
+// kSetPaint defines an entry of the paint table:
+//   slot, shader index, color filter index, image filter index, followed by
+//   the kDataByteCount bytes of paint data (see paint.cc).
+// A paint is decoded once per batch no matter how many commands use it.
+enum CanvasOp : uint32_t {
+  kSetPaint = 0,
+  kSave,
+  kSaveLayerWithoutBounds,
+  kSaveLayer,
+  kRestore,
+  kTranslate,
+  kScale,
+  kRotate,
+  kSkew,
+  kTransform,
+  kClipRect,
+  kClipRRect,
+  kClipPath,
+  kDrawColor,
+  kDrawLine,
+  kDrawPaint,
+  kDrawRect,
+  kDrawRRect,
+  kDrawDRRect,
+  kDrawOval,
+  kDrawCircle,
+  kDrawArc,
+  kDrawPath,
+  kDrawImage,
+  kDrawImageRect,
+  kDrawImageNine,
+  kDrawPicture,
+  kDrawShadow,
+};
+
+constexpr int kPaintDataWordCount = 14;  // Paint data is 56 bytes.
+constexpr int kPaintObjectCount = 3;     // shader, color filter, image filter.
+constexpr int kRRectWordCount = 12;
+constexpr int kMatrix4WordCount = 16;
+constexpr uint32_t kMaxPaintSlots = 4096;
+
+namespace {
+
+class CanvasCommandReader {
+ public:
+  CanvasCommandReader(const uint8_t* ops, int length, void** objects,
+                      int object_count)
+      : ops_(ops),
+        word_count_(length > 0 ? static_cast<size_t>(length) / 4 : 0),
+        objects_(objects),
+        object_count_(objects ? object_count : 0) {}
+
+  bool HasMore() const { return position_ < word_count_; }
+
+  bool CanRead(size_t words) const {
+    return word_count_ - position_ >= words;
+  }
+
+  uint32_t ReadUint() {
+    uint32_t value;
+    memcpy(&value, ops_ + position_ * 4, sizeof(value));
+    position_++;
+    return value;
+  }
+
+  int32_t ReadInt() { return static_cast<int32_t>(ReadUint()); }
+
+  float ReadFloat() {
+    float value;
+    memcpy(&value, ops_ + position_ * 4, sizeof(value));
+    position_++;
+    return value;
+  }
+
+  void ReadFloats(float* out, int count) {
+    memcpy(out, ops_ + position_ * 4, count * sizeof(float));
+    position_ += count;
+  }
+
+  void ReadBytes(uint8_t* out, int words) {
+    memcpy(out, ops_ + position_ * 4, words * 4);
+    position_ += words;
+  }
+
+  // Reads an object index, -1 being null. Returns false if the index is past
+  // the end of the objects array.
+  template <typename T>
+  bool ReadObject(T** object) {
+    int32_t index = ReadInt();
+    if (index < 0) {
+      *object = nullptr;
+      return true;
+    }
+    if (index >= object_count_) {
+      return false;
+    }
+    *object = static_cast<T*>(objects_[index]);
+    return true;
+  }
+
+ private:
+  const uint8_t* ops_;
+  const size_t word_count_;
+  void** objects_;
+  const int object_count_;
+  size_t position_ = 0;
+};
+
+void ThrowUndefinedObject() {
+  Mono_ThrowException("Canvas.flushCommands referenced an undefined object.");
+}
+
+}  // namespace
+
+void Canvas::flushCommands(const uint8_t* ops, int length, void** objects,
+                           int object_count) {
+  TRACE_EVENT0("uiwidgets", "Canvas::flushCommands");
+  if (!canvas_ || !ops) return;
+
+  // Argument word counts (excluding the op code) indexed by CanvasOp.
+  static constexpr size_t kArgumentWords[] = {
+      4 + kPaintDataWordCount,  // kSetPaint
+      0,                        // kSave
+      1,                        // kSaveLayerWithoutBounds
+      5,                        // kSaveLayer
+      0,                        // kRestore
+      2,                        // kTranslate
+      2,                        // kScale
+      1,                        // kRotate
+      2,                        // kSkew
+      kMatrix4WordCount,        // kTransform
+      6,                        // kClipRect
+      kRRectWordCount + 1,      // kClipRRect
+      2,                        // kClipPath
+      2,                        // kDrawColor
+      5,                        // kDrawLine
+      1,                        // kDrawPaint
+      5,                        // kDrawRect
+      kRRectWordCount + 1,      // kDrawRRect
+      kRRectWordCount * 2 + 1,  // kDrawDRRect
+      5,                        // kDrawOval
+      4,                        // kDrawCircle
+      8,                        // kDrawArc
+      2,                        // kDrawPath
+      4,                        // kDrawImage
+      10,                       // kDrawImageRect
+      10,                       // kDrawImageNine
+      1,                        // kDrawPicture
+      4,                        // kDrawShadow
+  };
+
+  CanvasCommandReader reader(ops, length, objects, object_count);
+  std::vector<Paint> paints;
+  const Paint null_paint;
+
+  auto read_paint = [&](bool nullable) -> const Paint* {
+    int32_t index = reader.ReadInt();
+    if (index < 0 && nullable) return &null_paint;
+    if (index < 0 || static_cast<size_t>(index) >= paints.size() ||
+        !paints[index].paint()) {
+      Mono_ThrowException(
+          "Canvas.flushCommands referenced an undefined paint.");
+      return nullptr;
+    }
+    return &paints[index];
+  };
+
+  while (reader.HasMore()) {
+    uint32_t op = reader.ReadUint();
+    if (op > kDrawShadow || !reader.CanRead(kArgumentWords[op])) {
+      Mono_ThrowException("Canvas.flushCommands called with a malformed batch.");
+      return;
+    }
+
+    float f[kRRectWordCount * 2];
+    switch (op) {
+      case kSetPaint: {
+        uint32_t slot = reader.ReadUint();
+        void* paint_objects[kPaintObjectCount];
+        for (int i = 0; i < kPaintObjectCount; i++) {
+          if (!reader.ReadObject(&paint_objects[i])) {
+            ThrowUndefinedObject();
+            return;
+          }
+        }
+        uint8_t paint_data[kPaintDataWordCount * 4];
+        reader.ReadBytes(paint_data, kPaintDataWordCount);
+        if (slot >= kMaxPaintSlots) {
+          Mono_ThrowException("Canvas.flushCommands paint slot out of range.");
+          return;
+        }
+        if (slot >= paints.size()) {
+          paints.resize(slot + 1);
+        }
+        paints[slot] = Paint(paint_objects, paint_data);
+        break;
+      }
+      case kSave:
+        save();
+        break;
+      case kSaveLayerWithoutBounds: {
+        const Paint* paint = read_paint(true);
+        if (!paint) return;
+        saveLayerWithoutBounds(*paint);
+        break;
+      }
+      case kSaveLayer: {
+        reader.ReadFloats(f, 4);
+        const Paint* paint = read_paint(true);
+        if (!paint) return;
+        saveLayer(f[0], f[1], f[2], f[3], *paint);
+        break;
+      }
+      case kRestore:
+        restore();
+        break;
+      case kTranslate:
+        reader.ReadFloats(f, 2);
+        translate(f[0], f[1]);
+        break;
+      case kScale:
+        reader.ReadFloats(f, 2);
+        scale(f[0], f[1]);
+        break;
+      case kRotate:
+        rotate(reader.ReadFloat());
+        break;
+      case kSkew:
+        reader.ReadFloats(f, 2);
+        skew(f[0], f[1]);
+        break;
+      case kTransform:
+        reader.ReadFloats(f, kMatrix4WordCount);
+        transform(f);
+        break;
+      case kClipRect: {
+        reader.ReadFloats(f, 4);
+        auto clip_op = static_cast<SkClipOp>(reader.ReadUint());
+        bool anti_alias = reader.ReadUint() != 0;
+        clipRect(f[0], f[1], f[2], f[3], clip_op, anti_alias);
+        break;
+      }
+      case kClipRRect:
+        reader.ReadFloats(f, kRRectWordCount);
+        clipRRect(RRect(f), reader.ReadUint() != 0);
+        break;
+      case kClipPath: {
+        CanvasPath* path;
+        if (!reader.ReadObject(&path)) {
+          ThrowUndefinedObject();
+          return;
+        }
+        clipPath(path, reader.ReadUint() != 0);
+        break;
+      }
+      case kDrawColor: {
+        SkColor color = reader.ReadUint();
+        drawColor(color, static_cast<SkBlendMode>(reader.ReadUint()));
+        break;
+      }
+      case kDrawLine: {
+        reader.ReadFloats(f, 4);
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawLine(f[0], f[1], f[2], f[3], *paint);
+        break;
+      }
+      case kDrawPaint: {
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawPaint(*paint);
+        break;
+      }
+      case kDrawRect: {
+        reader.ReadFloats(f, 4);
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawRect(f[0], f[1], f[2], f[3], *paint);
+        break;
+      }
+      case kDrawRRect: {
+        reader.ReadFloats(f, kRRectWordCount);
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawRRect(RRect(f), *paint);
+        break;
+      }
+      case kDrawDRRect: {
+        reader.ReadFloats(f, kRRectWordCount * 2);
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawDRRect(RRect(f), RRect(f + kRRectWordCount), *paint);
+        break;
+      }
+      case kDrawOval: {
+        reader.ReadFloats(f, 4);
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawOval(f[0], f[1], f[2], f[3], *paint);
+        break;
+      }
+      case kDrawCircle: {
+        reader.ReadFloats(f, 3);
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawCircle(f[0], f[1], f[2], *paint);
+        break;
+      }
+      case kDrawArc: {
+        reader.ReadFloats(f, 6);
+        bool use_center = reader.ReadUint() != 0;
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawArc(f[0], f[1], f[2], f[3], f[4], f[5], use_center, *paint);
+        break;
+      }
+      case kDrawPath: {
+        CanvasPath* path;
+        if (!reader.ReadObject(&path)) {
+          ThrowUndefinedObject();
+          return;
+        }
+        const Paint* paint = read_paint(false);
+        if (!paint) return;
+        drawPath(path, *paint);
+        break;
+      }
+      case kDrawImage: {
+        CanvasImage* image;
+        if (!reader.ReadObject(&image)) {
+          ThrowUndefinedObject();
+          return;
+        }
+        reader.ReadFloats(f, 2);
+        const Paint* paint = read_paint(true);
+        if (!paint) return;
+        drawImage(image, f[0], f[1], *paint);
+        break;
+      }
+      case kDrawImageRect: {
+        CanvasImage* image;
+        if (!reader.ReadObject(&image)) {
+          ThrowUndefinedObject();
+          return;
+        }
+        reader.ReadFloats(f, 8);
+        const Paint* paint = read_paint(true);
+        if (!paint) return;
+        drawImageRect(image, f[0], f[1], f[2], f[3], f[4], f[5], f[6], f[7],
+                      *paint);
+        break;
+      }
+      case kDrawImageNine: {
+        CanvasImage* image;
+        if (!reader.ReadObject(&image)) {
+          ThrowUndefinedObject();
+          return;
+        }
+        reader.ReadFloats(f, 8);
+        const Paint* paint = read_paint(true);
+        if (!paint) return;
+        drawImageNine(image, f[0], f[1], f[2], f[3], f[4], f[5], f[6], f[7],
+                      *paint);
+        break;
+      }
+      case kDrawPicture: {
+        Picture* picture;
+        if (!reader.ReadObject(&picture)) {
+          ThrowUndefinedObject();
+          return;
+        }
+        drawPicture(picture);
+        break;
+      }
+      case kDrawShadow: {
+        CanvasPath* path;
+        if (!reader.ReadObject(&path)) {
+          ThrowUndefinedObject();
+          return;
+        }
+        SkColor color = reader.ReadUint();
+        float elevation = reader.ReadFloat();
+        drawShadow(path, color, elevation, reader.ReadUint() != 0);
+        break;
+      }
+    }
+  }
+}
+
 void Canvas::Clear() { canvas_ = nullptr; }
 
 bool Canvas::IsRecording() const { return !!canvas_; }
@@ -410,6 +834,17 @@ Canvas_drawImageRect(Canvas* ptr, CanvasImage* image, float srcLeft,
                      Paint(paint_objects, paint_data));
 }
 
+UIWIDGETS_API(void)
+Canvas_drawTiledImageRect(Canvas* ptr, TiledImage* image, float srcLeft,
+                          float srcTop, float srcRight, float srcBottom,
+                          float dstLeft, float dstTop, float dstRight,
+                          float dstBottom, void** paint_objects,
+                          uint8_t* paint_data) {
+  ptr->drawTiledImageRect(image, srcLeft, srcTop, srcRight, srcBottom, dstLeft,
+                          dstTop, dstRight, dstBottom,
+                          Paint(paint_objects, paint_data));
+}
+
 UIWIDGETS_API(void)
 Canvas_drawImageNine(Canvas* ptr, CanvasImage* image, float centerLeft,
                      float centerTop, float centerRight, float centerBottom,
@@ -455,4 +890,10 @@ Canvas_drawShadow(Canvas* ptr, CanvasPath* path, SkColor color, float elevation,
   ptr->drawShadow(path, color, elevation, transparentOccluder);
 }
 
+UIWIDGETS_API(void)
+Canvas_flushCommands(Canvas* ptr, const uint8_t* ops, int len,
+                     void** objects, int objectCount) {
+  ptr->flushCommands(ops, len, objects, objectCount);
+}
+
 }  // namespace uiwidgets
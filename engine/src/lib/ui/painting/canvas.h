@@ -11,6 +11,7 @@
 #include "picture.h"
 #include "picture_recorder.h"
 #include "rrect.h"
+#include "tiled_image.h"
 #include "vertices.h"
 
 namespace uiwidgets {
@@ -87,6 +88,13 @@ class Canvas : public fml::RefCountedThreadSafe<Canvas> {
   void drawShadow(const CanvasPath* path, SkColor color, float elevation,
                   bool transparentOccluder);
 
+  // Replays a batch of recorded canvas commands. See the CanvasOp encoding in
+  // canvas.cc. |objects| holds the native handles (paths, images, pictures,
+  // shaders and filters) that the commands refer to by index, and
+  // |object_count| is its length.
+  void flushCommands(const uint8_t* ops, int length, void** objects,
+                     int object_count);
+
   SkCanvas* canvas() const { return canvas_; }
   void Clear();
   bool IsRecording() const;
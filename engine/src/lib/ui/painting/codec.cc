@@ -1,14 +1,20 @@
 #include "codec.h"
 
+#include <functional>
 #include <variant>
 
+#include "assets/asset_manager.h"
 #include "common/task_runners.h"
+#include "compressed_texture.h"
 #include "flutter/fml/logging.h"
 #include "flutter/fml/make_copyable.h"
 #include "flutter/fml/trace_event.h"
 #include "frame_info.h"
 #include "include/codec/SkCodec.h"
 #include "include/core/SkPixelRef.h"
+#include "lib/ui/external_data.h"
+#include "lib/ui/ui_mono_state.h"
+#include "lib/ui/window/window.h"
 #include "multi_frame_codec.h"
 #include "single_frame_codec.h"
 
@@ -69,6 +75,87 @@ sk_sp<SkData> MakeSkDataWithCopy(const void* data, size_t length) {
 
 #endif  // OS_ANDROID
 
+// Loads the encoded image returned by |load|, then sniffs its format and
+// counts its frames on the concurrent worker pool, so that neither the load
+// nor the header parse runs on the UI thread. |callback| is always answered on
+// the UI thread, with the codec, or with null if the image could not be loaded,
+// no codec recognizes it or the isolate is gone.
+void InstantiateImageCodecAsync(std::function<sk_sp<SkData>()> load,
+                                Codec::InstantiateImageCodecCallback callback,
+                                Mono_Handle callback_handle, int target_width,
+                                int target_height) {
+  fml::RefPtr<fml::TaskRunner> ui_task_runner =
+      UIMonoState::Current()->GetTaskRunners().GetUITaskRunner();
+  std::weak_ptr<MonoState> mono_state = MonoState::Current()->GetWeakPtr();
+
+  auto instantiate = [load = std::move(load), ui_task_runner, mono_state,
+                      callback, callback_handle, target_width,
+                      target_height]() {
+    TRACE_EVENT0("uiwidgets", "InstantiateImageCodec");
+    sk_sp<SkData> buffer = load();
+    std::unique_ptr<SkCodec> codec;
+    int frame_count = 0;
+    if (buffer && CompressedTexture::IsCompressedTexture(*buffer)) {
+      // Compressed textures are not encoded images, the image decoder
+      // uploads or decompresses them.
+      frame_count = 1;
+    } else if (buffer) {
+      codec = SkCodec::MakeFromData(buffer);
+      frame_count = codec ? codec->getFrameCount() : 0;
+    }
+    if (frame_count == 1) {
+      // Single frame images are decoded again by the image decoder, which
+      // only needs the encoded bytes.
+      codec.reset();
+    }
+
+    ui_task_runner->PostTask(fml::MakeCopyable(
+        [buffer = std::move(buffer), codec = std::move(codec), frame_count,
+         mono_state, callback, callback_handle, target_width,
+         target_height]() mutable {
+          std::shared_ptr<MonoState> state = mono_state.lock();
+          if (!state) {
+            // The managed callback still frees its handle, and finds that
+            // its isolate is gone.
+            callback(callback_handle, nullptr);
+            return;
+          }
+          MonoState::Scope scope(state);
+
+          fml::RefPtr<Codec> ui_codec;
+          if (frame_count == 1) {
+            ImageDecoder::ImageDescriptor descriptor;
+            if (target_width > 0) {
+              descriptor.target_width = target_width;
+            }
+            if (target_height > 0) {
+              descriptor.target_height = target_height;
+            }
+            descriptor.data = std::move(buffer);
+            ui_codec =
+                fml::MakeRefCounted<SingleFrameCodec>(std::move(descriptor));
+          } else if (codec) {
+            ui_codec = fml::MakeRefCounted<MultiFrameCodec>(std::move(codec));
+          }
+
+          if (!ui_codec) {
+            callback(callback_handle, nullptr);
+            return;
+          }
+          ui_codec->AddRef();
+          callback(callback_handle, ui_codec.get());
+        }));
+  };
+
+  std::shared_ptr<fml::ConcurrentMessageLoop> loop =
+      UIMonoState::Current()->window()->client()->GetConcurrentMessageLoop();
+  if (loop) {
+    loop->GetTaskRunner()->PostTask(std::move(instantiate));
+  } else {
+    ui_task_runner->PostTask(std::move(instantiate));
+  }
+}
+
 }  // anonymous namespace
 
 static std::variant<ImageDecoder::ImageInfo, std::string> ConvertImageInfo(
@@ -145,7 +232,7 @@ Codec_instantiateImageCodec(uint8_t* data, int data_length,
 
   std::unique_ptr<SkCodec> codec;
   bool single_frame;
-  if (image_info) {
+  if (image_info || CompressedTexture::IsCompressedTexture(*buffer)) {
     single_frame = true;
   } else {
     codec = SkCodec::MakeFromData(buffer);
@@ -179,9 +266,73 @@ Codec_instantiateImageCodec(uint8_t* data, int data_length,
   return nullptr;
 }
 
+// Wraps |data| without copying it. The buffer must stay pinned until
+// |release_callback| is called on the UI thread.
+UIWIDGETS_API(const char*)
+Codec_instantiateImageCodecFromBuffer(
+    const uint8_t* data, int data_length,
+    ReleaseExternalDataCallback release_callback, Mono_Handle release_handle,
+    Codec::InstantiateImageCodecCallback callback, Mono_Handle callback_handle,
+    int target_width, int target_height) {
+  if (!callback || !callback_handle) {
+    return "Callback must be a function";
+  }
+  if (!release_callback) {
+    return "Release callback must be a function";
+  }
+
+  sk_sp<SkData> buffer = MakeSkDataFromExternalBuffer(
+      data, data_length, release_callback, release_handle);
+  InstantiateImageCodecAsync([buffer]() { return buffer; }, callback,
+                             callback_handle, target_width, target_height);
+  return nullptr;
+}
+
+// Maps the file at |path| into memory on a worker thread.
+UIWIDGETS_API(const char*)
+Codec_instantiateImageCodecFromFile(
+    char* path, Codec::InstantiateImageCodecCallback callback,
+    Mono_Handle callback_handle, int target_width, int target_height) {
+  if (!callback || !callback_handle) {
+    return "Callback must be a function";
+  }
+
+  InstantiateImageCodecAsync(
+      [path = std::string(path)]() { return MakeSkDataFromFile(path); },
+      callback, callback_handle, target_width, target_height);
+  return nullptr;
+}
+
+// Reads |asset_name| from the asset bundle on a worker thread. Assets stored
+// as files are mapped rather than read.
+UIWIDGETS_API(const char*)
+Codec_instantiateImageCodecFromAsset(
+    char* asset_name, Codec::InstantiateImageCodecCallback callback,
+    Mono_Handle callback_handle, int target_width, int target_height) {
+  if (!callback || !callback_handle) {
+    return "Callback must be a function";
+  }
+
+  std::shared_ptr<AssetManager> asset_manager =
+      UIMonoState::Current()->window()->client()->GetAssetManager();
+  if (!asset_manager) {
+    return "No asset bundle is available";
+  }
+
+  InstantiateImageCodecAsync(
+      [asset_manager, asset_name = std::string(asset_name)]() {
+        return MakeSkDataFromMapping(asset_manager->GetAsMapping(asset_name));
+      },
+      callback, callback_handle, target_width, target_height);
+  return nullptr;
+}
+
 void Codec::dispose() {}
 
-UIWIDGETS_API(void) Codec_dispose(Codec* ptr) { ptr->Release(); }
+UIWIDGETS_API(void) Codec_dispose(Codec* ptr) {
+  ptr->dispose();
+  ptr->Release();
+}
 
 UIWIDGETS_API(int) Codec_frameCount(Codec* ptr) { return ptr->frameCount(); }
 
@@ -189,6 +340,15 @@ UIWIDGETS_API(int) Codec_repetitionCount(Codec* ptr) {
   return ptr->repetitionCount();
 }
 
+UIWIDGETS_API(void)
+Codec_setLookAhead(Codec* ptr, int frame_count, bool cache_all_frames) {
+  ptr->setLookAhead(frame_count, cache_all_frames);
+}
+
+UIWIDGETS_API(void) Codec_setDecodePriority(Codec* ptr, int priority) {
+  ptr->setDecodePriority(priority);
+}
+
 UIWIDGETS_API(const char*)
 Codec_getNextFrame(Codec* ptr, Codec::GetNextFrameCallback callback,
                    Mono_Handle callback_handle) {
@@ -27,7 +27,19 @@ class Codec : public fml::RefCountedThreadSafe<Codec> {
 
   virtual size_t GetAllocationSize() { return 0; }
 
-  void dispose();
+  // Sets how many frames are decoded ahead of the frame being displayed,
+  // and whether decoded frames are kept so that later loops of the animation
+  // are not decoded again. Only meaningful for animated images.
+  virtual void setLookAhead(int frame_count, bool cache_all_frames) {}
+
+  // Sets the priority of the decodes of the codec, one of
+  // ImageDecoder::Priority. Only meaningful for single frame images.
+  virtual void setDecodePriority(int priority) {}
+
+  // Called when the managed codec is disposed, before it releases its
+  // reference. Aborts the decodes that have not started. May be called on
+  // any thread, including the finalizer thread.
+  virtual void dispose();
 
   struct _ImageInfo {
     int width;
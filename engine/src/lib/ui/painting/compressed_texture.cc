@@ -0,0 +1,498 @@
+#include "compressed_texture.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "flutter/fml/logging.h"
+#include "flutter/fml/trace_event.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorPriv.h"
+
+namespace uiwidgets {
+
+namespace {
+
+constexpr uint8_t kKTXIdentifier[12] = {0xAB, 'K',  'T',  'X', ' ',  '1',
+                                        '1',  0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr uint8_t kKTX2Identifier[12] = {0xAB, 'K',  'T',  'X', ' ',  '2',
+                                         '0',  0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr uint8_t kDDSIdentifier[4] = {'D', 'D', 'S', ' '};
+
+constexpr size_t kKTXHeaderSize = 64;
+constexpr uint32_t kKTXEndianness = 0x04030201;
+constexpr uint32_t kKTXEndiannessSwapped = 0x01020304;
+constexpr size_t kKTX2HeaderSize = 80;
+constexpr size_t kKTX2LevelIndexEntrySize = 24;
+constexpr size_t kDDSHeaderSize = 128;
+constexpr size_t kDDSHeaderDX10Size = 20;
+
+// glInternalFormat values of KTX containers.
+constexpr uint32_t kGLCompressedRGBS3TCDXT1 = 0x83F0;
+constexpr uint32_t kGLCompressedRGBAS3TCDXT1 = 0x83F1;
+constexpr uint32_t kGLETC1RGB8 = 0x8D64;
+constexpr uint32_t kGLCompressedRGB8ETC2 = 0x9274;
+
+// vkFormat values of KTX2 containers.
+constexpr uint32_t kVkFormatBC1RGBUnorm = 131;
+constexpr uint32_t kVkFormatBC1RGBAUnorm = 133;
+constexpr uint32_t kVkFormatETC2R8G8B8Unorm = 147;
+
+// Fields of DDS headers.
+constexpr uint32_t kDDSDMipMapCount = 0x20000;
+constexpr uint32_t kDDPFAlphaPixels = 0x1;
+constexpr uint32_t kDDPFFourCC = 0x4;
+constexpr uint32_t kFourCCDXT1 = 0x31545844;
+constexpr uint32_t kFourCCDX10 = 0x30315844;
+constexpr uint32_t kDXGIFormatBC1Unorm = 71;
+
+constexpr int kBlockSize = 4;
+constexpr size_t kBlockBytes = 8;
+
+// Larger textures are rejected before their dimensions are narrowed to int,
+// and their levels sized. No GPU samples textures this large.
+constexpr uint32_t kMaxDimension = 32768;
+// The levels below a 1x1 level of the largest texture are ignored.
+constexpr uint32_t kMaxLevelCount = 16;
+
+uint32_t ReadU32(const uint8_t* bytes, bool swap = false) {
+  uint32_t value;
+  memcpy(&value, bytes, sizeof(value));
+  if (swap) {
+    value = ((value & 0xFF) << 24) | ((value & 0xFF00) << 8) |
+            ((value >> 8) & 0xFF00) | (value >> 24);
+  }
+  return value;
+}
+
+uint64_t ReadU64(const uint8_t* bytes) {
+  uint64_t value;
+  memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+bool StartsWith(const SkData& data, const uint8_t* identifier, size_t size) {
+  return data.size() >= size && memcmp(data.data(), identifier, size) == 0;
+}
+
+bool IsValidDimensions(uint32_t width, uint32_t height) {
+  return width > 0 && height > 0 && width <= kMaxDimension &&
+         height <= kMaxDimension;
+}
+
+// |width| and |height| must be valid, and |level| below kMaxLevelCount.
+SkISize GetMipDimensions(uint32_t width, uint32_t height, int level) {
+  return SkISize::Make(std::max<uint32_t>(width >> level, 1),
+                       std::max<uint32_t>(height >> level, 1));
+}
+
+uint8_t Extend4(uint32_t value) { return (value << 4) | value; }
+
+uint8_t Extend5(uint32_t value) { return (value << 3) | (value >> 2); }
+
+uint8_t Extend6(uint32_t value) { return (value << 2) | (value >> 4); }
+
+uint8_t Extend7(uint32_t value) { return (value << 1) | (value >> 6); }
+
+uint8_t Clamp(int value) {
+  return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+struct RGB {
+  int r;
+  int g;
+  int b;
+};
+
+SkPMColor MakeOpaque(const RGB& color) {
+  return SkPackARGB32(0xFF, Clamp(color.r), Clamp(color.g), Clamp(color.b));
+}
+
+RGB Offset(const RGB& color, int delta) {
+  return {color.r + delta, color.g + delta, color.b + delta};
+}
+
+// Decodes a BC1 block. Pixels are stored by rows.
+void DecodeBC1Block(const uint8_t* block, bool has_alpha, SkPMColor* pixels) {
+  const uint32_t c0 = block[0] | (block[1] << 8);
+  const uint32_t c1 = block[2] | (block[3] << 8);
+  const uint32_t indices = ReadU32(block + 4);
+
+  auto expand = [](uint32_t c) -> RGB {
+    return {Extend5((c >> 11) & 31), Extend6((c >> 5) & 63), Extend5(c & 31)};
+  };
+  const RGB e0 = expand(c0);
+  const RGB e1 = expand(c1);
+  SkPMColor palette[4];
+  palette[0] = MakeOpaque(e0);
+  palette[1] = MakeOpaque(e1);
+  if (c0 > c1) {
+    palette[2] = MakeOpaque({(2 * e0.r + e1.r) / 3, (2 * e0.g + e1.g) / 3,
+                             (2 * e0.b + e1.b) / 3});
+    palette[3] = MakeOpaque({(e0.r + 2 * e1.r) / 3, (e0.g + 2 * e1.g) / 3,
+                             (e0.b + 2 * e1.b) / 3});
+  } else {
+    palette[2] = MakeOpaque(
+        {(e0.r + e1.r) / 2, (e0.g + e1.g) / 2, (e0.b + e1.b) / 2});
+    palette[3] = has_alpha ? 0 : MakeOpaque({0, 0, 0});
+  }
+  for (int i = 0; i < 16; i++) {
+    pixels[i] = palette[(indices >> (2 * i)) & 3];
+  }
+}
+
+// Decodes an ETC2 RGB8 block, which is also an ETC1 block unless it uses the
+// T, H or planar modes. Pixels are stored by rows.
+void DecodeETC2Block(const uint8_t* block, SkPMColor* pixels) {
+  static constexpr int kModifiers[8][2] = {{2, 8},   {5, 17},  {9, 29},
+                                           {13, 42}, {18, 60}, {24, 80},
+                                           {33, 106}, {47, 183}};
+  static constexpr int kDistances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+  uint64_t bits = 0;
+  for (size_t i = 0; i < kBlockBytes; i++) {
+    bits = (bits << 8) | block[i];
+  }
+  // Pixel indices are stored by columns, their most significant bits first.
+  auto pixel_index = [bits](int x, int y) {
+    const int i = x * 4 + y;
+    return static_cast<int>(((bits >> (16 + i)) & 1) << 1 |
+                            ((bits >> i) & 1));
+  };
+
+  const bool diff = (block[3] >> 1) & 1;
+  const bool flip = block[3] & 1;
+  RGB base[2];
+  if (!diff) {
+    base[0] = {Extend4(block[0] >> 4), Extend4(block[1] >> 4),
+               Extend4(block[2] >> 4)};
+    base[1] = {Extend4(block[0] & 15), Extend4(block[1] & 15),
+               Extend4(block[2] & 15)};
+  } else {
+    auto delta = [](uint8_t byte) {
+      const int value = byte & 7;
+      return value >= 4 ? value - 8 : value;
+    };
+    const int r = block[0] >> 3;
+    const int g = block[1] >> 3;
+    const int b = block[2] >> 3;
+    const int r2 = r + delta(block[0]);
+    const int g2 = g + delta(block[1]);
+    const int b2 = b + delta(block[2]);
+
+    if (r2 < 0 || r2 > 31) {
+      // T mode.
+      const RGB c1 = {Extend4(((block[0] >> 1) & 0xC) | (block[0] & 3)),
+                      Extend4(block[1] >> 4), Extend4(block[1] & 15)};
+      const RGB c2 = {Extend4(block[2] >> 4), Extend4(block[2] & 15),
+                      Extend4(block[3] >> 4)};
+      const int d =
+          kDistances[((block[3] >> 1) & 6) | (block[3] & 1)];
+      const SkPMColor paint[4] = {MakeOpaque(c1), MakeOpaque(Offset(c2, d)),
+                                  MakeOpaque(c2), MakeOpaque(Offset(c2, -d))};
+      for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+          pixels[y * 4 + x] = paint[pixel_index(x, y)];
+        }
+      }
+      return;
+    }
+
+    if (g2 < 0 || g2 > 31) {
+      // H mode.
+      const RGB c1 = {
+          Extend4((block[0] >> 3) & 15),
+          Extend4(((block[0] & 7) << 1) | ((block[1] >> 4) & 1)),
+          Extend4((block[1] & 8) | ((block[1] & 3) << 1) | (block[2] >> 7))};
+      const RGB c2 = {Extend4((block[2] >> 3) & 15),
+                      Extend4(((block[2] & 7) << 1) | (block[3] >> 7)),
+                      Extend4((block[3] >> 3) & 15)};
+      const int v1 = (c1.r << 16) | (c1.g << 8) | c1.b;
+      const int v2 = (c2.r << 16) | (c2.g << 8) | c2.b;
+      const int d = kDistances[(block[3] & 4) | ((block[3] & 1) << 1) |
+                               (v1 >= v2 ? 1 : 0)];
+      const SkPMColor paint[4] = {
+          MakeOpaque(Offset(c1, d)), MakeOpaque(Offset(c1, -d)),
+          MakeOpaque(Offset(c2, d)), MakeOpaque(Offset(c2, -d))};
+      for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+          pixels[y * 4 + x] = paint[pixel_index(x, y)];
+        }
+      }
+      return;
+    }
+
+    if (b2 < 0 || b2 > 31) {
+      // Planar mode.
+      const RGB o = {
+          Extend6((bits >> 57) & 63),
+          Extend7((((bits >> 56) & 1) << 6) | ((bits >> 49) & 63)),
+          Extend6((((bits >> 48) & 1) << 5) | (((bits >> 43) & 3) << 3) |
+                  ((bits >> 39) & 7))};
+      const RGB h = {
+          Extend6((((bits >> 34) & 31) << 1) | ((bits >> 32) & 1)),
+          Extend7((bits >> 25) & 127), Extend6((bits >> 19) & 63)};
+      const RGB v = {Extend6((bits >> 13) & 63), Extend7((bits >> 6) & 127),
+                     Extend6(bits & 63)};
+      for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+          pixels[y * 4 + x] = MakeOpaque(
+              {(x * (h.r - o.r) + y * (v.r - o.r) + 4 * o.r + 2) >> 2,
+               (x * (h.g - o.g) + y * (v.g - o.g) + 4 * o.g + 2) >> 2,
+               (x * (h.b - o.b) + y * (v.b - o.b) + 4 * o.b + 2) >> 2});
+        }
+      }
+      return;
+    }
+
+    base[0] = {Extend5(r), Extend5(g), Extend5(b)};
+    base[1] = {Extend5(r2), Extend5(g2), Extend5(b2)};
+  }
+
+  const int tables[2] = {(block[3] >> 5) & 7, (block[3] >> 2) & 7};
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      const int subblock = flip ? (y >= 2) : (x >= 2);
+      const int index = pixel_index(x, y);
+      const int modifier = kModifiers[tables[subblock]][index & 1];
+      pixels[y * 4 + x] =
+          MakeOpaque(Offset(base[subblock], index & 2 ? -modifier : modifier));
+    }
+  }
+}
+
+}  // namespace
+
+CompressedTexture::CompressedTexture(sk_sp<SkData> data, Format format,
+                                     std::vector<Level> levels)
+    : data_(std::move(data)), format_(format), levels_(std::move(levels)) {}
+
+bool CompressedTexture::IsCompressedTexture(const SkData& data) {
+  return StartsWith(data, kKTXIdentifier, sizeof(kKTXIdentifier)) ||
+         StartsWith(data, kKTX2Identifier, sizeof(kKTX2Identifier)) ||
+         StartsWith(data, kDDSIdentifier, sizeof(kDDSIdentifier));
+}
+
+size_t CompressedTexture::GetLevelSize(SkISize dimensions) {
+  const size_t blocks_x = (dimensions.width() + kBlockSize - 1) / kBlockSize;
+  const size_t blocks_y = (dimensions.height() + kBlockSize - 1) / kBlockSize;
+  return blocks_x * blocks_y * kBlockBytes;
+}
+
+std::unique_ptr<CompressedTexture> CompressedTexture::Parse(
+    sk_sp<SkData> data) {
+  TRACE_EVENT0("uiwidgets", "CompressedTexture::Parse");
+  const uint8_t* bytes = data->bytes();
+  const size_t size = data->size();
+  std::optional<Format> format;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::vector<Level> levels;
+
+  if (StartsWith(*data, kKTXIdentifier, sizeof(kKTXIdentifier))) {
+    if (size < kKTXHeaderSize) {
+      return nullptr;
+    }
+    const uint32_t endianness = ReadU32(bytes + 12);
+    if (endianness != kKTXEndianness && endianness != kKTXEndiannessSwapped) {
+      return nullptr;
+    }
+    const bool swap = endianness == kKTXEndiannessSwapped;
+    switch (ReadU32(bytes + 28, swap)) {
+      case kGLETC1RGB8:
+        format = Format::kETC1;
+        break;
+      case kGLCompressedRGB8ETC2:
+        format = Format::kETC2_RGB8;
+        break;
+      case kGLCompressedRGBS3TCDXT1:
+        format = Format::kBC1_RGB8;
+        break;
+      case kGLCompressedRGBAS3TCDXT1:
+        format = Format::kBC1_RGBA8;
+        break;
+    }
+    width = ReadU32(bytes + 36, swap);
+    height = ReadU32(bytes + 40, swap);
+    const uint32_t depth = ReadU32(bytes + 44, swap);
+    const uint32_t array_elements = ReadU32(bytes + 48, swap);
+    const uint32_t faces = ReadU32(bytes + 52, swap);
+    const uint32_t level_count =
+        std::clamp(ReadU32(bytes + 56, swap), 1u, kMaxLevelCount);
+    if (!format || depth > 1 || !IsValidDimensions(width, height)) {
+      return nullptr;
+    }
+
+    size_t offset = kKTXHeaderSize + ReadU32(bytes + 60, swap);
+    for (uint32_t level = 0; level < level_count; level++) {
+      if (offset + sizeof(uint32_t) > size) {
+        break;
+      }
+      const size_t image_size = ReadU32(bytes + offset, swap);
+      offset += sizeof(uint32_t);
+      levels.push_back({offset, GetMipDimensions(width, height, level)});
+      // The image size of non array cube maps is the size of one face. Each
+      // face, as each level, is padded to 4 bytes.
+      const size_t padded_size = (image_size + 3) & ~size_t{3};
+      offset += faces == 6 && array_elements == 0 ? padded_size * 6
+                                                  : padded_size;
+    }
+  } else if (StartsWith(*data, kKTX2Identifier, sizeof(kKTX2Identifier))) {
+    if (size < kKTX2HeaderSize) {
+      return nullptr;
+    }
+    switch (ReadU32(bytes + 12)) {
+      case kVkFormatETC2R8G8B8Unorm:
+        format = Format::kETC2_RGB8;
+        break;
+      case kVkFormatBC1RGBUnorm:
+        format = Format::kBC1_RGB8;
+        break;
+      case kVkFormatBC1RGBAUnorm:
+        format = Format::kBC1_RGBA8;
+        break;
+    }
+    width = ReadU32(bytes + 20);
+    height = ReadU32(bytes + 24);
+    const uint32_t depth = ReadU32(bytes + 28);
+    const uint32_t level_count =
+        std::clamp(ReadU32(bytes + 40), 1u, kMaxLevelCount);
+    const uint32_t supercompression_scheme = ReadU32(bytes + 44);
+    if (!format || depth > 1 || supercompression_scheme != 0 ||
+        !IsValidDimensions(width, height) ||
+        kKTX2HeaderSize + level_count * kKTX2LevelIndexEntrySize > size) {
+      return nullptr;
+    }
+    for (uint32_t level = 0; level < level_count; level++) {
+      const uint64_t offset =
+          ReadU64(bytes + kKTX2HeaderSize + level * kKTX2LevelIndexEntrySize);
+      levels.push_back({static_cast<size_t>(offset),
+                        GetMipDimensions(width, height, level)});
+    }
+  } else if (StartsWith(*data, kDDSIdentifier, sizeof(kDDSIdentifier))) {
+    if (size < kDDSHeaderSize || ReadU32(bytes + 4) != 124) {
+      return nullptr;
+    }
+    const uint32_t flags = ReadU32(bytes + 8);
+    height = ReadU32(bytes + 12);
+    width = ReadU32(bytes + 16);
+    const uint32_t level_count =
+        flags & kDDSDMipMapCount
+            ? std::clamp(ReadU32(bytes + 28), 1u, kMaxLevelCount)
+            : 1;
+    const uint32_t pixel_format_flags = ReadU32(bytes + 80);
+    const uint32_t four_cc = ReadU32(bytes + 84);
+    size_t offset = kDDSHeaderSize;
+    if (pixel_format_flags & kDDPFFourCC) {
+      if (four_cc == kFourCCDXT1) {
+        format = pixel_format_flags & kDDPFAlphaPixels ? Format::kBC1_RGBA8
+                                                       : Format::kBC1_RGB8;
+      } else if (four_cc == kFourCCDX10 &&
+                 size >= kDDSHeaderSize + kDDSHeaderDX10Size &&
+                 ReadU32(bytes + kDDSHeaderSize) == kDXGIFormatBC1Unorm) {
+        format = Format::kBC1_RGBA8;
+        offset += kDDSHeaderDX10Size;
+      }
+    }
+    if (!format || !IsValidDimensions(width, height)) {
+      return nullptr;
+    }
+    for (uint32_t level = 0; level < level_count; level++) {
+      const SkISize dimensions = GetMipDimensions(width, height, level);
+      levels.push_back({offset, dimensions});
+      offset += GetLevelSize(dimensions);
+    }
+  } else {
+    return nullptr;
+  }
+
+  if (levels.empty()) {
+    return nullptr;
+  }
+  // Drops the levels whose blocks are missing.
+  auto truncated = std::find_if(levels.begin(), levels.end(), [&](auto level) {
+    return level.offset > size ||
+           size - level.offset < GetLevelSize(level.dimensions);
+  });
+  levels.erase(truncated, levels.end());
+  if (levels.empty()) {
+    FML_LOG(ERROR) << "Compressed texture data is truncated.";
+    return nullptr;
+  }
+
+  return std::unique_ptr<CompressedTexture>(
+      new CompressedTexture(std::move(data), *format, std::move(levels)));
+}
+
+int CompressedTexture::GetLevelForSize(SkISize target_size) const {
+  int level = 0;
+  while (level + 1 < level_count() &&
+         levels_[level + 1].dimensions.width() >= target_size.width() &&
+         levels_[level + 1].dimensions.height() >= target_size.height()) {
+    level++;
+  }
+  return level;
+}
+
+sk_sp<SkData> CompressedTexture::GetLevelData(int level) const {
+  const Level& mip = levels_[level];
+  return SkData::MakeSubset(data_.get(), mip.offset,
+                            GetLevelSize(mip.dimensions));
+}
+
+std::optional<SkImage::CompressionType> CompressedTexture::GetCompressionType()
+    const {
+  switch (format_) {
+    // ETC2 decoders also decode ETC1 blocks.
+    case Format::kETC1:
+    case Format::kETC2_RGB8:
+      return SkImage::CompressionType::kETC2_RGB8_UNORM;
+    case Format::kBC1_RGB8:
+      return SkImage::CompressionType::kBC1_RGB8_UNORM;
+    case Format::kBC1_RGBA8:
+      return std::nullopt;
+  }
+  return std::nullopt;
+}
+
+sk_sp<SkImage> CompressedTexture::Decompress(int level) const {
+  TRACE_EVENT0("uiwidgets", "CompressedTexture::Decompress");
+  const Level& mip = levels_[level];
+  const SkISize dimensions = mip.dimensions;
+  const bool has_alpha = format_ == Format::kBC1_RGBA8;
+  SkBitmap bitmap;
+  if (!bitmap.tryAllocPixels(SkImageInfo::MakeN32(
+          dimensions.width(), dimensions.height(),
+          has_alpha ? kPremul_SkAlphaType : kOpaque_SkAlphaType))) {
+    FML_LOG(ERROR) << "Failed to allocate memory for bitmap of size "
+                   << bitmap.info().computeMinByteSize() << "B";
+    return nullptr;
+  }
+
+  const uint8_t* block = data_->bytes() + mip.offset;
+  SkPMColor pixels[kBlockSize * kBlockSize];
+  for (int by = 0; by < dimensions.height(); by += kBlockSize) {
+    for (int bx = 0; bx < dimensions.width(); bx += kBlockSize) {
+      if (format_ == Format::kBC1_RGB8 || format_ == Format::kBC1_RGBA8) {
+        DecodeBC1Block(block, has_alpha, pixels);
+      } else {
+        DecodeETC2Block(block, pixels);
+      }
+      block += kBlockBytes;
+
+      // Blocks on the right and bottom edges may exceed the image.
+      const int columns = std::min(kBlockSize, dimensions.width() - bx);
+      const int rows = std::min(kBlockSize, dimensions.height() - by);
+      for (int y = 0; y < rows; y++) {
+        memcpy(bitmap.getAddr32(bx, by + y), pixels + y * kBlockSize,
+               columns * sizeof(SkPMColor));
+      }
+    }
+  }
+
+  // Marking this as immutable makes the MakeFromBitmap call share the pixels
+  // instead of copying.
+  bitmap.setImmutable();
+  return SkImage::MakeFromBitmap(bitmap);
+}
+
+}  // namespace uiwidgets
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkSize.h"
+
+namespace uiwidgets {
+
+// A texture stored in a KTX, KTX2 or DDS container, whose payload is already
+// compressed in a GPU format. Only the formats made of 4x4 blocks of 8 bytes
+// that Skia can upload are recognized: ETC1, ETC2 RGB8 and BC1.
+//
+// Textures are uploaded as they are when the GPU supports their format, see
+// SnapshotDelegate::MakeCompressedTextureImage. Otherwise they are
+// decompressed on the CPU.
+class CompressedTexture {
+ public:
+  enum class Format {
+    kETC1,
+    kETC2_RGB8,
+    kBC1_RGB8,
+    kBC1_RGBA8,
+  };
+
+  // Returns whether |data| starts with the signature of a supported
+  // container. Does not validate the rest of the container.
+  static bool IsCompressedTexture(const SkData& data);
+
+  // Returns null if |data| is not a well formed container, or if its format
+  // is not supported. Only the first face and array layer are read.
+  static std::unique_ptr<CompressedTexture> Parse(sk_sp<SkData> data);
+
+  Format format() const { return format_; }
+
+  SkISize dimensions() const { return levels_.front().dimensions; }
+
+  int level_count() const { return static_cast<int>(levels_.size()); }
+
+  SkISize GetLevelDimensions(int level) const {
+    return levels_[level].dimensions;
+  }
+
+  // Returns the smallest mip level that is at least |target_size| in both
+  // dimensions, or the largest level if none is.
+  int GetLevelForSize(SkISize target_size) const;
+
+  // Returns the compressed blocks of |level|, sharing the container data.
+  sk_sp<SkData> GetLevelData(int level) const;
+
+  // Returns the Skia compression type of the format, if Skia can upload it.
+  std::optional<SkImage::CompressionType> GetCompressionType() const;
+
+  // Decompresses |level| into a raster image.
+  sk_sp<SkImage> Decompress(int level) const;
+
+ private:
+  struct Level {
+    size_t offset;
+    SkISize dimensions;
+  };
+
+  sk_sp<SkData> data_;
+  Format format_;
+  std::vector<Level> levels_;
+
+  CompressedTexture(sk_sp<SkData> data, Format format,
+                    std::vector<Level> levels);
+
+  static size_t GetLevelSize(SkISize dimensions);
+};
+
+}  // namespace uiwidgets
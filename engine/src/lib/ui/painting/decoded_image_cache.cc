@@ -0,0 +1,142 @@
+#include "decoded_image_cache.h"
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include "flutter/fml/hash_combine.h"
+#include "flutter/fml/trace_event.h"
+
+namespace uiwidgets {
+
+namespace {
+
+// A hash of |size| bytes independent of std::hash, which it complements to
+// make the digest of the key. Reads the bytes a word at a time.
+uint64_t DigestBytes(const uint8_t* bytes, size_t size) {
+  constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+  uint64_t hash = 0xCBF29CE484222325ull ^ (size * kMultiplier);
+  auto mix = [&hash](uint64_t word) {
+    hash ^= word;
+    hash *= kMultiplier;
+    hash ^= hash >> 32;
+  };
+  size_t offset = 0;
+  for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + offset, sizeof(word));
+    mix(word);
+  }
+  if (offset < size) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + offset, size - offset);
+    mix(word);
+  }
+  return hash;
+}
+
+}  // namespace
+
+bool DecodedImageCache::Key::operator==(const Key& other) const {
+  return data_hash == other.data_hash && data_digest == other.data_digest &&
+         data_size == other.data_size &&
+         target_width == other.target_width &&
+         target_height == other.target_height &&
+         image_info_hash == other.image_info_hash;
+}
+
+size_t DecodedImageCache::KeyHash::operator()(const Key& key) const {
+  return fml::HashCombine(key.data_hash, key.data_digest, key.data_size,
+                          key.target_width, key.target_height,
+                          key.image_info_hash);
+}
+
+SkiaGPUObject<SkImage> DecodedImageCache::Share(
+    const SkiaGPUObject<SkImage>& image) {
+  if (!image.get()) {
+    return {};
+  }
+  return {image.get(), image.queue()};
+}
+
+DecodedImageCache::DecodedImageCache(size_t max_bytes)
+    : max_bytes_(max_bytes) {}
+
+DecodedImageCache::~DecodedImageCache() = default;
+
+DecodedImageCache::Key DecodedImageCache::MakeKey(
+    const SkData& data, uint32_t target_width, uint32_t target_height,
+    const SkImageInfo* image_info, size_t row_bytes) {
+  TRACE_EVENT0("uiwidgets", "DecodedImageCache::MakeKey");
+  Key key;
+  key.data_hash = std::hash<std::string_view>()(std::string_view(
+      static_cast<const char*>(data.data()), data.size()));
+  key.data_digest = DigestBytes(data.bytes(), data.size());
+  key.data_size = data.size();
+  key.target_width = target_width;
+  key.target_height = target_height;
+  key.image_info_hash =
+      image_info ? fml::HashCombine(image_info->width(), image_info->height(),
+                                    static_cast<int>(image_info->colorType()),
+                                    row_bytes)
+                 : 0;
+  return key;
+}
+
+SkiaGPUObject<SkImage> DecodedImageCache::Get(const Key& key) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    miss_count_++;
+    return {};
+  }
+  hit_count_++;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return Share(it->second->image);
+}
+
+void DecodedImageCache::Put(const Key& key,
+                            const SkiaGPUObject<SkImage>& image) {
+  if (!image.get()) {
+    return;
+  }
+  const size_t bytes = image.get()->imageInfo().computeMinByteSize();
+  if (bytes > max_bytes_ || index_.find(key) != index_.end()) {
+    return;
+  }
+  while (bytes_ + bytes > max_bytes_ && !lru_.empty()) {
+    Entry& lru = lru_.back();
+    bytes_ -= lru.bytes;
+    index_.erase(lru.key);
+    lru_.pop_back();
+    eviction_count_++;
+  }
+  lru_.push_front({key, Share(image), bytes});
+  index_[key] = lru_.begin();
+  bytes_ += bytes;
+}
+
+void DecodedImageCache::Clear() {
+  TRACE_EVENT0("uiwidgets", "DecodedImageCache::Clear");
+  eviction_count_ += lru_.size();
+  index_.clear();
+  lru_.clear();
+  bytes_ = 0;
+}
+
+void DecodedImageCache::TraceStatsToTimeline() {
+#if !UIWidgets_RELEASE
+  FML_TRACE_COUNTER("uiwidgets", "DecodedImageCache",
+                    reinterpret_cast<int64_t>(this),  //
+                    "Hits", hit_count_,               //
+                    "Misses", miss_count_,            //
+                    "Evictions", eviction_count_,     //
+                    "Entries", lru_.size(),           //
+                    "MBytes", bytes_ * 1e-6           //
+  );
+#endif  // !UIWidgets_RELEASE
+  hit_count_ = 0;
+  miss_count_ = 0;
+  eviction_count_ = 0;
+}
+
+}  // namespace uiwidgets
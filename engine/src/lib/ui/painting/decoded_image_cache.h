@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+#include "flow/skia_gpu_object.h"
+#include "flutter/fml/macros.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkImageInfo.h"
+
+namespace uiwidgets {
+
+// Shares decoded and uploaded images between codecs decoding the same encoded
+// bytes to the same target dimensions, such as the icons of a grid.
+//
+// Entries are keyed by a 128 bit digest of the encoded bytes, made of two
+// independent hashes, so that equal images are recognized whatever buffer
+// they were loaded into without keeping or comparing the bytes. The cache is
+// owned by the ImageDecoder and, like it, only used on the UI thread.
+class DecodedImageCache {
+ public:
+  struct Key {
+    size_t data_hash;
+    uint64_t data_digest;
+    size_t data_size;
+    uint32_t target_width;
+    uint32_t target_height;
+    // Raw pixel data is also keyed by its layout, zero for encoded images.
+    size_t image_info_hash;
+
+    bool operator==(const Key& other) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  // A |max_bytes| of zero disables the cache.
+  explicit DecodedImageCache(size_t max_bytes);
+
+  ~DecodedImageCache();
+
+  // Zero dimensions mean the image is not resized. Hashes the whole of
+  // |data|, so it is called on a worker thread.
+  static Key MakeKey(const SkData& data, uint32_t target_width,
+                     uint32_t target_height, const SkImageInfo* image_info,
+                     size_t row_bytes);
+
+  // Returns another reference to |image|, released through the same queue.
+  static SkiaGPUObject<SkImage> Share(const SkiaGPUObject<SkImage>& image);
+
+  bool enabled() const { return max_bytes_ > 0; }
+
+  // Returns the image cached for |key|, or an empty object.
+  SkiaGPUObject<SkImage> Get(const Key& key);
+
+  void Put(const Key& key, const SkiaGPUObject<SkImage>& image);
+
+  void Clear();
+
+  // Reports the hit, miss and eviction counts since the last call, and resets
+  // them. Called once per frame.
+  void TraceStatsToTimeline();
+
+ private:
+  struct Entry {
+    Key key;
+    SkiaGPUObject<SkImage> image;
+    size_t bytes;
+  };
+
+  // Most recently used first.
+  using LRUList = std::list<Entry>;
+
+  const size_t max_bytes_;
+  LRUList lru_;
+  std::unordered_map<Key, LRUList::iterator, KeyHash> index_;
+  size_t bytes_ = 0;
+
+  size_t hit_count_ = 0;
+  size_t miss_count_ = 0;
+  size_t eviction_count_ = 0;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(DecodedImageCache);
+};
+
+}  // namespace uiwidgets
@@ -1,9 +1,11 @@
 #include "image_decoder.h"
 
 #include <algorithm>
+#include <thread>
 
 #include "flutter/fml/make_copyable.h"
 #include "include/codec/SkCodec.h"
+#include "lib/ui/painting/image_resizer.h"
 #include "src/codec/SkCodecImageGenerator.h"
 
 namespace uiwidgets {
@@ -11,19 +13,32 @@ namespace {
 
 constexpr double kAspectRatioChangedThreshold = 0.01;
 
+// Textures are released on the raster thread after the same delay as the
+// resources of the IO thread.
+constexpr fml::TimeDelta kRasterUnrefQueueDrainDelay =
+    fml::TimeDelta::FromMilliseconds(8);
+
 }  // namespace
 
 ImageDecoder::ImageDecoder(
     TaskRunners runners,
     std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner,
-    fml::WeakPtr<IOManager> io_manager)
+    fml::WeakPtr<IOManager> io_manager,
+    fml::WeakPtr<SnapshotDelegate> snapshot_delegate, size_t cache_max_bytes,
+    ImageResizeQuality resize_quality, size_t max_concurrent_decodes)
     : runners_(std::move(runners)),
       concurrent_task_runner_(std::move(concurrent_task_runner)),
       io_manager_(std::move(io_manager)),
+      snapshot_delegate_(std::move(snapshot_delegate)),
+      raster_unref_queue_(fml::MakeRefCounted<SkiaUnrefQueue>(
+          runners_.GetRasterTaskRunner(), kRasterUnrefQueueDrainDelay)),
+      cache_(cache_max_bytes),
+      resize_quality_(resize_quality),
       weak_factory_(this) {
   FML_DCHECK(runners_.IsValid());
   FML_DCHECK(runners_.GetUITaskRunner()->RunsTasksOnCurrentThread())
       << "The image decoder must be created & collected on the UI thread.";
+  SetMaxConcurrentDecodes(max_concurrent_decodes);
 }
 
 ImageDecoder::~ImageDecoder() = default;
@@ -64,6 +79,7 @@ static SkISize GetResizedDimensions(SkISize current_size,
 
 static sk_sp<SkImage> ResizeRasterImage(sk_sp<SkImage> image,
                                         const SkISize& resized_dimensions,
+                                        ImageResizeQuality quality,
                                         const fml::tracing::TraceFlow& flow) {
   FML_DCHECK(!image->isTextureBacked());
 
@@ -102,29 +118,10 @@ static sk_sp<SkImage> ResizeRasterImage(sk_sp<SkImage> image,
         << "Aspect ratio changes. Are cache(Height|Width) used correctly?";
   }
 
-  const auto scaled_image_info =
-      image->imageInfo().makeDimensions(resized_dimensions);
-
-  SkBitmap scaled_bitmap;
-  if (!scaled_bitmap.tryAllocPixels(scaled_image_info)) {
-    FML_LOG(ERROR) << "Failed to allocate memory for bitmap of size "
-                   << scaled_image_info.computeMinByteSize() << "B";
-    return nullptr;
-  }
-
-  if (!image->scalePixels(scaled_bitmap.pixmap(), kLow_SkFilterQuality,
-                          SkImage::kDisallow_CachingHint)) {
-    FML_LOG(ERROR) << "Could not scale pixels";
-    return nullptr;
-  }
-
-  // Marking this as immutable makes the MakeFromBitmap call share the pixels
-  // instead of copying.
-  scaled_bitmap.setImmutable();
-
-  auto scaled_image = SkImage::MakeFromBitmap(scaled_bitmap);
+  auto scaled_image =
+      ImageResizer::Resize(std::move(image), resized_dimensions, quality);
   if (!scaled_image) {
-    FML_LOG(ERROR) << "Could not create a scaled image from a scaled bitmap.";
+    FML_LOG(ERROR) << "Could not resize image.";
     return nullptr;
   }
 
@@ -134,7 +131,7 @@ static sk_sp<SkImage> ResizeRasterImage(sk_sp<SkImage> image,
 static sk_sp<SkImage> ImageFromDecompressedData(
     sk_sp<SkData> data, ImageDecoder::ImageInfo info,
     std::optional<uint32_t> target_width, std::optional<uint32_t> target_height,
-    const fml::tracing::TraceFlow& flow) {
+    ImageResizeQuality quality, const fml::tracing::TraceFlow& flow) {
   TRACE_EVENT0("uiwidgets", __FUNCTION__);
   flow.Step(__FUNCTION__);
   auto image = SkImage::MakeRasterData(info.sk_info, data, info.row_bytes);
@@ -152,12 +149,14 @@ static sk_sp<SkImage> ImageFromDecompressedData(
   auto resized_dimensions =
       GetResizedDimensions(image->dimensions(), target_width, target_height);
 
-  return ResizeRasterImage(std::move(image), resized_dimensions, flow);
+  return ResizeRasterImage(std::move(image), resized_dimensions, quality,
+                           flow);
 }
 
 sk_sp<SkImage> ImageFromCompressedData(sk_sp<SkData> data,
                                        std::optional<uint32_t> target_width,
                                        std::optional<uint32_t> target_height,
+                                       ImageResizeQuality quality,
                                        const fml::tracing::TraceFlow& flow) {
   TRACE_EVENT0("uiwidgets", __FUNCTION__);
   flow.Step(__FUNCTION__);
@@ -226,7 +225,7 @@ sk_sp<SkImage> ImageFromCompressedData(sk_sp<SkData> data,
         return nullptr;
       }
       return ResizeRasterImage(std::move(decoded_image), resized_dimensions,
-                               flow);
+                               quality, flow);
     }
   }
 
@@ -235,7 +234,8 @@ sk_sp<SkImage> ImageFromCompressedData(sk_sp<SkData> data,
     return nullptr;
   }
 
-  return ResizeRasterImage(std::move(image), resized_dimensions, flow);
+  return ResizeRasterImage(std::move(image), resized_dimensions, quality,
+                           flow);
 }
 
 static SkiaGPUObject<SkImage> UploadRasterImage(
@@ -293,8 +293,310 @@ static SkiaGPUObject<SkImage> UploadRasterImage(
   return result;
 }
 
-void ImageDecoder::Decode(ImageDescriptor descriptor,
-                          const ImageResult& callback) {
+void ImageDecoder::UploadOnIOThread(sk_sp<SkImage> decompressed,
+                                    fml::RefPtr<fml::TaskRunner> io_runner,
+                                    fml::WeakPtr<IOManager> io_manager,
+                                    DecodeResult result,
+                                    fml::tracing::TraceFlow flow) {
+  io_runner->PostTask(fml::MakeCopyable([io_manager, decompressed, result,
+                                         flow = std::move(flow)]() mutable {
+    if (!io_manager) {
+      FML_LOG(ERROR) << "Could not acquire IO manager.";
+      return result({}, std::move(flow));
+    }
+
+    // If the IO manager does not have a resource context, the caller
+    // might not have set one or a software backend could be in use.
+    // Either way, just return the image as-is.
+    if (!io_manager->GetResourceContext()) {
+      result({std::move(decompressed), io_manager->GetSkiaUnrefQueue()},
+             std::move(flow));
+      return;
+    }
+
+    auto uploaded =
+        UploadRasterImage(std::move(decompressed), io_manager, flow);
+
+    if (!uploaded.get()) {
+      FML_LOG(ERROR) << "Could not upload image to the GPU.";
+      result({}, std::move(flow));
+      return;
+    }
+
+    // Finally, all done.
+    result(std::move(uploaded), std::move(flow));
+  }));
+}
+
+static sk_sp<SkImage> ImageFromCompressedTexture(
+    const CompressedTexture& texture, int level,
+    std::optional<uint32_t> target_width, std::optional<uint32_t> target_height,
+    ImageResizeQuality quality, const fml::tracing::TraceFlow& flow) {
+  TRACE_EVENT0("uiwidgets", __FUNCTION__);
+  flow.Step(__FUNCTION__);
+
+  auto image = texture.Decompress(level);
+  if (!image || (!target_width && !target_height)) {
+    return image;
+  }
+
+  auto resized_dimensions =
+      GetResizedDimensions(texture.dimensions(), target_width, target_height);
+  if (resized_dimensions == image->dimensions()) {
+    return image;
+  }
+
+  return ResizeRasterImage(std::move(image), resized_dimensions, quality,
+                           flow);
+}
+
+ImageDecoder::RequestId ImageDecoder::Decode(ImageDescriptor descriptor,
+                                             const ImageResult& callback,
+                                             Priority priority) {
+  FML_DCHECK(callback);
+  FML_DCHECK(runners_.GetUITaskRunner()->RunsTasksOnCurrentThread());
+
+  const RequestId request_id = next_request_id_++;
+
+  if (!cache_.enabled() || !descriptor.data || descriptor.data->size() == 0) {
+    Enqueue(request_id, std::move(descriptor), callback, priority,
+            std::nullopt);
+    return request_id;
+  }
+
+  // The key hashes all of the encoded bytes, which is left to a worker.
+  concurrent_task_runner_->PostTask(
+      [decoder = GetWeakPtr(), ui_runner = runners_.GetUITaskRunner(),
+       request_id, data = descriptor.data,
+       target_width = descriptor.target_width.value_or(0),
+       target_height = descriptor.target_height.value_or(0),
+       image_info = descriptor.decompressed_image_info]() {
+        auto key = DecodedImageCache::MakeKey(
+            *data, target_width, target_height,
+            image_info ? &image_info->sk_info : nullptr,
+            image_info ? image_info->row_bytes : 0);
+        ui_runner->PostTask([decoder, request_id, key]() {
+          if (decoder) {
+            decoder->OnKeyComputed(request_id, key);
+          }
+        });
+      });
+  key_requests_[request_id] = {std::move(descriptor), priority, callback};
+  return request_id;
+}
+
+void ImageDecoder::OnKeyComputed(RequestId request_id,
+                                 DecodedImageCache::Key key) {
+  FML_DCHECK(runners_.GetUITaskRunner()->RunsTasksOnCurrentThread());
+
+  auto found = key_requests_.find(request_id);
+  if (found == key_requests_.end()) {
+    // Cancelled meanwhile.
+    return;
+  }
+  KeyRequest request = std::move(found->second);
+  key_requests_.erase(found);
+  Enqueue(request_id, std::move(request.descriptor), request.result,
+          request.priority, key);
+}
+
+void ImageDecoder::Enqueue(RequestId request_id, ImageDescriptor descriptor,
+                           const ImageResult& callback, Priority priority,
+                           std::optional<DecodedImageCache::Key> key) {
+  if (key) {
+    SkiaGPUObject<SkImage> cached = cache_.Get(*key);
+    if (cached.get()) {
+      // Callers expect the result after Decode returns.
+      runners_.GetUITaskRunner()->PostTask(fml::MakeCopyable(
+          [callback, image = std::move(cached)]() mutable {
+            callback(std::move(image));
+          }));
+      return;
+    }
+
+    auto pending = pending_decodes_.find(*key);
+    if (pending != pending_decodes_.end()) {
+      Job& job = jobs_[pending->second];
+      job.requests.push_back({request_id, priority, callback});
+      request_jobs_[request_id] = pending->second;
+      UpdateJobPriority(pending->second, job);
+      return;
+    }
+  }
+
+  const JobId job_id = next_job_id_++;
+  Job& job = jobs_[job_id];
+  if (key) {
+    pending_decodes_[*key] = job_id;
+  }
+  job.descriptor = std::move(descriptor);
+  job.key = key;
+  job.requests.push_back({request_id, priority, callback});
+  job.priority = priority;
+  request_jobs_[request_id] = job_id;
+  queue_.insert({priority, job_id});
+
+  StartQueuedDecodes();
+}
+
+void ImageDecoder::Reprioritize(RequestId request_id, Priority priority) {
+  FML_DCHECK(runners_.GetUITaskRunner()->RunsTasksOnCurrentThread());
+
+  auto key_request = key_requests_.find(request_id);
+  if (key_request != key_requests_.end()) {
+    key_request->second.priority = priority;
+    return;
+  }
+
+  auto found = request_jobs_.find(request_id);
+  if (found == request_jobs_.end()) {
+    return;
+  }
+  Job& job = jobs_[found->second];
+  for (Request& request : job.requests) {
+    if (request.id == request_id) {
+      request.priority = priority;
+    }
+  }
+  UpdateJobPriority(found->second, job);
+}
+
+bool ImageDecoder::Cancel(RequestId request_id) {
+  FML_DCHECK(runners_.GetUITaskRunner()->RunsTasksOnCurrentThread());
+
+  auto key_request = key_requests_.find(request_id);
+  if (key_request != key_requests_.end()) {
+    runners_.GetUITaskRunner()->PostTask(
+        [callback = std::move(key_request->second.result)]() {
+          callback({});
+        });
+    key_requests_.erase(key_request);
+    return true;
+  }
+
+  auto found = request_jobs_.find(request_id);
+  if (found == request_jobs_.end()) {
+    return false;
+  }
+  const JobId job_id = found->second;
+  request_jobs_.erase(found);
+
+  Job& job = jobs_[job_id];
+  auto request = std::find_if(
+      job.requests.begin(), job.requests.end(),
+      [request_id](const Request& entry) { return entry.id == request_id; });
+  FML_DCHECK(request != job.requests.end());
+  runners_.GetUITaskRunner()->PostTask(
+      [callback = std::move(request->result)]() { callback({}); });
+  job.requests.erase(request);
+
+  if (job.started) {
+    return true;
+  }
+
+  if (job.requests.empty()) {
+    TRACE_EVENT0("uiwidgets", "ImageDecoder::CancelDecode");
+    queue_.erase({job.priority, job_id});
+    if (job.key) {
+      pending_decodes_.erase(*job.key);
+    }
+    jobs_.erase(job_id);
+  } else {
+    UpdateJobPriority(job_id, job);
+  }
+  return true;
+}
+
+void ImageDecoder::SetMaxConcurrentDecodes(size_t count) {
+  FML_DCHECK(runners_.GetUITaskRunner()->RunsTasksOnCurrentThread());
+
+  max_concurrent_decodes_ =
+      count > 0 ? count
+                : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  StartQueuedDecodes();
+}
+
+void ImageDecoder::UpdateJobPriority(JobId job_id, Job& job) {
+  if (job.started || job.requests.empty()) {
+    return;
+  }
+
+  Priority priority = job.requests.front().priority;
+  for (const Request& request : job.requests) {
+    priority = std::min(priority, request.priority);
+  }
+  if (priority == job.priority) {
+    return;
+  }
+
+  queue_.erase({job.priority, job_id});
+  job.priority = priority;
+  queue_.insert({priority, job_id});
+}
+
+void ImageDecoder::StartQueuedDecodes() {
+  while (running_decodes_ < max_concurrent_decodes_ && !queue_.empty()) {
+    const JobId job_id = queue_.begin()->second;
+    queue_.erase(queue_.begin());
+
+    Job& job = jobs_[job_id];
+    job.started = true;
+    running_decodes_++;
+
+    // The encoded data is released by the decode once it is done with it.
+    DecodeUncached(std::move(job.descriptor),
+                   [decoder = GetWeakPtr(), job_id](auto image) {
+                     if (decoder) {
+                       decoder->OnDecodeComplete(job_id, std::move(image));
+                     }
+                   });
+  }
+}
+
+void ImageDecoder::OnDecodeComplete(JobId job_id,
+                                    SkiaGPUObject<SkImage> image) {
+  FML_DCHECK(runners_.GetUITaskRunner()->RunsTasksOnCurrentThread());
+
+  auto found = jobs_.find(job_id);
+  FML_DCHECK(found != jobs_.end());
+  Job job = std::move(found->second);
+  jobs_.erase(found);
+  running_decodes_--;
+
+  if (job.key) {
+    pending_decodes_.erase(*job.key);
+    cache_.Put(*job.key, image);
+  }
+  for (const Request& request : job.requests) {
+    request_jobs_.erase(request.id);
+  }
+
+  // Other decodes may start before the results are handled, since handling
+  // them may request more decodes.
+  StartQueuedDecodes();
+
+  for (const Request& request : job.requests) {
+    request.result(DecodedImageCache::Share(image));
+  }
+}
+
+void ImageDecoder::NotifyLowMemoryWarning() { cache_.Clear(); }
+
+void ImageDecoder::TraceStatsToTimeline() {
+#if !UIWidgets_RELEASE
+  FML_TRACE_COUNTER("uiwidgets", "ImageDecoder",
+                    reinterpret_cast<int64_t>(this),    //
+                    "QueuedDecodes", queue_.size(),     //
+                    "RunningDecodes", running_decodes_  //
+  );
+#endif  // !UIWidgets_RELEASE
+  if (cache_.enabled()) {
+    cache_.TraceStatsToTimeline();
+  }
+}
+
+void ImageDecoder::DecodeUncached(ImageDescriptor descriptor,
+                                  const ImageResult& callback) {
   TRACE_EVENT0("uiwidgets", __FUNCTION__);
   fml::tracing::TraceFlow flow(__FUNCTION__);
 
@@ -320,10 +622,21 @@ void ImageDecoder::Decode(ImageDescriptor descriptor,
     return;
   }
 
+  std::unique_ptr<CompressedTexture> texture =
+      descriptor.decompressed_image_info
+          ? nullptr
+          : CompressedTexture::Parse(descriptor.data);
+  if (texture) {
+    DecodeCompressedTexture(std::move(texture), descriptor.target_width,
+                            descriptor.target_height, result, std::move(flow));
+    return;
+  }
+
   concurrent_task_runner_->PostTask(
       fml::MakeCopyable([descriptor,                              //
                          io_manager = io_manager_,                //
                          io_runner = runners_.GetIOTaskRunner(),  //
+                         resize_quality = resize_quality_,        //
                          result,                                  //
                          flow = std::move(flow)                   //
   ]() mutable {
@@ -337,11 +650,13 @@ void ImageDecoder::Decode(ImageDescriptor descriptor,
                       descriptor.decompressed_image_info.value(),  //
                       descriptor.target_width,                     //
                       descriptor.target_height,                    //
+                      resize_quality,                              //
                       flow                                         //
                       )
                 : ImageFromCompressedData(std::move(descriptor.data),  //
                                           descriptor.target_width,     //
                                           descriptor.target_height,    //
+                                          resize_quality,              //
                                           flow);
 
         if (!decompressed) {
@@ -353,35 +668,73 @@ void ImageDecoder::Decode(ImageDescriptor descriptor,
         // Step 2: Update the image to the GPU.
         // On IO Thread.
 
-        io_runner->PostTask(fml::MakeCopyable([io_manager, decompressed, result,
-                                               flow =
-                                                   std::move(flow)]() mutable {
-          if (!io_manager) {
-            FML_LOG(ERROR) << "Could not acquire IO manager.";
-            return result({}, std::move(flow));
-          }
-
-          // If the IO manager does not have a resource context, the caller
-          // might not have set one or a software backend could be in use.
-          // Either way, just return the image as-is.
-          if (!io_manager->GetResourceContext()) {
-            result({std::move(decompressed), io_manager->GetSkiaUnrefQueue()},
-                   std::move(flow));
-            return;
-          }
+        UploadOnIOThread(std::move(decompressed), std::move(io_runner),
+                         std::move(io_manager), std::move(result),
+                         std::move(flow));
+      }));
+}
 
-          auto uploaded =
-              UploadRasterImage(std::move(decompressed), io_manager, flow);
+void ImageDecoder::DecodeCompressedTexture(
+    std::unique_ptr<CompressedTexture> texture,
+    std::optional<uint32_t> target_width, std::optional<uint32_t> target_height,
+    DecodeResult result, fml::tracing::TraceFlow flow) {
+  TRACE_EVENT0("uiwidgets", __FUNCTION__);
+  flow.Step(__FUNCTION__);
 
-          if (!uploaded.get()) {
-            FML_LOG(ERROR) << "Could not upload image to the GPU.";
+  // The smallest mip level covering the target dimensions. Levels are not
+  // resized when uploaded as they are.
+  const int level = texture->GetLevelForSize(GetResizedDimensions(
+      texture->dimensions(), target_width, target_height));
+  std::shared_ptr<CompressedTexture> shared_texture = std::move(texture);
+
+  // Decompresses the texture on a worker, then uploads it on the IO thread.
+  auto decompress = [shared_texture, level, target_width, target_height,
+                     resize_quality = resize_quality_,
+                     concurrent_task_runner = concurrent_task_runner_,
+                     io_manager = io_manager_,
+                     io_runner = runners_.GetIOTaskRunner(),
+                     result](fml::tracing::TraceFlow flow) {
+    concurrent_task_runner->PostTask(fml::MakeCopyable(
+        [shared_texture, level, target_width, target_height, resize_quality,
+         io_manager, io_runner, result, flow = std::move(flow)]() mutable {
+          auto decompressed =
+              ImageFromCompressedTexture(*shared_texture, level, target_width,
+                                         target_height, resize_quality, flow);
+          if (!decompressed) {
+            FML_LOG(ERROR) << "Could not decompress texture.";
             result({}, std::move(flow));
             return;
           }
-
-          // Finally, all done.
-          result(std::move(uploaded), std::move(flow));
+          UploadOnIOThread(std::move(decompressed), std::move(io_runner),
+                           std::move(io_manager), std::move(result),
+                           std::move(flow));
         }));
+  };
+
+  const auto compression_type = shared_texture->GetCompressionType();
+  if (!compression_type) {
+    decompress(std::move(flow));
+    return;
+  }
+
+  runners_.GetRasterTaskRunner()->PostTask(fml::MakeCopyable(
+      [shared_texture, level, type = compression_type.value(),
+       snapshot_delegate = snapshot_delegate_,
+       raster_unref_queue = raster_unref_queue_, decompress, result,
+       flow = std::move(flow)]() mutable {
+        sk_sp<SkImage> image;
+        if (snapshot_delegate) {
+          image = snapshot_delegate->MakeCompressedTextureImage(
+              shared_texture->GetLevelData(level),
+              shared_texture->GetLevelDimensions(level), type);
+        }
+        if (!image) {
+          // The GPU does not support the format, or there is no GPU.
+          decompress(std::move(flow));
+          return;
+        }
+        result({std::move(image), std::move(raster_unref_queue)},
+               std::move(flow));
       }));
 }
 
@@ -2,7 +2,11 @@
 
 #include <memory>
 #include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
+#include "common/settings.h"
 #include "common/task_runners.h"
 #include "flow/skia_gpu_object.h"
 #include "flutter/fml/concurrent_message_loop.h"
@@ -15,6 +19,9 @@
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSize.h"
 #include "lib/ui/io_manager.h"
+#include "lib/ui/painting/compressed_texture.h"
+#include "lib/ui/painting/decoded_image_cache.h"
+#include "lib/ui/snapshot_delegate.h"
 
 namespace uiwidgets {
 
@@ -28,7 +35,11 @@ class ImageDecoder {
   ImageDecoder(
       TaskRunners runners,
       std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner,
-      fml::WeakPtr<IOManager> io_manager);
+      fml::WeakPtr<IOManager> io_manager,
+      fml::WeakPtr<SnapshotDelegate> snapshot_delegate,
+      size_t cache_max_bytes = 0,
+      ImageResizeQuality resize_quality = ImageResizeQuality::kMedium,
+      size_t max_concurrent_decodes = 0);
 
   ~ImageDecoder();
 
@@ -46,27 +57,158 @@ class ImageDecoder {
 
   using ImageResult = std::function<void(SkiaGPUObject<SkImage>)>;
 
+  // The order in which queued decodes are started. Decodes of the same
+  // priority are started in the order they were requested.
+  enum class Priority {
+    // Images on screen.
+    kVisible,
+    // Images about to be scrolled into view.
+    kPrefetch,
+    // Images that are not expected to be shown soon.
+    kBackground,
+  };
+
+  // Identifies a call to Decode, to reprioritize or cancel it. Never zero.
+  using RequestId = uint64_t;
+
   // Takes an image descriptor and returns a handle to a texture resident on the
   // GPU. All image decompression and resizes are done on a worker thread
   // concurrently. Texture upload is done on the IO thread and the result
   // returned back on the UI thread. On error, the texture is null but the
   // callback is guaranteed to return on the UI thread.
-  void Decode(ImageDescriptor descriptor, const ImageResult& result);
+  //
+  // Images decoded from the same bytes to the same dimensions are shared
+  // through a DecodedImageCache, and concurrent decodes of the same image
+  // are performed once. The cache key is computed on a worker thread before
+  // the request is queued.
+  //
+  // GPU compressed textures in KTX, KTX2 or DDS containers are uploaded as
+  // they are on the raster thread when the GPU supports their format, using
+  // the mip level closest to the target dimensions, and are decompressed on
+  // a worker thread otherwise.
+  //
+  // Decodes are queued by priority, and at most |max_concurrent_decodes| of
+  // them are in progress at once.
+  RequestId Decode(ImageDescriptor descriptor, const ImageResult& result,
+                   Priority priority = Priority::kVisible);
+
+  // Changes the priority of a request. A decode shared by several requests
+  // takes the highest priority among them. Has no effect once the decode has
+  // started.
+  void Reprioritize(RequestId request, Priority priority);
+
+  // Answers the request with a null texture, on the UI thread. The decode is
+  // dropped if it has not started and no other request shares it; otherwise
+  // it runs to completion. Returns false if the request was already
+  // answered.
+  bool Cancel(RequestId request);
+
+  // A |count| of zero allows as many decodes as there are worker threads.
+  void SetMaxConcurrentDecodes(size_t count);
+
+  // Drops the cached images.
+  void NotifyLowMemoryWarning();
+
+  // Reports the statistics of the decode queue and of the decoded image cache.
+  // Called once per frame.
+  void TraceStatsToTimeline();
 
   fml::WeakPtr<ImageDecoder> GetWeakPtr() const;
 
  private:
+  using JobId = uint64_t;
+
+  struct Request {
+    RequestId id;
+    Priority priority;
+    ImageResult result;
+  };
+
+  // A request waiting for its cache key.
+  struct KeyRequest {
+    ImageDescriptor descriptor;
+    Priority priority;
+    ImageResult result;
+  };
+
+  // A decode, shared by the requests for the same image.
+  struct Job {
+    ImageDescriptor descriptor;
+    // Set when the result is shared through the decoded image cache.
+    std::optional<DecodedImageCache::Key> key;
+    std::vector<Request> requests;
+    Priority priority = Priority::kVisible;
+    bool started = false;
+  };
+
+  using DecodeResult =
+      std::function<void(SkiaGPUObject<SkImage>, fml::tracing::TraceFlow)>;
+
   TaskRunners runners_;
   std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner_;
   fml::WeakPtr<IOManager> io_manager_;
+  fml::WeakPtr<SnapshotDelegate> snapshot_delegate_;
+  // Collects the compressed textures uploaded on the raster thread.
+  fml::RefPtr<SkiaUnrefQueue> raster_unref_queue_;
+  DecodedImageCache cache_;
+  // How images decoded to a target size are resized, see ImageResizer.
+  const ImageResizeQuality resize_quality_;
+  std::unordered_map<RequestId, KeyRequest> key_requests_;
+  // The decodes queued or in progress, and the requests waiting for them.
+  std::unordered_map<JobId, Job> jobs_;
+  std::unordered_map<RequestId, JobId> request_jobs_;
+  // The decodes waiting to start, highest priority first. Job ids increase,
+  // so jobs of the same priority are in request order.
+  std::set<std::pair<Priority, JobId>> queue_;
+  // The decodes of cached images queued or in progress, by cache key.
+  std::unordered_map<DecodedImageCache::Key, JobId,
+                     DecodedImageCache::KeyHash>
+      pending_decodes_;
+  JobId next_job_id_ = 1;
+  RequestId next_request_id_ = 1;
+  size_t max_concurrent_decodes_ = 0;
+  size_t running_decodes_ = 0;
   fml::WeakPtrFactory<ImageDecoder> weak_factory_;
 
+  void DecodeUncached(ImageDescriptor descriptor, const ImageResult& result);
+
+  void OnKeyComputed(RequestId request_id, DecodedImageCache::Key key);
+
+  // Answers the request from the cache, adds it to a pending decode of the
+  // same image, or queues a new decode.
+  void Enqueue(RequestId request_id, ImageDescriptor descriptor,
+               const ImageResult& result, Priority priority,
+               std::optional<DecodedImageCache::Key> key);
+
+  // Starts queued decodes while fewer than the maximum are in progress.
+  void StartQueuedDecodes();
+
+  void OnDecodeComplete(JobId job_id, SkiaGPUObject<SkImage> image);
+
+  // Requeues a job that has not started at the highest priority of its
+  // requests.
+  void UpdateJobPriority(JobId job_id, Job& job);
+
+  void DecodeCompressedTexture(std::unique_ptr<CompressedTexture> texture,
+                               std::optional<uint32_t> target_width,
+                               std::optional<uint32_t> target_height,
+                               DecodeResult result,
+                               fml::tracing::TraceFlow flow);
+
+  // Uploads a decompressed image to the GPU on the IO thread.
+  static void UploadOnIOThread(sk_sp<SkImage> decompressed,
+                               fml::RefPtr<fml::TaskRunner> io_runner,
+                               fml::WeakPtr<IOManager> io_manager,
+                               DecodeResult result,
+                               fml::tracing::TraceFlow flow);
+
   FML_DISALLOW_COPY_AND_ASSIGN(ImageDecoder);
 };
 
 sk_sp<SkImage> ImageFromCompressedData(sk_sp<SkData> data,
                                        std::optional<uint32_t> target_width,
                                        std::optional<uint32_t> target_height,
+                                       ImageResizeQuality quality,
                                        const fml::tracing::TraceFlow& flow);
 
 }  // namespace uiwidgets
@@ -0,0 +1,311 @@
+#include "image_resizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "flutter/fml/logging.h"
+#include "flutter/fml/trace_event.h"
+
+namespace uiwidgets {
+
+namespace {
+
+constexpr int kChannels = 4;
+// Both RGBA and BGRA pixels keep their alpha in the last byte.
+constexpr int kAlphaChannel = 3;
+constexpr int kLanczosLobes = 3;
+
+double Sinc(double x) {
+  if (x == 0) {
+    return 1;
+  }
+  x *= M_PI;
+  return std::sin(x) / x;
+}
+
+double Lanczos(double x) {
+  if (std::abs(x) >= kLanczosLobes) {
+    return 0;
+  }
+  return Sinc(x) * Sinc(x / kLanczosLobes);
+}
+
+// The normalized filter weights of the source pixels contributing to each
+// destination pixel along one axis.
+struct FilterWeights {
+  std::vector<int> start;
+  std::vector<int> count;
+  // |max_count| weights per destination pixel.
+  std::vector<float> weights;
+  int max_count = 0;
+};
+
+FilterWeights ComputeLanczosWeights(int src_size, int dst_size) {
+  const double scale = static_cast<double>(src_size) / dst_size;
+  // The filter is stretched when reducing, so that it covers every source
+  // pixel.
+  const double filter_scale = std::max(scale, 1.0);
+  const double support = kLanczosLobes * filter_scale;
+
+  FilterWeights result;
+  result.max_count = static_cast<int>(std::ceil(support)) * 2 + 1;
+  result.start.resize(dst_size);
+  result.count.resize(dst_size);
+  result.weights.resize(dst_size * result.max_count);
+  for (int d = 0; d < dst_size; d++) {
+    const double center = (d + 0.5) * scale - 0.5;
+    const int start =
+        std::max(static_cast<int>(std::floor(center - support)) + 1, 0);
+    const int end = std::min(static_cast<int>(std::floor(center + support)),
+                             src_size - 1);
+    float* weights = &result.weights[d * result.max_count];
+    double total = 0;
+    int count = 0;
+    for (int s = start; s <= end && count < result.max_count; s++, count++) {
+      const double weight = Lanczos((s - center) / filter_scale);
+      weights[count] = static_cast<float>(weight);
+      total += weight;
+    }
+    if (total != 0) {
+      for (int i = 0; i < count; i++) {
+        weights[i] = static_cast<float>(weights[i] / total);
+      }
+    }
+    result.start[d] = start;
+    result.count[d] = count;
+  }
+  return result;
+}
+
+uint8_t ClampToByte(float value) {
+  return static_cast<uint8_t>(std::min(std::max(value + 0.5f, 0.0f), 255.0f));
+}
+
+}  // namespace
+
+bool ImageResizer::CanFilter(const SkImageInfo& info) {
+  return (info.colorType() == kRGBA_8888_SkColorType ||
+          info.colorType() == kBGRA_8888_SkColorType) &&
+         (info.alphaType() == kPremul_SkAlphaType ||
+          info.alphaType() == kOpaque_SkAlphaType);
+}
+
+sk_sp<SkImage> ImageResizer::Resize(sk_sp<SkImage> image, SkISize dimensions,
+                                    ImageResizeQuality quality) {
+  TRACE_EVENT0("uiwidgets", "ImageResizer::Resize");
+
+  SkPixmap pixmap;
+  if (!image->peekPixels(&pixmap)) {
+    // Lazy images are decoded once, rather than by every pass.
+    image = image->makeRasterImage();
+    if (!image || !image->peekPixels(&pixmap)) {
+      FML_LOG(ERROR) << "Could not read pixels of image to resize.";
+      return nullptr;
+    }
+  }
+
+  if (quality == ImageResizeQuality::kLow) {
+    return ScalePixels(pixmap, dimensions, kLow_SkFilterQuality);
+  }
+
+  if (!CanFilter(pixmap.info())) {
+    return ScalePixels(pixmap, dimensions,
+                       quality == ImageResizeQuality::kHigh
+                           ? kHigh_SkFilterQuality
+                           : kMedium_SkFilterQuality);
+  }
+
+  // The bilinear pass of the medium quality blends at most 2x2 pixels, so
+  // the box filter takes the whole integer reduction. The Lanczos pass
+  // handles reductions itself, and the box filter only bounds its cost.
+  const double scale_x =
+      static_cast<double>(pixmap.width()) / dimensions.width();
+  const double scale_y =
+      static_cast<double>(pixmap.height()) / dimensions.height();
+  const int divisor = quality == ImageResizeQuality::kHigh ? 2 : 1;
+  const int factor_x = std::max(static_cast<int>(scale_x / divisor), 1);
+  const int factor_y = std::max(static_cast<int>(scale_y / divisor), 1);
+
+  SkBitmap reduced;
+  if (factor_x > 1 || factor_y > 1) {
+    if (!BoxDownsample(pixmap, factor_x, factor_y, &reduced)) {
+      return nullptr;
+    }
+    pixmap = reduced.pixmap();
+  }
+
+  if (!reduced.isNull() && pixmap.dimensions() == dimensions) {
+    reduced.setImmutable();
+    return SkImage::MakeFromBitmap(reduced);
+  }
+
+  if (quality == ImageResizeQuality::kMedium) {
+    return ScalePixels(pixmap, dimensions, kLow_SkFilterQuality);
+  }
+
+  SkBitmap resampled;
+  if (!resampled.tryAllocPixels(pixmap.info().makeDimensions(dimensions))) {
+    FML_LOG(ERROR) << "Failed to allocate memory for bitmap of size "
+                   << resampled.info().computeMinByteSize() << "B";
+    return nullptr;
+  }
+  LanczosResample(pixmap, resampled.pixmap());
+
+  // Marking this as immutable makes the MakeFromBitmap call share the pixels
+  // instead of copying.
+  resampled.setImmutable();
+  return SkImage::MakeFromBitmap(resampled);
+}
+
+bool ImageResizer::BoxDownsample(const SkPixmap& src, int factor_x,
+                                 int factor_y, SkBitmap* dst) {
+  TRACE_EVENT0("uiwidgets", "ImageResizer::BoxDownsample");
+
+  const int src_width = src.width();
+  const int src_height = src.height();
+  const int dst_width = (src_width + factor_x - 1) / factor_x;
+  const int dst_height = (src_height + factor_y - 1) / factor_y;
+  if (!dst->tryAllocPixels(src.info().makeWH(dst_width, dst_height))) {
+    FML_LOG(ERROR) << "Failed to allocate memory for bitmap of size "
+                   << dst->info().computeMinByteSize() << "B";
+    return false;
+  }
+
+  // Rows are first summed into a row of channel sums, then the columns of
+  // each block are summed from it.
+  std::vector<uint32_t> column_sums(src_width * kChannels);
+  for (int dy = 0; dy < dst_height; dy++) {
+    const int y0 = dy * factor_y;
+    const int y1 = std::min(y0 + factor_y, src_height);
+    std::fill(column_sums.begin(), column_sums.end(), 0);
+    for (int y = y0; y < y1; y++) {
+      const uint8_t* row = static_cast<const uint8_t*>(src.addr(0, y));
+      uint32_t* sums = column_sums.data();
+      for (int i = 0; i < src_width * kChannels; i++) {
+        sums[i] += row[i];
+      }
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(dst->getAddr(0, dy));
+    for (int dx = 0; dx < dst_width; dx++) {
+      const int x0 = dx * factor_x;
+      const int x1 = std::min(x0 + factor_x, src_width);
+      uint32_t block[kChannels] = {};
+      for (int x = x0; x < x1; x++) {
+        for (int c = 0; c < kChannels; c++) {
+          block[c] += column_sums[x * kChannels + c];
+        }
+      }
+      const uint32_t count = (x1 - x0) * (y1 - y0);
+      for (int c = 0; c < kChannels; c++) {
+        out[dx * kChannels + c] =
+            static_cast<uint8_t>((block[c] + count / 2) / count);
+      }
+    }
+  }
+  return true;
+}
+
+void ImageResizer::LanczosResample(const SkPixmap& src, const SkPixmap& dst) {
+  TRACE_EVENT0("uiwidgets", "ImageResizer::LanczosResample");
+
+  const int src_height = src.height();
+  const int dst_width = dst.width();
+  const int dst_height = dst.height();
+  const FilterWeights horizontal =
+      ComputeLanczosWeights(src.width(), dst_width);
+  const FilterWeights vertical = ComputeLanczosWeights(src_height, dst_height);
+
+  // Horizontally filtered source rows, in float channels. The rows used by
+  // a destination row never move backwards and span at most
+  // |vertical.max_count| rows, so only that many are kept, in a ring indexed
+  // by source row.
+  const int row_channels = dst_width * kChannels;
+  const int window = vertical.max_count;
+  std::vector<float> rows(static_cast<size_t>(window) * row_channels);
+  auto row_at = [&](int y) { return &rows[(y % window) * row_channels]; };
+  int filtered_rows = 0;
+
+  const bool premul = dst.alphaType() == kPremul_SkAlphaType;
+  std::vector<float> sums(row_channels);
+  for (int dy = 0; dy < dst_height; dy++) {
+    // Horizontal pass, over the source rows not filtered yet.
+    const int end = vertical.start[dy] + vertical.count[dy];
+    for (; filtered_rows < end; filtered_rows++) {
+      const uint8_t* in =
+          static_cast<const uint8_t*>(src.addr(0, filtered_rows));
+      float* out = row_at(filtered_rows);
+      for (int dx = 0; dx < dst_width; dx++) {
+        const float* weights = &horizontal.weights[dx * horizontal.max_count];
+        const uint8_t* pixel = in + horizontal.start[dx] * kChannels;
+        float sum[kChannels] = {};
+        for (int i = 0; i < horizontal.count[dx]; i++) {
+          for (int c = 0; c < kChannels; c++) {
+            sum[c] += weights[i] * pixel[i * kChannels + c];
+          }
+        }
+        for (int c = 0; c < kChannels; c++) {
+          out[dx * kChannels + c] = sum[c];
+        }
+      }
+    }
+
+    // Vertical pass, over whole rows.
+    const float* weights = &vertical.weights[dy * vertical.max_count];
+    std::fill(sums.begin(), sums.end(), 0.0f);
+    for (int i = 0; i < vertical.count[dy]; i++) {
+      const float weight = weights[i];
+      const float* row = row_at(vertical.start[dy] + i);
+      float* out = sums.data();
+      for (int j = 0; j < row_channels; j++) {
+        out[j] += weight * row[j];
+      }
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(dst.writable_addr(0, dy));
+    for (int j = 0; j < row_channels; j++) {
+      out[j] = ClampToByte(sums[j]);
+    }
+    if (premul) {
+      // The negative lobes may overshoot, and premultiplied colors may not
+      // exceed their alpha.
+      for (int x = 0; x < dst_width; x++) {
+        uint8_t* pixel = out + x * kChannels;
+        const uint8_t alpha = pixel[kAlphaChannel];
+        for (int c = 0; c < kChannels; c++) {
+          pixel[c] = std::min(pixel[c], alpha);
+        }
+      }
+    } else {
+      for (int x = 0; x < dst_width; x++) {
+        out[x * kChannels + kAlphaChannel] = 0xFF;
+      }
+    }
+  }
+}
+
+sk_sp<SkImage> ImageResizer::ScalePixels(const SkPixmap& src,
+                                         SkISize dimensions,
+                                         SkFilterQuality filter_quality) {
+  const auto scaled_image_info = src.info().makeDimensions(dimensions);
+
+  SkBitmap scaled_bitmap;
+  if (!scaled_bitmap.tryAllocPixels(scaled_image_info)) {
+    FML_LOG(ERROR) << "Failed to allocate memory for bitmap of size "
+                   << scaled_image_info.computeMinByteSize() << "B";
+    return nullptr;
+  }
+
+  if (!src.scalePixels(scaled_bitmap.pixmap(), filter_quality)) {
+    FML_LOG(ERROR) << "Could not scale pixels";
+    return nullptr;
+  }
+
+  // Marking this as immutable makes the MakeFromBitmap call share the pixels
+  // instead of copying.
+  scaled_bitmap.setImmutable();
+  return SkImage::MakeFromBitmap(scaled_bitmap);
+}
+
+}  // namespace uiwidgets
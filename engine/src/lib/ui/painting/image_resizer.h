@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common/settings.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkSize.h"
+
+namespace uiwidgets {
+
+// Resizes raster images on the CPU, for the image decoder.
+//
+// Large reductions are first box filtered by an integer factor, which
+// averages every source pixel once, then finished by bilinear sampling or a
+// Lanczos filter depending on |quality|. The filters run on 8 bits per channel
+// premultiplied or opaque pixels, with loops laid out over contiguous
+// channels so that they vectorize. Other pixel formats are resized by Skia.
+class ImageResizer {
+ public:
+  // Returns null if |image| could not be read or resized.
+  static sk_sp<SkImage> Resize(sk_sp<SkImage> image, SkISize dimensions,
+                               ImageResizeQuality quality);
+
+ private:
+  static bool CanFilter(const SkImageInfo& info);
+
+  // Averages blocks of |factor_x| by |factor_y| pixels. Blocks on the right
+  // and bottom edges may be partial.
+  static bool BoxDownsample(const SkPixmap& src, int factor_x, int factor_y,
+                            SkBitmap* dst);
+
+  // Resamples |src| into |dst| with a separable Lanczos filter of three
+  // lobes.
+  static void LanczosResample(const SkPixmap& src, const SkPixmap& dst);
+
+  static sk_sp<SkImage> ScalePixels(const SkPixmap& src, SkISize dimensions,
+                                    SkFilterQuality filter_quality);
+};
+
+}  // namespace uiwidgets
@@ -1,8 +1,12 @@
 #include "multi_frame_codec.h"
 
+#include <algorithm>
+
 #include "flutter/fml/make_copyable.h"
+#include "flutter/fml/trace_event.h"
 #include "include/core/SkPixelRef.h"
 #include "lib/ui/ui_mono_state.h"
+#include "lib/ui/window/window.h"
 
 namespace uiwidgets {
 
@@ -14,12 +18,19 @@ MultiFrameCodec::~MultiFrameCodec() = default;
 MultiFrameCodec::State::State(std::unique_ptr<SkCodec> codec)
     : codec_(std::move(codec)),
       frameCount_(codec_->getFrameCount()),
-      repetitionCount_(codec_->getRepetitionCount()),
-      nextFrameIndex_(0) {}
+      repetitionCount_(codec_->getRepetitionCount()) {
+  auto* mono_state = UIMonoState::Current();
+  const auto& task_runners = mono_state->GetTaskRunners();
+  ui_task_runner_ = task_runners.GetUITaskRunner();
+  io_task_runner_ = task_runners.GetIOTaskRunner();
+  io_manager_ = mono_state->GetIOManager();
+  concurrent_loop_ =
+      mono_state->window()->client()->GetConcurrentMessageLoop();
+}
 
 static void InvokeNextFrameCallback(
     fml::RefPtr<FrameInfo> frameInfo,
-    std::unique_ptr<Codec::PendingCallback> callback, size_t trace_id) {
+    std::unique_ptr<Codec::PendingCallback> callback) {
   std::shared_ptr<MonoState> mono_state = callback->mono_state.lock();
   if (!mono_state) {
     FML_DLOG(ERROR) << "Could not acquire Mono state while attempting to fire "
@@ -36,83 +47,176 @@ static void InvokeNextFrameCallback(
   }
 }
 
-// Copied the source bitmap to the destination. If this cannot occur due to
-// running out of memory or the image info not being compatible, returns false.
-static bool CopyToBitmap(SkBitmap* dst, SkColorType dstColorType,
-                         const SkBitmap& src) {
-  SkPixmap srcPM;
-  if (!src.peekPixels(&srcPM)) {
+bool MultiFrameCodec::State::AllFramesCachedLocked() const {
+  return cachedFrameCount_ > 0 && cachedFrameCount_ == frameCount_;
+}
+
+bool MultiFrameCodec::State::ShouldDecodeLocked() const {
+  if (!codec_ || frameCount_ <= 0 || AllFramesCachedLocked()) {
     return false;
   }
-
-  SkBitmap tmpDst;
-  SkImageInfo dstInfo = srcPM.info().makeColorType(dstColorType);
-  if (!tmpDst.setInfo(dstInfo)) {
+  // Frames are decoded for the callbacks waiting for one, and ahead of them.
+  const size_t wanted = lookAhead_ + pendingCallbacks_.size();
+  if (decodedFrames_.size() >= wanted) {
     return false;
   }
+  return !freeBitmaps_.empty() || allocatedBitmaps_ <= lookAhead_;
+}
 
-  if (!tmpDst.tryAllocPixels()) {
-    return false;
+void MultiFrameCodec::State::ReleaseBitmapLocked(
+    std::unique_ptr<SkBitmap> bitmap) {
+  if (AllFramesCachedLocked() ||
+      static_cast<int>(freeBitmaps_.size()) > lookAhead_) {
+    allocatedBitmaps_--;
+    return;
   }
+  freeBitmaps_.push_back(std::move(bitmap));
+}
 
-  SkPixmap dstPM;
-  if (!tmpDst.peekPixels(&dstPM)) {
-    return false;
+void MultiFrameCodec::State::CacheFrameLocked(int index, sk_sp<SkImage> image,
+                                              int duration) {
+  if (!cacheAllFrames_) {
+    return;
+  }
+  if (cachedFrames_.empty()) {
+    const size_t frame_bytes = image->imageInfo().computeMinByteSize();
+    if (frame_bytes * frameCount_ > kMaxCachedFramesBytes) {
+      return;
+    }
+    cachedFrames_.resize(frameCount_);
+  }
+  CachedFrame& frame = cachedFrames_[index];
+  if (!frame.image) {
+    frame = {std::move(image), duration};
+    cachedFrameCount_++;
   }
+  if (AllFramesCachedLocked()) {
+    // The codec is no longer used, nor the bitmaps frames are decoded into.
+    for (DecodedFrame& decoded : decodedFrames_) {
+      ReleaseBitmapLocked(std::move(decoded.bitmap));
+    }
+    decodedFrames_.clear();
+    allocatedBitmaps_ -= static_cast<int>(freeBitmaps_.size());
+    freeBitmaps_.clear();
+    ReleaseDecoderLocked();
+  }
+}
 
-  if (!srcPM.readPixels(dstPM)) {
-    return false;
+void MultiFrameCodec::State::ReleaseDecoderLocked() {
+  if (decoding_ || !AllFramesCachedLocked()) {
+    return;
   }
+  codec_.reset();
+  lastRequiredFrame_.reset();
+  lastRequiredFrameIndex_ = -1;
+}
 
-  dst->swap(tmpDst);
-  return true;
+void MultiFrameCodec::State::ScheduleDecodeLocked(
+    std::weak_ptr<State> weak_state) {
+  if (decoding_ || !ShouldDecodeLocked()) {
+    return;
+  }
+  decoding_ = true;
+  auto decode = [weak_state]() { DecodeAhead(weak_state); };
+  if (concurrent_loop_) {
+    concurrent_loop_->GetTaskRunner()->PostTask(std::move(decode));
+  } else {
+    io_task_runner_->PostTask(std::move(decode));
+  }
+}
+
+void MultiFrameCodec::State::DecodeAhead(std::weak_ptr<State> weak_state) {
+  while (true) {
+    std::shared_ptr<State> state = weak_state.lock();
+    if (!state) {
+      return;
+    }
+
+    std::unique_ptr<SkBitmap> bitmap;
+    int index;
+    {
+      std::scoped_lock lock(state->mutex_);
+      if (!state->ShouldDecodeLocked()) {
+        state->decoding_ = false;
+        state->ReleaseDecoderLocked();
+        return;
+      }
+      if (!state->freeBitmaps_.empty()) {
+        bitmap = std::move(state->freeBitmaps_.back());
+        state->freeBitmaps_.pop_back();
+      } else {
+        bitmap = std::make_unique<SkBitmap>();
+        state->allocatedBitmaps_++;
+      }
+      // Frames are decoded in display order, following the ones already
+      // decoded or, once those are handed out, the next frame displayed.
+      index = state->decodedFrames_.empty()
+                  ? state->nextFrameIndex_
+                  : (state->decodedFrames_.back().index + 1) %
+                        state->frameCount_;
+    }
+
+    int duration = 0;
+    const bool success = state->DecodeFrame(index, bitmap.get(), &duration);
+
+    {
+      std::scoped_lock lock(state->mutex_);
+      state->decodedFrames_.push_back(
+          {std::move(bitmap), index, duration, success});
+    }
+    state->io_task_runner_->PostTask(
+        [weak_state]() { DeliverFrames(weak_state); });
+  }
 }
 
-sk_sp<SkImage> MultiFrameCodec::State::GetNextFrameImage(
-    fml::WeakPtr<GrContext> resourceContext) {
-  SkBitmap bitmap = SkBitmap();
+bool MultiFrameCodec::State::DecodeFrame(int index, SkBitmap* bitmap,
+                                         int* duration) {
+  TRACE_EVENT0("uiwidgets", "MultiFrameCodec::DecodeFrame");
   SkImageInfo info = codec_->getInfo().makeColorType(kN32_SkColorType);
   if (info.alphaType() == kUnpremul_SkAlphaType) {
     info = info.makeAlphaType(kPremul_SkAlphaType);
   }
-  bitmap.allocPixels(info);
+  // Bitmaps are allocated once and reused for the following frames.
+  if (!bitmap->getPixels() && !bitmap->tryAllocPixels(info)) {
+    FML_LOG(ERROR) << "Could not allocate pixels for frame " << index;
+    return false;
+  }
 
   SkCodec::Options options;
-  options.fFrameIndex = nextFrameIndex_;
+  options.fFrameIndex = index;
   SkCodec::FrameInfo frameInfo;
-  codec_->getFrameInfo(nextFrameIndex_, &frameInfo);
+  codec_->getFrameInfo(index, &frameInfo);
+  *duration = frameInfo.fDuration;
   const int requiredFrameIndex = frameInfo.fRequiredFrame;
-  if (requiredFrameIndex != SkCodec::kNoFrame) {
-    if (lastRequiredFrame_ == nullptr) {
-      FML_LOG(ERROR) << "Frame " << nextFrameIndex_ << " depends on frame "
-                     << requiredFrameIndex
-                     << " and no required frames are cached.";
-      return nullptr;
-    } else if (lastRequiredFrameIndex_ != requiredFrameIndex) {
-      FML_DLOG(INFO) << "Required frame " << requiredFrameIndex
-                     << " is not cached. Using " << lastRequiredFrameIndex_
-                     << " instead";
-    }
-
-    if (lastRequiredFrame_->getPixels() &&
-        CopyToBitmap(&bitmap, lastRequiredFrame_->colorType(),
-                     *lastRequiredFrame_)) {
-      options.fPriorFrame = requiredFrameIndex;
-    }
+  // Without the required frame, the codec decodes it first by itself.
+  if (requiredFrameIndex != SkCodec::kNoFrame &&
+      lastRequiredFrameIndex_ == requiredFrameIndex &&
+      lastRequiredFrame_.readPixels(bitmap->pixmap())) {
+    options.fPriorFrame = requiredFrameIndex;
   }
 
-  if (SkCodec::kSuccess != codec_->getPixels(info, bitmap.getPixels(),
-                                             bitmap.rowBytes(), &options)) {
-    FML_LOG(ERROR) << "Could not getPixels for frame " << nextFrameIndex_;
-    return nullptr;
+  if (SkCodec::kSuccess != codec_->getPixels(info, bitmap->getPixels(),
+                                             bitmap->rowBytes(), &options)) {
+    FML_LOG(ERROR) << "Could not getPixels for frame " << index;
+    return false;
   }
 
-  // Hold onto this if we need it to decode future frames.
+  // Hold onto this if we need it to decode future frames. The bitmap is
+  // reused, so its pixels are copied.
   if (frameInfo.fDisposalMethod == SkCodecAnimation::DisposalMethod::kKeep) {
-    lastRequiredFrame_ = std::make_unique<SkBitmap>(bitmap);
-    lastRequiredFrameIndex_ = nextFrameIndex_;
+    if ((lastRequiredFrame_.getPixels() ||
+         lastRequiredFrame_.tryAllocPixels(info)) &&
+        bitmap->readPixels(lastRequiredFrame_.pixmap())) {
+      lastRequiredFrameIndex_ = index;
+    } else {
+      lastRequiredFrameIndex_ = -1;
+    }
   }
+  return true;
+}
 
+sk_sp<SkImage> MultiFrameCodec::State::UploadFrame(
+    const SkBitmap& bitmap, fml::WeakPtr<GrContext> resourceContext) {
   if (resourceContext) {
     SkPixmap pixmap(bitmap.info(), bitmap.pixelRef()->pixels(),
                     bitmap.pixelRef()->rowBytes());
@@ -121,39 +225,84 @@ sk_sp<SkImage> MultiFrameCodec::State::GetNextFrameImage(
   } else {
     // Defer decoding until time of draw later on the raster thread. Can happen
     // when GL operations are currently forbidden such as in the background
-    // on iOS.
-    return SkImage::MakeFromBitmap(bitmap);
+    // on iOS. The bitmap is reused, so the image gets a copy of its pixels.
+    return SkImage::MakeRasterCopy(bitmap.pixmap());
   }
 }
 
-void MultiFrameCodec::State::GetNextFrameAndInvokeCallback(
-    std::unique_ptr<PendingCallback> callback,
-    fml::RefPtr<fml::TaskRunner> ui_task_runner,
-    fml::WeakPtr<GrContext> resourceContext,
-    fml::RefPtr<SkiaUnrefQueue> unref_queue, size_t trace_id) {
-  fml::RefPtr<FrameInfo> frameInfo = NULL;
-  sk_sp<SkImage> skImage = GetNextFrameImage(resourceContext);
-  if (skImage) {
-    fml::RefPtr<CanvasImage> image = CanvasImage::Create();
-    image->set_image({skImage, std::move(unref_queue)});
-    SkCodec::FrameInfo skFrameInfo;
-    codec_->getFrameInfo(nextFrameIndex_, &skFrameInfo);
-    frameInfo =
-        fml::MakeRefCounted<FrameInfo>(std::move(image), skFrameInfo.fDuration);
-  }
-  nextFrameIndex_ = (nextFrameIndex_ + 1) % frameCount_;
-
-  ui_task_runner->PostTask(fml::MakeCopyable(
-      [callback = std::move(callback), frameInfo, trace_id]() mutable {
-        InvokeNextFrameCallback(frameInfo, std::move(callback), trace_id);
-      }));
+void MultiFrameCodec::State::DeliverFrames(std::weak_ptr<State> weak_state) {
+  std::shared_ptr<State> state = weak_state.lock();
+  if (!state) {
+    return;
+  }
+  fml::WeakPtr<GrContext> resourceContext;
+  fml::RefPtr<SkiaUnrefQueue> unref_queue;
+  if (state->io_manager_) {
+    resourceContext = state->io_manager_->GetResourceContext();
+    unref_queue = state->io_manager_->GetSkiaUnrefQueue();
+  }
+
+  std::unique_lock lock(state->mutex_);
+  while (!state->pendingCallbacks_.empty()) {
+    sk_sp<SkImage> skImage;
+    int duration = 0;
+    if (state->AllFramesCachedLocked()) {
+      // Drops a frame that was being decoded when the last frame got cached.
+      for (DecodedFrame& decoded : state->decodedFrames_) {
+        state->ReleaseBitmapLocked(std::move(decoded.bitmap));
+      }
+      state->decodedFrames_.clear();
+      const CachedFrame& frame = state->cachedFrames_[state->nextFrameIndex_];
+      skImage = frame.image;
+      duration = frame.duration;
+      state->nextFrameIndex_ =
+          (state->nextFrameIndex_ + 1) % state->frameCount_;
+    } else if (state->frameCount_ > 0) {
+      if (state->decodedFrames_.empty()) {
+        break;
+      }
+      DecodedFrame frame = std::move(state->decodedFrames_.front());
+      state->decodedFrames_.pop_front();
+      if (frame.index != state->nextFrameIndex_) {
+        // Decoded before the frames were cached and no longer in order.
+        state->ReleaseBitmapLocked(std::move(frame.bitmap));
+        continue;
+      }
+      state->nextFrameIndex_ = (frame.index + 1) % state->frameCount_;
+
+      lock.unlock();
+      if (frame.success) {
+        skImage = state->UploadFrame(*frame.bitmap, resourceContext);
+      }
+      duration = frame.duration;
+      lock.lock();
+
+      state->ReleaseBitmapLocked(std::move(frame.bitmap));
+      if (skImage) {
+        state->CacheFrameLocked(frame.index, skImage, duration);
+      }
+    }
+
+    std::unique_ptr<PendingCallback> callback =
+        std::move(state->pendingCallbacks_.front());
+    state->pendingCallbacks_.pop_front();
+
+    fml::RefPtr<FrameInfo> frameInfo;
+    if (skImage) {
+      fml::RefPtr<CanvasImage> image = CanvasImage::Create();
+      image->set_image({skImage, unref_queue});
+      frameInfo = fml::MakeRefCounted<FrameInfo>(std::move(image), duration);
+    }
+    state->ui_task_runner_->PostTask(fml::MakeCopyable(
+        [callback = std::move(callback), frameInfo]() mutable {
+          InvokeNextFrameCallback(frameInfo, std::move(callback));
+        }));
+  }
+  state->ScheduleDecodeLocked(weak_state);
 }
 
 const char* MultiFrameCodec::getNextFrame(GetNextFrameCallback callback,
                                           Mono_Handle callback_handle) {
-  static size_t trace_counter = 1;
-  const size_t trace_id = trace_counter++;
-
   if (!callback || !callback_handle) {
     return "Callback must be a function";
   }
@@ -165,9 +314,8 @@ const char* MultiFrameCodec::getNextFrame(GetNextFrameCallback callback,
   task_runners.GetIOTaskRunner()->PostTask(fml::MakeCopyable(
       [callback = std::make_unique<PendingCallback>(PendingCallback{
            MonoState::Current()->GetWeakPtr(), callback, callback_handle}),
-       weak_state = std::weak_ptr<MultiFrameCodec::State>(state_), trace_id,
-       ui_task_runner = task_runners.GetUITaskRunner(),
-       io_manager = mono_state->GetIOManager()]() mutable {
+       weak_state = std::weak_ptr<MultiFrameCodec::State>(state_),
+       ui_task_runner = task_runners.GetUITaskRunner()]() mutable {
         auto state = weak_state.lock();
         if (!state) {
           ui_task_runner->PostTask(
@@ -176,15 +324,29 @@ const char* MultiFrameCodec::getNextFrame(GetNextFrameCallback callback,
               }));
           return;
         }
-        state->GetNextFrameAndInvokeCallback(
-            std::move(callback), std::move(ui_task_runner),
-            io_manager->GetResourceContext(), io_manager->GetSkiaUnrefQueue(),
-            trace_id);
+        {
+          std::scoped_lock lock(state->mutex_);
+          state->pendingCallbacks_.push_back(std::move(callback));
+        }
+        State::DeliverFrames(weak_state);
       }));
 
   return nullptr;
 }
 
+void MultiFrameCodec::setLookAhead(int frame_count, bool cache_all_frames) {
+  std::scoped_lock lock(state_->mutex_);
+  state_->lookAhead_ = std::max(frame_count, 0);
+  state_->cacheAllFrames_ = cache_all_frames;
+  // Once the codec is released, the cached frames are the only ones left.
+  if (!cache_all_frames && !state_->cachedFrames_.empty() && state_->codec_) {
+    // Decoding resumes from the next frame displayed.
+    state_->cachedFrames_.clear();
+    state_->cachedFrameCount_ = 0;
+  }
+  state_->ScheduleDecodeLocked(state_);
+}
+
 int MultiFrameCodec::frameCount() const { return state_->frameCount_; }
 
 int MultiFrameCodec::repetitionCount() const {
@@ -1,13 +1,31 @@
 #pragma once
 
+#include <deque>
+#include <mutex>
+#include <vector>
+
 #include "codec.h"
+#include "flow/skia_gpu_object.h"
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/macros.h"
+#include "flutter/fml/memory/weak_ptr.h"
+#include "flutter/fml/task_runner.h"
+#include "lib/ui/io_manager.h"
 #include "runtime/mono_state.h"
 
 namespace uiwidgets {
 
 class MultiFrameCodec : public Codec {
  public:
+  // The number of frames decoded ahead of the displayed frame by default.
+  // Frames are only decoded when asked for, unless the codec opts in with
+  // setLookAhead.
+  static constexpr int kDefaultLookAhead = 0;
+
+  // The largest animation, in decoded bytes, whose frames are all kept when
+  // caching all frames is requested.
+  static constexpr size_t kMaxCachedFramesBytes = 16 * 1024 * 1024;
+
   MultiFrameCodec(std::unique_ptr<SkCodec> codec);
 
   ~MultiFrameCodec() override;
@@ -22,44 +40,99 @@ class MultiFrameCodec : public Codec {
   const char* getNextFrame(GetNextFrameCallback callback,
                            Mono_Handle callback_handle) override;
 
+  // |Codec|
+  void setLookAhead(int frame_count, bool cache_all_frames) override;
+
  private:
-	
-  // Captures the state shared between the IO and UI task runners.
+  // Captures the state shared between the UI, IO and worker task runners.
   //
   // The state is initialized on the UI task runner when the Dart object is
-  // created. Decoding occurs on the IO task runner. Since it is possible for
-  // the UI object to be collected independently of the IO task runner work,
-  // it is not safe for this state to live directly on the MultiFrameCodec.
-  // Instead, the MultiFrameCodec creates this object when it is constructed,
-  // shares it with the IO task runner's decoding work, and sets the live_
-  // member to false when it is destructed.
+  // created. Decoding occurs on the concurrent worker pool, uploading and
+  // answering the callbacks on the IO task runner. Since it is possible for
+  // the UI object to be collected independently of this work, it is not safe
+  // for this state to live directly on the MultiFrameCodec. Instead, the
+  // MultiFrameCodec creates this object when it is constructed, and the
+  // tasks only hold weak references to it.
+  //
+  // Frames are decoded in order by at most one task at a time, into a small
+  // ring of bitmaps whose pixels are reused once the frame is uploaded.
   struct State {
     State(std::unique_ptr<SkCodec> codec);
 
-    const std::unique_ptr<SkCodec> codec_;
+    // Used by the decoding task without holding the mutex. Released, under
+    // the mutex, once all frames are cached and no decoding task runs.
+    std::unique_ptr<SkCodec> codec_;
     const int frameCount_;
     const int repetitionCount_;
 
-    // The non-const members and functions below here are only read or written
-    // to on the IO thread. They are not safe to access or write on the UI
-    // thread.
-    int nextFrameIndex_;
-    // The last decoded frame that's required to decode any subsequent frames.
-    std::unique_ptr<SkBitmap> lastRequiredFrame_;
+    fml::RefPtr<fml::TaskRunner> ui_task_runner_;
+    fml::RefPtr<fml::TaskRunner> io_task_runner_;
+    fml::WeakPtr<IOManager> io_manager_;
+    std::shared_ptr<fml::ConcurrentMessageLoop> concurrent_loop_;
 
+    // Only accessed by the decoding task, or under the mutex when none runs.
+    // The last decoded frame that's required to decode any subsequent frames.
+    SkBitmap lastRequiredFrame_;
     // The index of the last decoded required frame.
     int lastRequiredFrameIndex_ = -1;
 
-    sk_sp<SkImage> GetNextFrameImage(fml::WeakPtr<GrContext> resourceContext);
-
-    void GetNextFrameAndInvokeCallback(
-        std::unique_ptr<PendingCallback> callback,
-        fml::RefPtr<fml::TaskRunner> ui_task_runner,
-        fml::WeakPtr<GrContext> resourceContext,
-        fml::RefPtr<SkiaUnrefQueue> unref_queue, size_t trace_id);
+    struct DecodedFrame {
+      std::unique_ptr<SkBitmap> bitmap;
+      int index;
+      int duration;
+      bool success;
+    };
+
+    struct CachedFrame {
+      sk_sp<SkImage> image;
+      int duration;
+    };
+
+    // Guards the members below.
+    std::mutex mutex_;
+    int lookAhead_ = kDefaultLookAhead;
+    bool cacheAllFrames_ = false;
+    bool decoding_ = false;
+    // The index of the next frame handed to a callback.
+    int nextFrameIndex_ = 0;
+    int allocatedBitmaps_ = 0;
+    std::vector<std::unique_ptr<SkBitmap>> freeBitmaps_;
+    // Frames decoded ahead, in display order, waiting to be uploaded.
+    std::deque<DecodedFrame> decodedFrames_;
+    std::deque<std::unique_ptr<PendingCallback>> pendingCallbacks_;
+    // The frames kept when all frames are cached, by index. Once all of them
+    // are kept, frames are no longer decoded.
+    std::vector<CachedFrame> cachedFrames_;
+    int cachedFrameCount_ = 0;
+
+    bool AllFramesCachedLocked() const;
+    bool ShouldDecodeLocked() const;
+    void ReleaseBitmapLocked(std::unique_ptr<SkBitmap> bitmap);
+    void CacheFrameLocked(int index, sk_sp<SkImage> image, int duration);
+
+    // Releases the codec and the required frame once all frames are cached,
+    // unless the decoding task still runs. The task releases them when it
+    // stops.
+    void ReleaseDecoderLocked();
+
+    // Posts the decoding task unless it is already running.
+    void ScheduleDecodeLocked(std::weak_ptr<State> weak_state);
+
+    // Decodes frames until enough of them are ready. Runs on the concurrent
+    // worker pool.
+    static void DecodeAhead(std::weak_ptr<State> weak_state);
+
+    bool DecodeFrame(int index, SkBitmap* bitmap, int* duration);
+
+    // Uploads the decoded frames and answers the pending callbacks with them,
+    // in order. Runs on the IO task runner.
+    static void DeliverFrames(std::weak_ptr<State> weak_state);
+
+    sk_sp<SkImage> UploadFrame(const SkBitmap& bitmap,
+                               fml::WeakPtr<GrContext> resourceContext);
   };
 
-  // Shared across the UI and IO task runners.
+  // Shared across the UI, IO and worker task runners.
   std::shared_ptr<State> state_;
 
   FML_FRIEND_MAKE_REF_COUNTED(MultiFrameCodec);
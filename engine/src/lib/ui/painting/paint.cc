@@ -8,6 +8,7 @@
 #include "include/core/SkMaskFilter.h"
 #include "include/core/SkShader.h"
 #include "include/core/SkString.h"
+#include "paint_cache.h"
 #include "shader.h"
 
 namespace uiwidgets {
@@ -28,6 +29,8 @@ constexpr int kMaskFilterSigmaIndex = 11;
 constexpr int kInvertColorIndex = 12;
 constexpr int kDitherIndex = 13;
 constexpr size_t kDataByteCount = 56;  // 4 * (last index + 1)
+static_assert(kDataByteCount == PaintCache::kPaintDataByteCount,
+              "PaintCache must key on the whole paint data.");
 
 // Indices for objects.
 constexpr int kShaderIndex = 0;
@@ -59,80 +62,75 @@ constexpr float invert_colors[20] = {
 // Must be kept in sync with the MaskFilter private constants in painting.cs.
 enum MaskFilterType { Null, Blur };
 
-Paint::Paint(void** paint_objects, uint8_t* paint_data) {
-  is_null_ = paint_data == nullptr;
-  if (is_null_) return;
-
-  Mono_Handle values[kObjectCount];
-  if (paint_objects != nullptr) {
-    auto shader = static_cast<Shader*>(paint_objects[kShaderIndex]);
-    if (shader) {
-      paint_.setShader(shader->shader());
-    }
-
-    auto color_filter =
-        static_cast<ColorFilter*>(paint_objects[kColorFilterIndex]);
-    if (color_filter) {
-      paint_.setColorFilter(color_filter->filter());
-    }
+static sk_sp<SkColorFilter> InvertColorFilter() {
+  static const sk_sp<SkColorFilter> invert_filter =
+      ColorFilter::MakeColorMatrixFilter255(invert_colors);
+  return invert_filter;
+}
 
-    auto image_filter =
-        static_cast<ImageFilter*>(paint_objects[kImageFilterIndex]);
-    if (image_filter) {
-      paint_.setImageFilter(image_filter->filter());
-    }
+static SkPaint DecodePaint(const uint8_t* paint_data, sk_sp<SkShader> shader,
+                           sk_sp<SkColorFilter> color_filter,
+                           sk_sp<SkImageFilter> image_filter) {
+  SkPaint paint;
+  if (shader) {
+    paint.setShader(std::move(shader));
+  }
+  if (color_filter) {
+    paint.setColorFilter(std::move(color_filter));
+  }
+  if (image_filter) {
+    paint.setImageFilter(std::move(image_filter));
   }
 
   const uint32_t* uint_data = reinterpret_cast<const uint32_t*>(paint_data);
   const float* float_data = reinterpret_cast<const float*>(paint_data);
 
-  paint_.setAntiAlias(uint_data[kIsAntiAliasIndex] == 0);
+  paint.setAntiAlias(uint_data[kIsAntiAliasIndex] == 0);
 
   uint32_t encoded_color = uint_data[kColorIndex];
   if (encoded_color) {
     SkColor color = encoded_color ^ kColorDefault;
-    paint_.setColor(color);
+    paint.setColor(color);
   }
 
   uint32_t encoded_blend_mode = uint_data[kBlendModeIndex];
   if (encoded_blend_mode) {
     uint32_t blend_mode = encoded_blend_mode ^ kBlendModeDefault;
-    paint_.setBlendMode(static_cast<SkBlendMode>(blend_mode));
+    paint.setBlendMode(static_cast<SkBlendMode>(blend_mode));
   }
 
   uint32_t style = uint_data[kStyleIndex];
-  if (style) paint_.setStyle(static_cast<SkPaint::Style>(style));
+  if (style) paint.setStyle(static_cast<SkPaint::Style>(style));
 
   float stroke_width = float_data[kStrokeWidthIndex];
-  if (stroke_width != 0.0) paint_.setStrokeWidth(stroke_width);
+  if (stroke_width != 0.0) paint.setStrokeWidth(stroke_width);
 
   uint32_t stroke_cap = uint_data[kStrokeCapIndex];
-  if (stroke_cap) paint_.setStrokeCap(static_cast<SkPaint::Cap>(stroke_cap));
+  if (stroke_cap) paint.setStrokeCap(static_cast<SkPaint::Cap>(stroke_cap));
 
   uint32_t stroke_join = uint_data[kStrokeJoinIndex];
   if (stroke_join)
-    paint_.setStrokeJoin(static_cast<SkPaint::Join>(stroke_join));
+    paint.setStrokeJoin(static_cast<SkPaint::Join>(stroke_join));
 
   float stroke_miter_limit = float_data[kStrokeMiterLimitIndex];
   if (stroke_miter_limit != 0.0)
-    paint_.setStrokeMiter(stroke_miter_limit + kStrokeMiterLimitDefault);
+    paint.setStrokeMiter(stroke_miter_limit + kStrokeMiterLimitDefault);
 
   uint32_t filter_quality = uint_data[kFilterQualityIndex];
   if (filter_quality)
-    paint_.setFilterQuality(static_cast<SkFilterQuality>(filter_quality));
+    paint.setFilterQuality(static_cast<SkFilterQuality>(filter_quality));
 
   if (uint_data[kInvertColorIndex]) {
-    sk_sp<SkColorFilter> invert_filter =
-        ColorFilter::MakeColorMatrixFilter255(invert_colors);
-    sk_sp<SkColorFilter> current_filter = paint_.refColorFilter();
+    sk_sp<SkColorFilter> invert_filter = InvertColorFilter();
+    sk_sp<SkColorFilter> current_filter = paint.refColorFilter();
     if (current_filter) {
       invert_filter = invert_filter->makeComposed(current_filter);
     }
-    paint_.setColorFilter(invert_filter);
+    paint.setColorFilter(invert_filter);
   }
 
   if (uint_data[kDitherIndex]) {
-    paint_.setDither(true);
+    paint.setDither(true);
   }
 
   switch (uint_data[kMaskFilterIndex]) {
@@ -142,9 +140,52 @@ Paint::Paint(void** paint_objects, uint8_t* paint_data) {
       SkBlurStyle blur_style =
           static_cast<SkBlurStyle>(uint_data[kMaskFilterBlurStyleIndex]);
       double sigma = float_data[kMaskFilterSigmaIndex];
-      paint_.setMaskFilter(SkMaskFilter::MakeBlur(blur_style, sigma));
+      paint.setMaskFilter(
+          PaintCache::GetInstance().GetBlurMaskFilter(blur_style, sigma));
       break;
   }
+
+  return paint;
+}
+
+Paint::Paint(void** paint_objects, uint8_t* paint_data) {
+  if (paint_data == nullptr) return;
+
+  sk_sp<SkShader> shader;
+  sk_sp<SkColorFilter> color_filter;
+  sk_sp<SkImageFilter> image_filter;
+  if (paint_objects != nullptr) {
+    if (auto shader_object = static_cast<Shader*>(paint_objects[kShaderIndex])) {
+      shader = shader_object->shader();
+    }
+
+    if (auto color_filter_object =
+            static_cast<ColorFilter*>(paint_objects[kColorFilterIndex])) {
+      color_filter = color_filter_object->filter();
+    }
+
+    if (auto image_filter_object =
+            static_cast<ImageFilter*>(paint_objects[kImageFilterIndex])) {
+      image_filter = image_filter_object->filter();
+    }
+  }
+
+  // Shaders and image filters may reference GPU backed images, see the
+  // PaintCache class comment.
+  if (shader || image_filter) {
+    PaintCache::GetInstance().RecordBypass();
+    paint_ = std::make_shared<const SkPaint>(
+        DecodePaint(paint_data, std::move(shader), std::move(color_filter),
+                    std::move(image_filter)));
+    return;
+  }
+
+  const SkColorFilter* color_filter_key = color_filter.get();
+  paint_ = PaintCache::GetInstance().Get(
+      paint_data, color_filter_key, [&]() {
+        return DecodePaint(paint_data, nullptr, std::move(color_filter),
+                           nullptr);
+      });
 }
 
 }  // namespace uiwidgets
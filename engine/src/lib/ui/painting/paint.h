@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "include/core/SkPaint.h"
 #include "runtime/mono_api.h"
 
@@ -10,11 +12,11 @@ class Paint {
   Paint() = default;
   Paint(void** paint_objects, uint8_t* paint_data);
 
-  const SkPaint* paint() const { return is_null_ ? nullptr : &paint_; }
+  const SkPaint* paint() const { return paint_.get(); }
 
  private:
-  SkPaint paint_;
-  bool is_null_ = true;
+  // Shared with the PaintCache when the paint could be interned.
+  std::shared_ptr<const SkPaint> paint_;
 };
 
 }  // namespace uiwidgets
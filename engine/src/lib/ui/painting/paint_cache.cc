@@ -0,0 +1,119 @@
+#include "paint_cache.h"
+
+#include <cstring>
+
+#include "flutter/fml/trace_event.h"
+
+namespace uiwidgets {
+
+// The number of distinct blur mask filters kept before the table is reset.
+constexpr size_t kMaxBlurFilters = 64;
+
+PaintCache& PaintCache::GetInstance() {
+  static PaintCache* instance = new PaintCache();
+  return *instance;
+}
+
+PaintCache::PaintCache() = default;
+
+size_t PaintCache::Key::Hash::operator()(const Key& key) const {
+  // FNV-1a over the packed paint data and the color filter address.
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < kPaintDataByteCount; i++) {
+    hash ^= key.data[i];
+    hash *= 1099511628211ull;
+  }
+  hash ^= reinterpret_cast<uintptr_t>(key.color_filter);
+  hash *= 1099511628211ull;
+  return static_cast<size_t>(hash);
+}
+
+bool PaintCache::Key::Equal::operator()(const Key& lhs, const Key& rhs) const {
+  return lhs.color_filter == rhs.color_filter &&
+         memcmp(lhs.data, rhs.data, kPaintDataByteCount) == 0;
+}
+
+std::shared_ptr<const SkPaint> PaintCache::Get(
+    const uint8_t* paint_data, const SkColorFilter* color_filter,
+    const Builder& builder) {
+  Key key;
+  memcpy(key.data, paint_data, kPaintDataByteCount);
+  key.color_filter = color_filter;
+
+  {
+    std::scoped_lock lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      hit_count_++;
+      lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+      return it->second.paint;
+    }
+    miss_count_++;
+  }
+
+  // Build outside of the lock, the builder may intern mask filters.
+  auto paint = std::make_shared<const SkPaint>(builder());
+
+  std::scoped_lock lock(mutex_);
+  if (entries_.find(key) != entries_.end()) {
+    return paint;
+  }
+  if (entries_.size() >= kMaxEntries) {
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+  }
+  lru_.push_front(key);
+  // The cached paint keeps the color filter alive, so its address can not be
+  // reused by another filter while the entry exists.
+  entries_[key] = {paint, lru_.begin()};
+  return paint;
+}
+
+sk_sp<SkMaskFilter> PaintCache::GetBlurMaskFilter(SkBlurStyle style,
+                                                  float sigma) {
+  uint32_t sigma_bits;
+  memcpy(&sigma_bits, &sigma, sizeof(sigma_bits));
+  uint64_t key = (static_cast<uint64_t>(style) << 32) | sigma_bits;
+
+  std::scoped_lock lock(mutex_);
+  auto it = blur_filters_.find(key);
+  if (it != blur_filters_.end()) {
+    return it->second;
+  }
+  if (blur_filters_.size() >= kMaxBlurFilters) {
+    blur_filters_.clear();
+  }
+  sk_sp<SkMaskFilter> filter = SkMaskFilter::MakeBlur(style, sigma);
+  blur_filters_[key] = filter;
+  return filter;
+}
+
+void PaintCache::RecordBypass() {
+  std::scoped_lock lock(mutex_);
+  bypass_count_++;
+}
+
+void PaintCache::Clear() {
+  std::scoped_lock lock(mutex_);
+  entries_.clear();
+  lru_.clear();
+  blur_filters_.clear();
+}
+
+void PaintCache::TraceStatsToTimeline() {
+  std::scoped_lock lock(mutex_);
+#if !UIWidgets_RELEASE
+  FML_TRACE_COUNTER("uiwidgets", "PaintCache",
+                    reinterpret_cast<int64_t>(this),  //
+                    "Hits", hit_count_,               //
+                    "Misses", miss_count_,            //
+                    "Bypassed", bypass_count_,        //
+                    "Entries", entries_.size()        //
+  );
+#endif  // !UIWidgets_RELEASE
+  hit_count_ = 0;
+  miss_count_ = 0;
+  bypass_count_ = 0;
+}
+
+}  // namespace uiwidgets
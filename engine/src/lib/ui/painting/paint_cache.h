@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "flutter/fml/macros.h"
+#include "include/core/SkColorFilter.h"
+#include "include/core/SkMaskFilter.h"
+#include "include/core/SkPaint.h"
+
+namespace uiwidgets {
+
+// Interns decoded paints so that the same encoded paint data does not rebuild
+// an SkPaint (and its blur mask filter and inverted color filter) on every
+// draw call.
+//
+// The invert color matrix filter is a constant and is shared by paint.cc
+// directly.
+//
+// Only paints whose referenced objects are plain CPU side Skia objects (color
+// filters) are interned as a whole. Shaders and image filters may hold GPU
+// backed images that must be released through the SkiaUnrefQueue, so paints
+// referencing them are rebuilt every time but still share the interned mask
+// and invert filters.
+class PaintCache {
+ public:
+  static constexpr size_t kPaintDataByteCount = 56;
+
+  // The maximum number of whole paints kept in the cache. Within one frame,
+  // most paints are one of a few dozen styles.
+  static constexpr size_t kMaxEntries = 256;
+
+  using Builder = std::function<SkPaint()>;
+
+  static PaintCache& GetInstance();
+
+  std::shared_ptr<const SkPaint> Get(const uint8_t* paint_data,
+                                     const SkColorFilter* color_filter,
+                                     const Builder& builder);
+
+  sk_sp<SkMaskFilter> GetBlurMaskFilter(SkBlurStyle style, float sigma);
+
+  // Counts a paint that could not be interned, see the class comment.
+  void RecordBypass();
+
+  void Clear();
+
+  // Reports the hit, miss and bypass counts since the last call, and resets
+  // them. Called once per frame.
+  void TraceStatsToTimeline();
+
+ private:
+  struct Key {
+    uint8_t data[kPaintDataByteCount];
+    const SkColorFilter* color_filter;
+
+    struct Hash {
+      size_t operator()(const Key& key) const;
+    };
+
+    struct Equal {
+      bool operator()(const Key& lhs, const Key& rhs) const;
+    };
+  };
+
+  using LRUList = std::list<Key>;
+
+  struct Entry {
+    std::shared_ptr<const SkPaint> paint;
+    LRUList::iterator lru_position;
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<Key, Entry, Key::Hash, Key::Equal> entries_;
+  LRUList lru_;
+  std::unordered_map<uint64_t, sk_sp<SkMaskFilter>> blur_filters_;
+
+  size_t hit_count_ = 0;
+  size_t miss_count_ = 0;
+  size_t bypass_count_ = 0;
+
+  PaintCache();
+
+  FML_DISALLOW_COPY_AND_ASSIGN(PaintCache);
+};
+
+}  // namespace uiwidgets
@@ -1,5 +1,7 @@
 #include "single_frame_codec.h"
 
+#include <algorithm>
+
 #include "frame_info.h"
 #include "lib/ui/ui_mono_state.h"
 
@@ -21,7 +23,9 @@ const char* SingleFrameCodec::getNextFrame(GetNextFrameCallback callback,
   }
 
   if (status_ == Status::kComplete) {
-    cached_frame_->AddRef();
+    if (cached_frame_) {
+      cached_frame_->AddRef();
+    }
     callback(callback_handle, cached_frame_.get());
     return nullptr;
   }
@@ -50,9 +54,15 @@ const char* SingleFrameCodec::getNextFrame(GetNextFrameCallback callback,
   fml::RefPtr<SingleFrameCodec>* raw_codec_ref =
       new fml::RefPtr<SingleFrameCodec>(this);
 
-  decoder->Decode(descriptor_, [raw_codec_ref](auto image) {
+  auto on_decoded = [raw_codec_ref](auto image) {
     std::unique_ptr<fml::RefPtr<SingleFrameCodec>> codec_ref(raw_codec_ref);
     fml::RefPtr<SingleFrameCodec> codec(std::move(*codec_ref));
+    codec->request_ = 0;
+
+    if (codec->pending_callbacks_.empty()) {
+      // The codec was disposed while decoding.
+      return;
+    }
 
     auto state = codec->pending_callbacks_.front().mono_state.lock();
 
@@ -83,11 +93,16 @@ const char* SingleFrameCodec::getNextFrame(GetNextFrameCallback callback,
 
     // Invoke any callbacks that were provided before the frame was decoded.
     for (const auto& entry : codec->pending_callbacks_) {
-      codec->cached_frame_->AddRef();
+      if (codec->cached_frame_) {
+        codec->cached_frame_->AddRef();
+      }
       entry.callback(entry.callback_handle, codec->cached_frame_.get());
     }
     codec->pending_callbacks_.clear();
-  });
+  };
+  decoder_ = decoder;
+  ui_task_runner_ = mono_state->GetTaskRunners().GetUITaskRunner();
+  request_ = decoder->Decode(descriptor_, on_decoded, priority_);
 
   // The encoded data is no longer needed now that it has been handed off
   // to the decoder.
@@ -98,6 +113,36 @@ const char* SingleFrameCodec::getNextFrame(GetNextFrameCallback callback,
   return nullptr;
 }
 
+void SingleFrameCodec::setDecodePriority(int priority) {
+  priority_ = static_cast<ImageDecoder::Priority>(
+      std::min(std::max(priority,
+                        static_cast<int>(ImageDecoder::Priority::kVisible)),
+               static_cast<int>(ImageDecoder::Priority::kBackground)));
+
+  if (status_ != Status::kInProgress || request_ == 0 || !decoder_) {
+    return;
+  }
+  decoder_->Reprioritize(request_, priority_);
+}
+
+void SingleFrameCodec::dispose() {
+  // A codec that never started decoding has nothing to cancel. Once it has,
+  // |ui_task_runner_| is no longer written.
+  if (!ui_task_runner_) {
+    return;
+  }
+
+  // The decoder is only used on the UI thread. The cancelled request is
+  // answered with no frame, which answers and releases the pending managed
+  // callbacks.
+  ui_task_runner_->PostTask([codec = fml::RefPtr<SingleFrameCodec>(this)]() {
+    if (codec->status_ == Status::kInProgress && codec->request_ != 0 &&
+        codec->decoder_) {
+      codec->decoder_->Cancel(codec->request_);
+    }
+  });
+}
+
 size_t SingleFrameCodec::GetAllocationSize() {
   const auto& data = descriptor_.data;
   const auto data_byte_size = data ? data->size() : 0;
@@ -23,12 +23,24 @@ class SingleFrameCodec : public Codec {
   const char* getNextFrame(GetNextFrameCallback callback,
                            Mono_Handle callback_handle) override;
 
+  // |Codec|
+  void setDecodePriority(int priority) override;
+
+  // |Codec|
+  void dispose() override;
+
   size_t GetAllocationSize() override;
 
  private:
   enum class Status { kNew, kInProgress, kComplete };
   Status status_;
   ImageDecoder::ImageDescriptor descriptor_;
+  ImageDecoder::Priority priority_ = ImageDecoder::Priority::kVisible;
+  // The decode in progress, and where it was requested. Set on the UI thread
+  // when decoding starts, and only accessed there afterwards.
+  ImageDecoder::RequestId request_ = 0;
+  fml::WeakPtr<ImageDecoder> decoder_;
+  fml::RefPtr<fml::TaskRunner> ui_task_runner_;
   fml::RefPtr<FrameInfo> cached_frame_;
 
   std::vector<PendingCallback> pending_callbacks_;
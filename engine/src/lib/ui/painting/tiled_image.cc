@@ -0,0 +1,544 @@
+#include "tiled_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "flutter/fml/logging.h"
+#include "flutter/fml/trace_event.h"
+#include "include/codec/SkCodec.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkMatrix.h"
+#include "lib/ui/external_data.h"
+#include "lib/ui/ui_mono_state.h"
+#include "lib/ui/window/window.h"
+
+namespace uiwidgets {
+
+namespace {
+
+SkImageInfo GetDecodeInfo(const SkCodec& codec) {
+  SkImageInfo info = codec.getInfo().makeColorType(kN32_SkColorType);
+  if (info.alphaType() == kUnpremul_SkAlphaType) {
+    info = info.makeAlphaType(kPremul_SkAlphaType);
+  }
+  return info;
+}
+
+// Decodes |region| of the image one row at a time, averaging each square of
+// |scale| by |scale| pixels into one pixel of |bitmap|, so that no more than
+// |scale| rows of the region are held in memory. Returns false if the codec
+// does not support scanline decoding from the top.
+bool DecodeRegionByScanlines(SkCodec* codec, const SkIRect& region, int scale,
+                             SkBitmap* bitmap) {
+  if (codec->getScanlineOrder() != SkCodec::kTopDown_SkScanlineOrder) {
+    return false;
+  }
+
+  const SkImageInfo info = GetDecodeInfo(*codec);
+  // Scanline decoders crop horizontally when they can. Others decode full
+  // rows, which are cropped here.
+  SkIRect columns = SkIRect::MakeLTRB(region.left(), 0, region.right(),
+                                      info.height());
+  SkCodec::Options options;
+  options.fSubset = &columns;
+  int row_offset = 0;
+  int row_width = region.width();
+  if (codec->startScanlineDecode(info, &options) != SkCodec::kSuccess) {
+    if (codec->startScanlineDecode(info) != SkCodec::kSuccess) {
+      return false;
+    }
+    row_offset = region.left();
+    row_width = info.width();
+  }
+  if (region.top() > 0 && !codec->skipScanlines(region.top())) {
+    return false;
+  }
+
+  std::vector<uint32_t> row(row_width);
+  const size_t row_bytes = row.size() * sizeof(uint32_t);
+
+  if (scale == 1) {
+    for (int y = 0; y < region.height(); y++) {
+      // Rows missing from an incomplete image are filled by the codec.
+      codec->getScanlines(row.data(), 1, row_bytes);
+      memcpy(bitmap->getAddr32(0, y), row.data() + row_offset,
+             region.width() * sizeof(uint32_t));
+    }
+    return true;
+  }
+
+  // Pixels are premultiplied, so their channels can be averaged
+  // independently.
+  const int width = bitmap->width();
+  std::vector<uint32_t> sums(width * 4);
+  for (int y = 0; y < bitmap->height(); y++) {
+    std::fill(sums.begin(), sums.end(), 0);
+    const int rows = std::min(scale, region.height() - y * scale);
+    for (int i = 0; i < rows; i++) {
+      codec->getScanlines(row.data(), 1, row_bytes);
+      const uint8_t* pixels =
+          reinterpret_cast<const uint8_t*>(row.data() + row_offset);
+      for (int x = 0; x < region.width(); x++) {
+        uint32_t* sum = &sums[(x / scale) * 4];
+        const uint8_t* pixel = pixels + x * 4;
+        sum[0] += pixel[0];
+        sum[1] += pixel[1];
+        sum[2] += pixel[2];
+        sum[3] += pixel[3];
+      }
+    }
+    uint8_t* dst = reinterpret_cast<uint8_t*>(bitmap->getAddr32(0, y));
+    for (int x = 0; x < width; x++) {
+      const int columns_count = std::min(scale, region.width() - x * scale);
+      const uint32_t count = rows * columns_count;
+      for (int c = 0; c < 4; c++) {
+        dst[x * 4 + c] =
+            static_cast<uint8_t>((sums[x * 4 + c] + count / 2) / count);
+      }
+    }
+  }
+  return true;
+}
+
+// Decodes the whole image at the size closest to 1/|scale| the codec
+// supports, and resamples |region| out of it. Used for codecs without
+// scanline decoding.
+bool DecodeRegionFromScaledImage(SkCodec* codec, const SkIRect& region,
+                                 int scale, SkBitmap* bitmap) {
+  const SkImageInfo info = GetDecodeInfo(*codec);
+  const SkISize scaled_size = codec->getScaledDimensions(1.0f / scale);
+  SkBitmap scaled;
+  if (!scaled.tryAllocPixels(info.makeWH(scaled_size.width(),
+                                         scaled_size.height()))) {
+    return false;
+  }
+  if (codec->getPixels(scaled.pixmap()) != SkCodec::kSuccess) {
+    return false;
+  }
+
+  const float sx = static_cast<float>(scaled_size.width()) / info.width();
+  const float sy = static_cast<float>(scaled_size.height()) / info.height();
+  SkIRect scaled_region =
+      SkRect::MakeLTRB(region.left() * sx, region.top() * sy,
+                       region.right() * sx, region.bottom() * sy)
+          .roundOut();
+  if (!scaled_region.intersect(SkIRect::MakeSize(scaled_size))) {
+    return false;
+  }
+  SkPixmap source;
+  if (!scaled.pixmap().extractSubset(&source, scaled_region)) {
+    return false;
+  }
+  return source.scalePixels(bitmap->pixmap(), kLow_SkFilterQuality);
+}
+
+}  // namespace
+
+fml::RefPtr<TiledImage> TiledImage::Create(sk_sp<SkData> data,
+                                           size_t cache_max_bytes) {
+  TRACE_EVENT0("uiwidgets", "TiledImage::Create");
+  std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+  if (!codec) {
+    return nullptr;
+  }
+
+  auto state = std::make_shared<State>();
+  state->data = std::move(data);
+  state->size = codec->getInfo().dimensions();
+  state->max_bytes =
+      cache_max_bytes > 0 ? cache_max_bytes : kDefaultCacheMaxBytes;
+  while (std::max(state->size.width(), state->size.height()) >
+         (kTileSize << state->max_level)) {
+    state->max_level++;
+  }
+
+  UIMonoState* mono_state = UIMonoState::Current();
+  state->concurrent_loop =
+      mono_state->window()->client()->GetConcurrentMessageLoop();
+  state->ui_task_runner = mono_state->GetTaskRunners().GetUITaskRunner();
+  state->mono_state = MonoState::Current()->GetWeakPtr();
+
+  auto image = fml::MakeRefCounted<TiledImage>(std::move(state));
+  {
+    std::scoped_lock lock(image->state_->mutex);
+    image->RequestTileLocked(image->state_->max_level, 0, 0);
+  }
+  return image;
+}
+
+TiledImage::TiledImage(std::shared_ptr<State> state)
+    : state_(std::move(state)) {}
+
+TiledImage::~TiledImage() {
+  // The last reference may be dropped on the finalizer thread while the UI
+  // thread reads the callback, so it is reset on the UI thread. Decoding
+  // tasks may still hold the state.
+  fml::TaskRunner::RunNowOrPostTask(state_->ui_task_runner, [state = state_]() {
+    std::shared_ptr<MonoState> mono_state = state->mono_state.lock();
+    if (!mono_state) {
+      return;
+    }
+    MonoState::Scope scope(mono_state);
+    state->ResetCallback();
+  });
+}
+
+void TiledImage::setTilesDecodedCallback(TilesDecodedCallback callback,
+                                         ReleaseCallbackHandle release,
+                                         Mono_Handle callback_handle) {
+  state_->ResetCallback();
+  state_->callback = callback;
+  state_->release_callback_handle = release;
+  state_->callback_handle = callback_handle;
+}
+
+void TiledImage::State::ResetCallback() {
+  ReleaseCallbackHandle release = release_callback_handle;
+  Mono_Handle handle = callback_handle;
+  callback = nullptr;
+  release_callback_handle = nullptr;
+  callback_handle = nullptr;
+  if (release) {
+    release(handle);
+  }
+}
+
+uint64_t TiledImage::MakeTileKey(int level, int x, int y) {
+  return (static_cast<uint64_t>(level) << 48) |
+         (static_cast<uint64_t>(x) << 24) | static_cast<uint64_t>(y);
+}
+
+SkIRect TiledImage::State::GetTileRegion(int level, int x, int y) const {
+  const int span = kTileSize << level;
+  SkIRect region = SkIRect::MakeXYWH(x * span, y * span, span, span);
+  if (!region.intersect(SkIRect::MakeSize(size))) {
+    return SkIRect::MakeEmpty();
+  }
+  return region;
+}
+
+sk_sp<SkImage> TiledImage::State::FindTileLocked(int level, int x, int y) {
+  if (level == max_level) {
+    return coarsest_tile;
+  }
+  auto it = index.find(MakeTileKey(level, x, y));
+  if (it == index.end()) {
+    return nullptr;
+  }
+  lru.splice(lru.begin(), lru, it->second);
+  return it->second->second;
+}
+
+void TiledImage::State::PutTileLocked(uint64_t key, sk_sp<SkImage> tile) {
+  const size_t tile_bytes = tile->imageInfo().computeMinByteSize();
+  while (bytes + tile_bytes > max_bytes && !lru.empty()) {
+    bytes -= lru.back().second->imageInfo().computeMinByteSize();
+    index.erase(lru.back().first);
+    lru.pop_back();
+  }
+  lru.emplace_front(key, std::move(tile));
+  index[key] = lru.begin();
+  bytes += tile_bytes;
+}
+
+std::vector<sk_sp<SkImage>> TiledImage::State::DecodeBand(
+    int level, int y, int first_x, int last_x) const {
+  TRACE_EVENT0("uiwidgets", "TiledImage::DecodeBand");
+  std::vector<sk_sp<SkImage>> tiles(last_x - first_x + 1);
+  SkIRect region = GetTileRegion(level, first_x, y);
+  region.join(GetTileRegion(level, last_x, y));
+  if (region.isEmpty()) {
+    return tiles;
+  }
+  std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+  if (!codec) {
+    return tiles;
+  }
+
+  const int scale = 1 << level;
+  const SkImageInfo info = GetDecodeInfo(*codec).makeWH(
+      (region.width() + scale - 1) / scale,
+      (region.height() + scale - 1) / scale);
+  SkBitmap bitmap;
+  if (!bitmap.tryAllocPixels(info)) {
+    return tiles;
+  }
+
+  bool decoded = false;
+  if (scale == 1) {
+    // Some codecs, such as WebP, decode subsets directly.
+    SkCodec::Options options;
+    SkIRect subset = region;
+    options.fSubset = &subset;
+    decoded = codec->getPixels(bitmap.pixmap(), &options) ==
+              SkCodec::kSuccess;
+  }
+  if (!decoded) {
+    decoded = DecodeRegionByScanlines(codec.get(), region, scale, &bitmap);
+  }
+  if (!decoded) {
+    codec = SkCodec::MakeFromData(data);
+    decoded = codec &&
+              DecodeRegionFromScaledImage(codec.get(), region, scale, &bitmap);
+  }
+  if (!decoded) {
+    FML_LOG(ERROR) << "Could not decode the tiles " << first_x << " to "
+                   << last_x << ", " << y << " of level " << level;
+    return tiles;
+  }
+
+  // Tiles are copied out of the band, so that each is released on its own
+  // when evicted.
+  for (int x = first_x; x <= last_x; x++) {
+    const SkIRect tile_region = GetTileRegion(level, x, y);
+    if (tile_region.isEmpty()) {
+      continue;
+    }
+    const SkIRect subset = SkIRect::MakeXYWH(
+        (tile_region.left() - region.left()) / scale, 0,
+        (tile_region.width() + scale - 1) / scale, bitmap.height());
+    SkPixmap tile;
+    if (bitmap.pixmap().extractSubset(&tile, subset)) {
+      tiles[x - first_x] = SkImage::MakeRasterCopy(tile);
+    }
+  }
+  return tiles;
+}
+
+void TiledImage::RequestTileLocked(int level, int x, int y) {
+  const uint64_t key = MakeTileKey(level, x, y);
+  if (!state_->pending.insert(key).second) {
+    return;
+  }
+
+  // Tiles requested before the band starts decoding join it.
+  std::set<int>& band = state_->pending_bands[MakeTileKey(level, 0, y)];
+  const bool scheduled = !band.empty();
+  band.insert(x);
+  if (scheduled) {
+    return;
+  }
+
+  auto decode = [weak_state = std::weak_ptr<State>(state_), level, y]() {
+    DecodePendingBand(weak_state, level, y);
+  };
+  if (state_->concurrent_loop) {
+    state_->concurrent_loop->GetTaskRunner()->PostTask(std::move(decode));
+  } else {
+    state_->ui_task_runner->PostTask(std::move(decode));
+  }
+}
+
+void TiledImage::DecodePendingBand(std::weak_ptr<State> weak_state, int level,
+                                   int y) {
+  std::shared_ptr<State> state = weak_state.lock();
+  if (!state) {
+    return;
+  }
+
+  std::set<int> requested;
+  {
+    std::scoped_lock lock(state->mutex);
+    auto band = state->pending_bands.find(MakeTileKey(level, 0, y));
+    if (band == state->pending_bands.end()) {
+      return;
+    }
+    requested = std::move(band->second);
+    state->pending_bands.erase(band);
+  }
+
+  // The tiles between the requested ones come for free.
+  const int first_x = *requested.begin();
+  std::vector<sk_sp<SkImage>> tiles =
+      state->DecodeBand(level, y, first_x, *requested.rbegin());
+  OnBandDecoded(weak_state, level, y, requested, first_x, std::move(tiles));
+}
+
+void TiledImage::OnBandDecoded(std::weak_ptr<State> weak_state, int level,
+                               int y, const std::set<int>& requested,
+                               int first_x,
+                               std::vector<sk_sp<SkImage>> tiles) {
+  std::shared_ptr<State> state = weak_state.lock();
+  if (!state) {
+    return;
+  }
+
+  std::scoped_lock lock(state->mutex);
+  for (int x : requested) {
+    state->pending.erase(MakeTileKey(level, x, y));
+  }
+  bool any_decoded = false;
+  for (size_t i = 0; i < tiles.size(); i++) {
+    if (!tiles[i]) {
+      continue;
+    }
+    const uint64_t key = MakeTileKey(level, first_x + static_cast<int>(i), y);
+    if (level == state->max_level) {
+      state->coarsest_tile = std::move(tiles[i]);
+    } else if (state->index.find(key) == state->index.end()) {
+      state->PutTileLocked(key, std::move(tiles[i]));
+    }
+    any_decoded = true;
+  }
+
+  if (!any_decoded || state->notify_scheduled) {
+    return;
+  }
+  state->notify_scheduled = true;
+  state->ui_task_runner->PostTask([weak_state]() {
+    std::shared_ptr<State> state = weak_state.lock();
+    if (!state) {
+      return;
+    }
+    {
+      std::scoped_lock lock(state->mutex);
+      state->notify_scheduled = false;
+    }
+    std::shared_ptr<MonoState> mono_state = state->mono_state.lock();
+    if (!state->callback || !mono_state) {
+      return;
+    }
+    MonoState::Scope scope(mono_state);
+    state->callback(state->callback_handle);
+  });
+}
+
+void TiledImage::Draw(SkCanvas* canvas, const SkRect& src, const SkRect& dst,
+                      const SkPaint& paint, float device_pixel_ratio) {
+  TRACE_EVENT0("uiwidgets", "TiledImage::Draw");
+  if (src.isEmpty() || dst.isEmpty()) {
+    return;
+  }
+  const SkMatrix src_to_dst =
+      SkMatrix::MakeRectToRect(src, dst, SkMatrix::kFill_ScaleToFit);
+  SkMatrix dst_to_src;
+  if (!src_to_dst.invert(&dst_to_src)) {
+    return;
+  }
+
+  // Only the tiles covering the visible part of |dst| are needed.
+  SkRect visible_dst = dst;
+  if (!visible_dst.intersect(canvas->getLocalClipBounds())) {
+    return;
+  }
+  SkRect visible_src = dst_to_src.mapRect(visible_dst);
+  if (!visible_src.intersect(src) ||
+      !visible_src.intersect(SkRect::Make(state_->size))) {
+    return;
+  }
+
+  // Pictures are recorded without the device pixel ratio, which is applied
+  // by the root layer.
+  float device_scale = canvas->getTotalMatrix().getMaxScale();
+  if (device_scale <= 0) {
+    device_scale = 1;
+  }
+  device_scale *= device_pixel_ratio *
+                  std::max(dst.width() / src.width(),
+                           dst.height() / src.height());
+  int level = 0;
+  if (device_scale < 1) {
+    level = static_cast<int>(std::floor(std::log2(1 / device_scale)));
+  }
+  level = std::min(std::max(level, 0), state_->max_level);
+
+  SkPaint tile_paint = paint;
+  // Anti-aliased tile edges would leave seams between tiles.
+  tile_paint.setAntiAlias(false);
+
+  canvas->save();
+  canvas->clipRect(dst);
+  canvas->concat(src_to_dst);
+
+  const int span = kTileSize << level;
+  const int left = static_cast<int>(visible_src.left()) / span;
+  const int top = static_cast<int>(visible_src.top()) / span;
+  const int right = static_cast<int>(std::ceil(visible_src.right())) / span;
+  const int bottom = static_cast<int>(std::ceil(visible_src.bottom())) / span;
+
+  std::scoped_lock lock(state_->mutex);
+  for (int y = top; y <= bottom; y++) {
+    for (int x = left; x <= right; x++) {
+      const SkRect region =
+          SkRect::Make(state_->GetTileRegion(level, x, y));
+      if (region.isEmpty() || !region.intersects(visible_src)) {
+        continue;
+      }
+
+      // Falls back to the closest coarser tile covering this one.
+      int tile_level = level;
+      sk_sp<SkImage> tile = state_->FindTileLocked(level, x, y);
+      if (!tile) {
+        RequestTileLocked(level, x, y);
+        while (!tile && ++tile_level <= state_->max_level) {
+          const int shift = tile_level - level;
+          tile = state_->FindTileLocked(tile_level, x >> shift, y >> shift);
+        }
+      }
+      if (!tile) {
+        continue;
+      }
+
+      const int shift = tile_level - level;
+      const SkRect tile_region = SkRect::Make(
+          state_->GetTileRegion(tile_level, x >> shift, y >> shift));
+      const float tile_scale = 1.0f / (1 << tile_level);
+      canvas->save();
+      canvas->clipRect(region);
+      canvas->drawImageRect(
+          tile,
+          SkRect::MakeWH(tile_region.width() * tile_scale,
+                         tile_region.height() * tile_scale),
+          tile_region, &tile_paint, SkCanvas::kFast_SrcRectConstraint);
+      canvas->restore();
+    }
+  }
+  canvas->restore();
+}
+
+UIWIDGETS_API(TiledImage*)
+TiledImage_createFromBuffer(const uint8_t* data, int data_length,
+                            ReleaseExternalDataCallback release_callback,
+                            Mono_Handle release_handle, int cache_max_bytes) {
+  fml::RefPtr<TiledImage> image = TiledImage::Create(
+      MakeSkDataFromExternalBuffer(data, data_length, release_callback,
+                                   release_handle),
+      std::max(cache_max_bytes, 0));
+  if (!image) {
+    return nullptr;
+  }
+  image->AddRef();
+  return image.get();
+}
+
+UIWIDGETS_API(TiledImage*)
+TiledImage_createFromFile(char* path, int cache_max_bytes) {
+  sk_sp<SkData> data = MakeSkDataFromFile(path);
+  if (!data) {
+    return nullptr;
+  }
+  fml::RefPtr<TiledImage> image =
+      TiledImage::Create(std::move(data), std::max(cache_max_bytes, 0));
+  if (!image) {
+    return nullptr;
+  }
+  image->AddRef();
+  return image.get();
+}
+
+UIWIDGETS_API(void) TiledImage_dispose(TiledImage* ptr) { ptr->Release(); }
+
+UIWIDGETS_API(int) TiledImage_width(TiledImage* ptr) { return ptr->width(); }
+
+UIWIDGETS_API(int) TiledImage_height(TiledImage* ptr) { return ptr->height(); }
+
+UIWIDGETS_API(void)
+TiledImage_setTilesDecodedCallback(
+    TiledImage* ptr, TiledImage::TilesDecodedCallback callback,
+    TiledImage::ReleaseCallbackHandle release, Mono_Handle callback_handle) {
+  ptr->setTilesDecodedCallback(callback, release, callback_handle);
+}
+
+}  // namespace uiwidgets
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "flutter/fml/concurrent_message_loop.h"
+#include "flutter/fml/macros.h"
+#include "flutter/fml/memory/ref_counted.h"
+#include "flutter/fml/task_runner.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "runtime/mono_state.h"
+
+namespace uiwidgets {
+
+// An image too large to be decoded at once, such as a map or a scanned
+// document. Only the encoded bytes are kept. The parts of the image that are
+// drawn are decoded in square tiles, at the resolution they are drawn at, on
+// the concurrent worker pool, and kept in an LRU cache of tiles. The tiles
+// requested in a row of tiles are decoded together, in one pass over the
+// source rows of that band.
+//
+// Levels are powers of two: a tile of level n covers 2^n times as many image
+// pixels in each direction as a tile of level 0. The coarsest level holds the
+// whole image in a single tile, which is decoded on creation and never
+// evicted, so that there is always something to draw while finer tiles are
+// decoded.
+class TiledImage : public fml::RefCountedThreadSafe<TiledImage> {
+  FML_FRIEND_MAKE_REF_COUNTED(TiledImage);
+
+ public:
+  typedef void (*TilesDecodedCallback)(Mono_Handle callback_handle);
+  typedef void (*ReleaseCallbackHandle)(Mono_Handle callback_handle);
+
+  static constexpr int kTileSize = 512;
+
+  static constexpr size_t kDefaultCacheMaxBytes = 64 * 1024 * 1024;
+
+  // Returns null if no codec recognizes |data|. Must be called on the UI
+  // thread.
+  static fml::RefPtr<TiledImage> Create(sk_sp<SkData> data,
+                                        size_t cache_max_bytes);
+
+  ~TiledImage();
+
+  int width() const { return state_->size.width(); }
+
+  int height() const { return state_->size.height(); }
+
+  // Sets the callback invoked on the UI thread when tiles requested by Draw
+  // have been decoded, so that the content drawing them can be repainted.
+  // Tiles decoded together are reported once. |release| is called with
+  // |callback_handle| on the UI thread once the callback is replaced or the
+  // image destroyed. Must be called on the UI thread.
+  void setTilesDecodedCallback(TilesDecodedCallback callback,
+                               ReleaseCallbackHandle release,
+                               Mono_Handle callback_handle);
+
+  // Draws the |src| rectangle of the image, in image pixels, into |dst|.
+  // Only the tiles covering the part of |dst| within the clip of |canvas| are
+  // drawn, at the level matching the scale they are drawn at. Tiles that are
+  // not decoded yet are requested, and replaced by the closest coarser tile
+  // available meanwhile.
+  void Draw(SkCanvas* canvas, const SkRect& src, const SkRect& dst,
+            const SkPaint& paint, float device_pixel_ratio);
+
+ private:
+  // Captures the state shared between the UI thread and the decoding tasks,
+  // which may outlive the TiledImage.
+  struct State {
+    sk_sp<SkData> data;
+    SkISize size;
+    int max_level = 0;
+    size_t max_bytes = 0;
+
+    std::shared_ptr<fml::ConcurrentMessageLoop> concurrent_loop;
+    fml::RefPtr<fml::TaskRunner> ui_task_runner;
+
+    // Only accessed on the UI thread.
+    std::weak_ptr<MonoState> mono_state;
+    TilesDecodedCallback callback = nullptr;
+    ReleaseCallbackHandle release_callback_handle = nullptr;
+    Mono_Handle callback_handle = nullptr;
+
+    // Drops the callback and releases its handle. Must be called on the UI
+    // thread within the scope of |mono_state|.
+    void ResetCallback();
+
+    // Guards the members below, which are accessed by the decoding tasks.
+    std::mutex mutex;
+    sk_sp<SkImage> coarsest_tile;
+    // Most recently used first.
+    std::list<std::pair<uint64_t, sk_sp<SkImage>>> lru;
+    std::unordered_map<uint64_t, decltype(lru)::iterator> index;
+    size_t bytes = 0;
+    std::unordered_set<uint64_t> pending;
+    // The columns of the pending tiles whose band has not started decoding,
+    // keyed like the first tile of the band.
+    std::unordered_map<uint64_t, std::set<int>> pending_bands;
+    bool notify_scheduled = false;
+
+    // Returns the tile if it is decoded, and marks it as recently used.
+    sk_sp<SkImage> FindTileLocked(int level, int x, int y);
+    void PutTileLocked(uint64_t key, sk_sp<SkImage> tile);
+
+    // Returns the region of the image covered by a tile.
+    SkIRect GetTileRegion(int level, int x, int y) const;
+
+    // Decodes the tiles |first_x| to |last_x| of the row |y| of |level|,
+    // indexed from |first_x|. Tiles that could not be decoded are null.
+    std::vector<sk_sp<SkImage>> DecodeBand(int level, int y, int first_x,
+                                           int last_x) const;
+  };
+
+  std::shared_ptr<State> state_;
+
+  TiledImage(std::shared_ptr<State> state);
+
+  static uint64_t MakeTileKey(int level, int x, int y);
+
+  // Schedules the decoding of a tile unless it is already in progress.
+  void RequestTileLocked(int level, int x, int y);
+
+  static void DecodePendingBand(std::weak_ptr<State> weak_state, int level,
+                                int y);
+
+  static void OnBandDecoded(std::weak_ptr<State> weak_state, int level, int y,
+                            const std::set<int>& requested, int first_x,
+                            std::vector<sk_sp<SkImage>> tiles);
+
+  FML_DISALLOW_COPY_AND_ASSIGN(TiledImage);
+};
+
+}  // namespace uiwidgets
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "include/core/SkData.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkPicture.h"
 
@@ -11,6 +12,13 @@ class SnapshotDelegate {
                                             SkISize picture_size) = 0;
 
   virtual sk_sp<SkImage> ConvertToRasterImage(sk_sp<SkImage> image) = 0;
+
+  // Uploads blocks of a GPU compressed texture as they are. Returns null if
+  // there is no GPU context or if it does not support |type|. The image
+  // belongs to the raster context and must be collected on the raster thread.
+  virtual sk_sp<SkImage> MakeCompressedTextureImage(
+      sk_sp<SkData> data, SkISize dimensions,
+      SkImage::CompressionType type) = 0;
 };
 
 }  // namespace uiwidgets
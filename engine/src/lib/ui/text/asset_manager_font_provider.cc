@@ -1,5 +1,7 @@
 #include "asset_manager_font_provider.h"
 
+#include <algorithm>
+
 #include "flutter/fml/logging.h"
 #include "include/core/SkData.h"
 #include "include/core/SkStream.h"
@@ -14,6 +16,78 @@ void MappingReleaseProc(const void* ptr, void* context) {
   delete reinterpret_cast<fml::Mapping*>(context);
 }
 
+uint16_t ReadU16(const uint8_t* data) {
+  return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+uint32_t ReadU32(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24) |
+         (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+// Reads the weight, width and slant of the first font in |data| from its
+// OS/2 table, without parsing the rest of the font. Returns false for
+// fonts without an OS/2 table or that are malformed.
+bool ReadFontStyle(const uint8_t* data, size_t size, SkFontStyle* style) {
+  constexpr uint32_t kCollectionTag = 0x74746366;  // 'ttcf'
+  constexpr uint32_t kOS2Tag = 0x4F532F32;         // 'OS/2'
+  constexpr size_t kOffsetTableSize = 12;
+  constexpr size_t kTableRecordSize = 16;
+  // The OS/2 fields used below end with fsSelection at offset 62.
+  constexpr size_t kOS2MinSize = 64;
+
+  if (size < kOffsetTableSize) {
+    return false;
+  }
+  size_t font_offset = 0;
+  if (ReadU32(data) == kCollectionTag) {
+    // Font collections list the offsets of their fonts after the header.
+    if (size < 16) {
+      return false;
+    }
+    font_offset = ReadU32(data + 12);
+    if (font_offset > size - kOffsetTableSize) {
+      return false;
+    }
+  }
+
+  const uint8_t* font = data + font_offset;
+  const size_t table_count = ReadU16(font + 4);
+  const size_t records_offset = font_offset + kOffsetTableSize;
+  if (table_count * kTableRecordSize > size - records_offset) {
+    return false;
+  }
+  for (size_t i = 0; i < table_count; i++) {
+    const uint8_t* record = data + records_offset + i * kTableRecordSize;
+    if (ReadU32(record) != kOS2Tag) {
+      continue;
+    }
+    const size_t table_offset = ReadU32(record + 8);
+    const size_t table_size = ReadU32(record + 12);
+    if (table_size < kOS2MinSize || table_offset > size ||
+        table_size > size - table_offset) {
+      return false;
+    }
+    const uint8_t* os2 = data + table_offset;
+    const int weight = ReadU16(os2 + 4);
+    const int width = ReadU16(os2 + 6);
+    const uint16_t selection = ReadU16(os2 + 62);
+    SkFontStyle::Slant slant = SkFontStyle::kUpright_Slant;
+    if (selection & (1 << 0)) {
+      slant = SkFontStyle::kItalic_Slant;
+    } else if (selection & (1 << 9)) {
+      slant = SkFontStyle::kOblique_Slant;
+    }
+    const int clamped_width =
+        std::clamp(width, static_cast<int>(SkFontStyle::kUltraCondensed_Width),
+                   static_cast<int>(SkFontStyle::kUltraExpanded_Width));
+    *style = SkFontStyle(weight, clamped_width, slant);
+    return true;
+  }
+  return false;
+}
+
 }  // anonymous namespace
 
 AssetManagerFontProvider::AssetManagerFontProvider(
@@ -45,7 +119,8 @@ SkFontStyleSet* AssetManagerFontProvider::MatchFamily(
 }
 
 void AssetManagerFontProvider::RegisterAsset(std::string family_name,
-                                             std::string asset) {
+                                             std::string asset,
+                                             std::optional<SkFontStyle> style) {
   std::string canonical_name = CanonicalFamilyName(family_name);
   auto family_it = registered_families_.find(canonical_name);
 
@@ -57,7 +132,7 @@ void AssetManagerFontProvider::RegisterAsset(std::string family_name,
     family_it = registered_families_.emplace(value).first;
   }
 
-  family_it->second->registerAsset(asset);
+  family_it->second->registerAsset(asset, style);
 }
 
 AssetManagerFontStyleSet::AssetManagerFontStyleSet(
@@ -66,8 +141,9 @@ AssetManagerFontStyleSet::AssetManagerFontStyleSet(
 
 AssetManagerFontStyleSet::~AssetManagerFontStyleSet() = default;
 
-void AssetManagerFontStyleSet::registerAsset(std::string asset) {
-  assets_.emplace_back(asset);
+void AssetManagerFontStyleSet::registerAsset(
+    std::string asset, std::optional<SkFontStyle> style) {
+  assets_.emplace_back(asset, style);
 }
 
 int AssetManagerFontStyleSet::count() { return assets_.size(); }
@@ -76,10 +152,7 @@ void AssetManagerFontStyleSet::getStyle(int index, SkFontStyle* style,
                                         SkString* name) {
   FML_DCHECK(index < static_cast<int>(assets_.size()));
   if (style) {
-    sk_sp<SkTypeface> typeface(createTypeface(index));
-    if (typeface) {
-      *style = typeface->fontStyle();
-    }
+    *style = GetAssetStyle(index);
   }
   if (name) {
     *name = family_name_.c_str();
@@ -90,6 +163,7 @@ SkTypeface* AssetManagerFontStyleSet::createTypeface(int i) {
   size_t index = i;
   if (index >= assets_.size()) return nullptr;
 
+  std::scoped_lock lock(assets_mutex_);
   TypefaceAsset& asset = assets_[index];
   if (!asset.typeface) {
     std::unique_ptr<fml::Mapping> asset_mapping =
@@ -116,8 +190,39 @@ SkTypeface* AssetManagerFontStyleSet::matchStyle(const SkFontStyle& pattern) {
   return matchStyleCSS3(pattern);
 }
 
-AssetManagerFontStyleSet::TypefaceAsset::TypefaceAsset(std::string a)
-    : asset(std::move(a)) {}
+SkFontStyle AssetManagerFontStyleSet::GetAssetStyle(size_t index) {
+  {
+    std::scoped_lock lock(assets_mutex_);
+    TypefaceAsset& asset = assets_[index];
+    if (asset.style) {
+      return *asset.style;
+    }
+    if (asset.typeface) {
+      asset.style = asset.typeface->fontStyle();
+      return *asset.style;
+    }
+    std::unique_ptr<fml::Mapping> asset_mapping =
+        asset_manager_->GetAsMapping(asset.asset);
+    SkFontStyle style;
+    if (asset_mapping != nullptr &&
+        ReadFontStyle(asset_mapping->GetMapping(), asset_mapping->GetSize(),
+                      &style)) {
+      asset.style = style;
+      return style;
+    }
+  }
+
+  // Fonts without a readable OS/2 table are parsed by Skia.
+  sk_sp<SkTypeface> typeface(createTypeface(index));
+  SkFontStyle style = typeface ? typeface->fontStyle() : SkFontStyle();
+  std::scoped_lock lock(assets_mutex_);
+  assets_[index].style = style;
+  return style;
+}
+
+AssetManagerFontStyleSet::TypefaceAsset::TypefaceAsset(
+    std::string a, std::optional<SkFontStyle> s)
+    : asset(std::move(a)), style(s) {}
 
 AssetManagerFontStyleSet::TypefaceAsset::TypefaceAsset(
     const AssetManagerFontStyleSet::TypefaceAsset& other) = default;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -20,7 +22,10 @@ class AssetManagerFontStyleSet : public SkFontStyleSet {
 
   ~AssetManagerFontStyleSet() override;
 
-  void registerAsset(std::string asset);
+  // Registers a font of the family. |style| is the style declared for it by
+  // the font manifest, if any. Otherwise the style is read from the font
+  // file when the family is first matched.
+  void registerAsset(std::string asset, std::optional<SkFontStyle> style);
 
   // |SkFontStyleSet|
   int count() override;
@@ -39,16 +44,25 @@ class AssetManagerFontStyleSet : public SkFontStyleSet {
   std::string family_name_;
 
   struct TypefaceAsset {
-    TypefaceAsset(std::string a);
+    TypefaceAsset(std::string a, std::optional<SkFontStyle> s);
 
     TypefaceAsset(const TypefaceAsset& other);
 
     ~TypefaceAsset();
 
     std::string asset;
+    std::optional<SkFontStyle> style;
     sk_sp<SkTypeface> typeface;
   };
   std::vector<TypefaceAsset> assets_;
+  // Styles and typefaces are resolved on first use, possibly by paragraphs
+  // laid out concurrently on worker threads.
+  std::mutex assets_mutex_;
+
+  // Returns the style of the font at |index| without creating its typeface
+  // when the style is declared by the manifest or can be read from the font
+  // file.
+  SkFontStyle GetAssetStyle(size_t index);
 
   FML_DISALLOW_COPY_AND_ASSIGN(AssetManagerFontStyleSet);
 };
@@ -59,7 +73,8 @@ class AssetManagerFontProvider : public txt::FontAssetProvider {
 
   ~AssetManagerFontProvider() override;
 
-  void RegisterAsset(std::string family_name, std::string asset);
+  void RegisterAsset(std::string family_name, std::string asset,
+                     std::optional<SkFontStyle> style = std::nullopt);
 
   // |FontAssetProvider|
   size_t GetFamilyCount() const override;
@@ -0,0 +1,349 @@
+#include "editable_paragraph.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+#include "flutter/fml/trace_event.h"
+#include "lib/ui/ui_mono_state.h"
+#include "txt/paragraph_builder.h"
+
+namespace uiwidgets {
+
+namespace {
+
+// Empty blocks are laid out with a zero width space, so that they have the
+// height of a line.
+constexpr char16_t kEmptyBlockText[] = u"\u200B";
+
+}  // namespace
+
+EditableParagraph::EditableParagraph(
+    const txt::ParagraphStyle& paragraph_style,
+    const txt::TextStyle& text_style,
+    std::shared_ptr<txt::FontCollection> font_collection,
+    const std::u16string& text)
+    : paragraph_style_(paragraph_style),
+      text_style_(text_style),
+      font_collection_(std::move(font_collection)),
+      blocks_(SplitBlocks(text)) {
+  paragraph_style_.max_lines = std::numeric_limits<size_t>::max();
+  paragraph_style_.ellipsis.clear();
+}
+
+EditableParagraph::~EditableParagraph() = default;
+
+std::vector<EditableParagraph::Block> EditableParagraph::SplitBlocks(
+    const std::u16string& text) {
+  std::vector<Block> blocks;
+  size_t start = 0;
+  while (true) {
+    size_t end = text.find(u'\n', start);
+    if (end == std::u16string::npos) {
+      blocks.push_back({text.substr(start), nullptr});
+      return blocks;
+    }
+    blocks.push_back({text.substr(start, end - start), nullptr});
+    start = end + 1;
+  }
+}
+
+void EditableParagraph::replace(unsigned offset, unsigned length,
+                                const std::u16string& text) {
+  const size_t text_length = textLength();
+  const size_t start = std::min<size_t>(offset, text_length);
+  const size_t end = std::min<size_t>(start + length, text_length);
+  const size_t first = GetBlockForOffset(start);
+  const size_t last = GetBlockForOffset(end);
+
+  std::u16string edited =
+      blocks_[first].text.substr(0, start - block_offsets_[first]);
+  edited += text;
+  edited += blocks_[last].text.substr(end - block_offsets_[last]);
+  std::vector<Block> replacement = SplitBlocks(edited);
+
+  blocks_.erase(blocks_.begin() + first + 1, blocks_.begin() + last + 1);
+  blocks_[first] = std::move(replacement[0]);
+  blocks_.insert(blocks_.begin() + first + 1,
+                 std::make_move_iterator(replacement.begin() + 1),
+                 std::make_move_iterator(replacement.end()));
+  first_invalid_position_ = std::min(first_invalid_position_, first);
+}
+
+size_t EditableParagraph::textLength() {
+  UpdatePositions();
+  return block_offsets_.back() + blocks_.back().text.size();
+}
+
+float EditableParagraph::width() { return std::max(width_, 0.0f); }
+
+float EditableParagraph::height() {
+  UpdatePositions();
+  return height_;
+}
+
+float EditableParagraph::longestLine() {
+  float longest_line = 0;
+  for (const Block& block : blocks_) {
+    if (block.paragraph) {
+      longest_line = std::max(longest_line, block.paragraph->GetLongestLine());
+    }
+  }
+  return longest_line;
+}
+
+float EditableParagraph::minIntrinsicWidth() {
+  float min_intrinsic_width = 0;
+  for (const Block& block : blocks_) {
+    if (block.paragraph) {
+      min_intrinsic_width = std::max(min_intrinsic_width,
+                                     block.paragraph->GetMinIntrinsicWidth());
+    }
+  }
+  return min_intrinsic_width;
+}
+
+float EditableParagraph::maxIntrinsicWidth() {
+  float max_intrinsic_width = 0;
+  for (const Block& block : blocks_) {
+    if (block.paragraph) {
+      max_intrinsic_width = std::max(max_intrinsic_width,
+                                     block.paragraph->GetMaxIntrinsicWidth());
+    }
+  }
+  return max_intrinsic_width;
+}
+
+void EditableParagraph::layout(float width) {
+  TRACE_EVENT0("uiwidgets", "EditableParagraph::layout");
+  const bool width_changed = width != width_;
+  width_ = width;
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    Block& block = blocks_[i];
+    if (block.paragraph && !width_changed) {
+      continue;
+    }
+    if (!block.paragraph) {
+      block.paragraph = BuildBlock(block);
+    }
+    block.paragraph->Layout(width);
+    first_invalid_position_ = std::min(first_invalid_position_, i);
+  }
+  UpdatePositions();
+}
+
+void EditableParagraph::paint(Canvas* canvas, float x, float y) {
+  SkCanvas* sk_canvas = canvas->canvas();
+  if (!sk_canvas) return;
+
+  const SkRect clip = sk_canvas->getLocalClipBounds();
+  for (size_t i = GetBlockForY(clip.fTop - y);
+       i < blocks_.size() && block_tops_[i] < clip.fBottom - y; i++) {
+    if (blocks_[i].paragraph) {
+      blocks_[i].paragraph->Paint(sk_canvas, x, y + block_tops_[i]);
+    }
+  }
+}
+
+Float32List EditableParagraph::getRectsForRange(unsigned start, unsigned end,
+                                                unsigned boxHeightStyle,
+                                                unsigned boxWidthStyle) {
+  std::vector<txt::Paragraph::TextBox> boxes;
+  for (size_t i = GetBlockForOffset(start);
+       i < blocks_.size() && block_offsets_[i] <= end; i++) {
+    const Block& block = blocks_[i];
+    const size_t block_offset = block_offsets_[i];
+    const size_t block_start = std::max<size_t>(start, block_offset);
+    const size_t block_end =
+        std::min<size_t>(end, block_offset + block.text.size());
+    if (!block.paragraph || block_start >= block_end) {
+      continue;
+    }
+    std::vector<txt::Paragraph::TextBox> block_boxes =
+        block.paragraph->GetRectsForRange(
+            block_start - block_offset, block_end - block_offset,
+            static_cast<txt::Paragraph::RectHeightStyle>(boxHeightStyle),
+            static_cast<txt::Paragraph::RectWidthStyle>(boxWidthStyle));
+    for (txt::Paragraph::TextBox& box : block_boxes) {
+      box.rect.offset(0, block_tops_[i]);
+      boxes.push_back(box);
+    }
+  }
+
+  // Layout:
+  // boxes.size() groups of 5 which are LTRBD, where D is the text direction
+  // index.
+  int size = boxes.size() * 5;
+  Float32List result = {(float*)malloc(sizeof(float) * size), size};
+  unsigned long position = 0;
+  for (const txt::Paragraph::TextBox& box : boxes) {
+    result.data[position++] = box.rect.fLeft;
+    result.data[position++] = box.rect.fTop;
+    result.data[position++] = box.rect.fRight;
+    result.data[position++] = box.rect.fBottom;
+    result.data[position++] = static_cast<float>(box.direction);
+  }
+  return result;
+}
+
+void EditableParagraph::getPositionForOffset(float dx, float dy, int* offset) {
+  const size_t i = GetBlockForY(dy);
+  const Block& block = blocks_[i];
+  if (!block.paragraph) {
+    offset[0] = block_offsets_[i];
+    offset[1] = static_cast<int>(txt::Paragraph::Affinity::DOWNSTREAM);
+    return;
+  }
+  txt::Paragraph::PositionWithAffinity pos =
+      block.paragraph->GetGlyphPositionAtCoordinate(dx, dy - block_tops_[i]);
+  offset[0] = block_offsets_[i] + std::min(pos.position, block.text.size());
+  offset[1] = static_cast<int>(pos.affinity);
+}
+
+void EditableParagraph::getLineBoundary(unsigned offset, int* boundaryPtr) {
+  boundaryPtr[0] = -1;
+  boundaryPtr[1] = -1;
+  if (offset > textLength()) {
+    return;
+  }
+  const size_t i = GetBlockForOffset(offset);
+  const Block& block = blocks_[i];
+  const size_t block_offset = block_offsets_[i];
+  if (!block.paragraph) {
+    return;
+  }
+  const size_t local_offset = offset - block_offset;
+  for (const txt::LineMetrics& line : block.paragraph->GetLineMetrics()) {
+    if (local_offset >= line.start_index && local_offset <= line.end_index) {
+      boundaryPtr[0] = block_offset + line.start_index;
+      boundaryPtr[1] =
+          block_offset + std::min(line.end_index, block.text.size());
+      return;
+    }
+  }
+}
+
+size_t EditableParagraph::GetAllocationSize() {
+  // Like Paragraph, every laid out block is accounted with a fixed size.
+  return blocks_.size() * 2000;
+}
+
+void EditableParagraph::UpdatePositions() {
+  const size_t block_count = blocks_.size();
+  if (first_invalid_position_ >= block_count &&
+      block_offsets_.size() == block_count) {
+    return;
+  }
+  block_offsets_.resize(block_count);
+  block_tops_.resize(block_count);
+
+  size_t i = std::min(first_invalid_position_, block_count);
+  size_t offset = 0;
+  float top = 0;
+  if (i > 0) {
+    const Block& previous = blocks_[i - 1];
+    offset = block_offsets_[i - 1] + previous.text.size() + 1;
+    top = block_tops_[i - 1] +
+          (previous.paragraph ? previous.paragraph->GetHeight() : 0);
+  }
+  for (; i < block_count; i++) {
+    const Block& block = blocks_[i];
+    block_offsets_[i] = offset;
+    block_tops_[i] = top;
+    offset += block.text.size() + 1;
+    top += block.paragraph ? block.paragraph->GetHeight() : 0;
+  }
+  height_ = top;
+  first_invalid_position_ = block_count;
+}
+
+size_t EditableParagraph::GetBlockForOffset(size_t offset) {
+  UpdatePositions();
+  auto it =
+      std::upper_bound(block_offsets_.begin(), block_offsets_.end(), offset);
+  return it == block_offsets_.begin() ? 0 : it - block_offsets_.begin() - 1;
+}
+
+size_t EditableParagraph::GetBlockForY(float y) {
+  UpdatePositions();
+  auto it = std::upper_bound(block_tops_.begin(), block_tops_.end(), y);
+  return it == block_tops_.begin() ? 0 : it - block_tops_.begin() - 1;
+}
+
+std::unique_ptr<txt::Paragraph> EditableParagraph::BuildBlock(
+    const Block& block) const {
+  auto builder = txt::ParagraphBuilder::CreateTxtBuilder(paragraph_style_,
+                                                         font_collection_);
+  builder->PushStyle(text_style_);
+  builder->AddText(block.text.empty() ? std::u16string(kEmptyBlockText)
+                                      : block.text);
+  builder->Pop();
+  return builder->Build();
+}
+
+UIWIDGETS_API(void)
+EditableParagraph_replace(EditableParagraph* ptr, int offset, int length,
+                          char16_t* text) {
+  ptr->replace(offset, length, text ? std::u16string(text) : u"");
+}
+
+UIWIDGETS_API(int) EditableParagraph_textLength(EditableParagraph* ptr) {
+  return ptr->textLength();
+}
+
+UIWIDGETS_API(float) EditableParagraph_width(EditableParagraph* ptr) {
+  return ptr->width();
+}
+
+UIWIDGETS_API(float) EditableParagraph_height(EditableParagraph* ptr) {
+  return ptr->height();
+}
+
+UIWIDGETS_API(float) EditableParagraph_longestLine(EditableParagraph* ptr) {
+  return ptr->longestLine();
+}
+
+UIWIDGETS_API(float)
+EditableParagraph_minIntrinsicWidth(EditableParagraph* ptr) {
+  return ptr->minIntrinsicWidth();
+}
+
+UIWIDGETS_API(float)
+EditableParagraph_maxIntrinsicWidth(EditableParagraph* ptr) {
+  return ptr->maxIntrinsicWidth();
+}
+
+UIWIDGETS_API(void)
+EditableParagraph_layout(EditableParagraph* ptr, float width) {
+  ptr->layout(width);
+}
+
+UIWIDGETS_API(void)
+EditableParagraph_paint(EditableParagraph* ptr, Canvas* canvas, float x,
+                        float y) {
+  ptr->paint(canvas, x, y);
+}
+
+UIWIDGETS_API(Float32List)
+EditableParagraph_getRectsForRange(EditableParagraph* ptr, int start, int end,
+                                   int boxHeightStyle, int boxWidthStyle) {
+  return ptr->getRectsForRange(start, end, boxHeightStyle, boxWidthStyle);
+}
+
+UIWIDGETS_API(void)
+EditableParagraph_getPositionForOffset(EditableParagraph* ptr, float dx,
+                                       float dy, int* offset) {
+  ptr->getPositionForOffset(dx, dy, offset);
+}
+
+UIWIDGETS_API(void)
+EditableParagraph_getLineBoundary(EditableParagraph* ptr, int offset,
+                                  int* boundaryPtr) {
+  ptr->getLineBoundary(offset, boundaryPtr);
+}
+
+UIWIDGETS_API(void) EditableParagraph_dispose(EditableParagraph* ptr) {
+  ptr->Release();
+}
+
+}  // namespace uiwidgets
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flutter/fml/memory/ref_counted.h"
+#include "lib/ui/painting/canvas.h"
+#include "shell/common/lists.h"
+#include "txt/font_collection.h"
+#include "txt/paragraph.h"
+#include "txt/paragraph_style.h"
+#include "txt/text_style.h"
+
+namespace uiwidgets {
+
+// A paragraph of plain text that is edited in place, for text fields and
+// editors showing long documents.
+//
+// The text is split into blocks at hard line breaks, each shaped and laid out
+// as a paragraph of its own. Lines never break across a hard line break, so an
+// edit only reshapes and breaks the lines of the blocks it touches, and the
+// blocks below keep their layout and are only moved. The cost of an edit
+// depends on the length of the edited blocks, not of the document.
+//
+// All the text has the same style. Maximum line counts and ellipses are not
+// supported, since they depend on the lines of the whole text.
+class EditableParagraph : public fml::RefCountedThreadSafe<EditableParagraph> {
+  FML_FRIEND_MAKE_REF_COUNTED(EditableParagraph);
+
+ public:
+  static fml::RefPtr<EditableParagraph> Create(
+      const txt::ParagraphStyle& paragraph_style,
+      const txt::TextStyle& text_style,
+      std::shared_ptr<txt::FontCollection> font_collection,
+      const std::u16string& text) {
+    return fml::MakeRefCounted<EditableParagraph>(
+        paragraph_style, text_style, std::move(font_collection), text);
+  }
+
+  ~EditableParagraph();
+
+  // Replaces the |length| code units at |offset| with |text|. Inserting and
+  // deleting are replacements of empty ranges and with empty texts. The
+  // affected blocks are laid out again by the next layout.
+  void replace(unsigned offset, unsigned length, const std::u16string& text);
+
+  size_t textLength();
+
+  float width();
+  float height();
+  float longestLine();
+  float minIntrinsicWidth();
+  float maxIntrinsicWidth();
+
+  // Lays out the blocks edited since the last layout, or all blocks if
+  // |width| changed.
+  void layout(float width);
+
+  // Paints the blocks intersecting the clip of |canvas|.
+  void paint(Canvas* canvas, float x, float y);
+  Float32List getRectsForRange(unsigned start, unsigned end,
+                               unsigned boxHeightStyle, unsigned boxWidthStyle);
+  void getPositionForOffset(float dx, float dy, int* offset);
+  void getLineBoundary(unsigned offset, int* boundaryPtr);
+
+  size_t GetAllocationSize();
+
+ private:
+  EditableParagraph(const txt::ParagraphStyle& paragraph_style,
+                    const txt::TextStyle& text_style,
+                    std::shared_ptr<txt::FontCollection> font_collection,
+                    const std::u16string& text);
+
+  struct Block {
+    // The text of the block, without the line break that ends every block
+    // but the last.
+    std::u16string text;
+    // Null until the block is laid out after being edited.
+    std::unique_ptr<txt::Paragraph> paragraph;
+  };
+
+  txt::ParagraphStyle paragraph_style_;
+  txt::TextStyle text_style_;
+  std::shared_ptr<txt::FontCollection> font_collection_;
+  std::vector<Block> blocks_;
+  float width_ = -1;
+
+  // The text offset and the top of each block. Entries from
+  // |first_invalid_position_| onwards are outdated.
+  std::vector<size_t> block_offsets_;
+  std::vector<float> block_tops_;
+  size_t first_invalid_position_ = 0;
+  float height_ = 0;
+
+  static std::vector<Block> SplitBlocks(const std::u16string& text);
+
+  void UpdatePositions();
+
+  // Returns the block containing the text |offset|. Offsets of line breaks
+  // belong to the block they end.
+  size_t GetBlockForOffset(size_t offset);
+
+  // Returns the block at the vertical position |y|.
+  size_t GetBlockForY(float y);
+
+  std::unique_ptr<txt::Paragraph> BuildBlock(const Block& block) const;
+};
+
+}  // namespace uiwidgets
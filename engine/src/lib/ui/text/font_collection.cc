@@ -1,12 +1,17 @@
 #include "font_collection.h"
 
 #include <mutex>
+#include <optional>
 
+#include "flutter/fml/trace_event.h"
 #include "include/core/SkFontMgr.h"
 #include "include/core/SkGraphics.h"
-#include "include/core/SkStream.h"
+#include "include/core/SkString.h"
 #include "include/core/SkTypeface.h"
 #include "asset_manager_font_provider.h"
+#include "lib/ui/external_data.h"
+#include "lib/ui/text/glyph_cache_prewarmer.h"
+#include "lib/ui/text/paragraph_cache.h"
 #include "lib/ui/ui_mono_state.h"
 #include "lib/ui/window/window.h"
 #include "txt/asset_font_manager.h"
@@ -16,16 +21,55 @@ namespace uiwidgets {
 namespace {
 typedef void (*LoadFontCallback)(Mono_Handle callback_handle);
 
-UIWIDGETS_API(void)
+FontCollection& GetFontCollection() {
+  return UIMonoState::Current()->window()->client()->GetFontCollection();
+}
+
+// Returns an error, without invoking |loadFontCallback|, if the data is not a
+// font.
+UIWIDGETS_API(const char*)
 Font_LoadFontFromList(uint8_t* font_data, int size,
                  LoadFontCallback loadFontCallback, Mono_Handle callbackHandle,
                  char* family_name) {
-  FontCollection& font_collection =
-      UIMonoState::Current()->window()->client()->GetFontCollection();
-  font_collection.LoadFontFromList(font_data, size, family_name);
+  if (!GetFontCollection().LoadFontFromList(font_data, size, family_name)) {
+    return "Could not load the font.";
+  }
   loadFontCallback(callbackHandle);
+  return nullptr;
+}
+
+// Returns an error, without invoking |loadFontCallback|, if the file could not
+// be loaded.
+UIWIDGETS_API(const char*)
+Font_LoadFontFromFile(char* path, LoadFontCallback loadFontCallback,
+                      Mono_Handle callbackHandle, char* family_name) {
+  if (!GetFontCollection().LoadFontFromFile(path, family_name)) {
+    return "Could not load the font file.";
+  }
+  loadFontCallback(callbackHandle);
+  return nullptr;
+}
+
+UIWIDGETS_API(void)
+Font_PrewarmGlyphCache(const uint8_t* entries_json, int size) {
+  WindowClient* client = UIMonoState::Current()->window()->client();
+  auto prewarmer = std::make_shared<GlyphCachePrewarmer>(
+      GlyphCachePrewarmer::ParseEntries(entries_json, size),
+      client->GetFontCollection());
+  std::shared_ptr<fml::ConcurrentMessageLoop> loop =
+      client->GetConcurrentMessageLoop();
+  if (prewarmer->empty() || !loop) {
+    return;
+  }
+  loop->GetTaskRunner()->PostTask([prewarmer]() { prewarmer->Prewarm(); });
 }
 
+UIWIDGETS_API(void) Font_BeginLoadBatch() {
+  GetFontCollection().BeginLoadBatch();
+}
+
+UIWIDGETS_API(void) Font_EndLoadBatch() { GetFontCollection().EndLoadBatch(); }
+
 }  // namespace
 
 FontCollection::FontCollection()
@@ -35,6 +79,9 @@ FontCollection::FontCollection()
 }
 
 FontCollection::~FontCollection() {
+  // Other engines share the cache, only the paragraphs shaped with this
+  // collection go away with it.
+  ParagraphCache::GetInstance().ClearFontCollection(collection_.get());
   collection_.reset();
   SkGraphics::PurgeFontCache();
 }
@@ -45,6 +92,8 @@ std::shared_ptr<txt::FontCollection> FontCollection::GetFontCollection() const {
 
 void FontCollection::SetupDefaultFontManager() {
   collection_->SetupDefaultFontManager();
+  has_default_font_manager_ = true;
+  ResetWorkerFontCollections();
 }
 
 void FontCollection::RegisterFonts(
@@ -100,30 +149,149 @@ void FontCollection::RegisterFonts(
         continue;
       }
 
-      // TODO: Handle weights and styles.
+      // Fonts declaring their weight or style are matched without being
+      // loaded. The others are inspected when their family is first used.
+      std::optional<SkFontStyle> font_style;
+      auto font_weight = family_font.FindMember("weight");
+      auto font_slant = family_font.FindMember("style");
+      const bool has_weight = font_weight != family_font.MemberEnd() &&
+                              font_weight->value.IsInt();
+      const bool has_slant = font_slant != family_font.MemberEnd() &&
+                             font_slant->value.IsString();
+      if (has_weight || has_slant) {
+        int weight = has_weight ? font_weight->value.GetInt()
+                                : SkFontStyle::kNormal_Weight;
+        SkFontStyle::Slant slant = SkFontStyle::kUpright_Slant;
+        if (has_slant &&
+            std::string(font_slant->value.GetString()) == "italic") {
+          slant = SkFontStyle::kItalic_Slant;
+        }
+        font_style = SkFontStyle(weight, SkFontStyle::kNormal_Width, slant);
+      }
+
       font_provider->RegisterAsset(family_name->value.GetString(),
-                                   font_asset->value.GetString());
+                                   font_asset->value.GetString(), font_style);
     }
   }
 
-  collection_->SetAssetFontManager(
-      sk_make_sp<txt::AssetFontManager>(std::move(font_provider)));
+  asset_font_manager_ =
+      sk_make_sp<txt::AssetFontManager>(std::move(font_provider));
+  collection_->SetAssetFontManager(asset_font_manager_);
+  ResetWorkerFontCollections();
+  ParagraphCache::GetInstance().ClearFontCollection(collection_.get());
 }
 
-void FontCollection::LoadFontFromList(const uint8_t* font_data, int length,
+bool FontCollection::LoadFontFromList(const uint8_t* font_data, int length,
                                       std::string family_name) {
-  std::unique_ptr<SkStreamAsset> font_stream =
-      std::make_unique<SkMemoryStream>(font_data, length, true);
-  sk_sp<SkTypeface> typeface =
-      SkTypeface::MakeFromStream(std::move(font_stream));
+  return LoadFontFromData(SkData::MakeWithCopy(font_data, length),
+                          std::move(family_name));
+}
+
+bool FontCollection::LoadFontFromData(sk_sp<SkData> font_data,
+                                      std::string family_name) {
+  sk_sp<SkTypeface> typeface = SkTypeface::MakeFromData(std::move(font_data));
+  if (!typeface) {
+    FML_DLOG(WARNING) << "Could not create a typeface from the font data.";
+    return false;
+  }
   txt::TypefaceFontAssetProvider& font_provider =
       dynamic_font_manager_->font_provider();
   if (family_name.empty()) {
+    SkString typeface_family_name;
+    typeface->getFamilyName(&typeface_family_name);
+    family_name = typeface_family_name.c_str();
     font_provider.RegisterTypeface(typeface);
   } else {
     font_provider.RegisterTypeface(typeface, family_name);
   }
+
+  if (load_batch_depth_ > 0) {
+    loaded_families_.push_back(std::move(family_name));
+  } else {
+    InvalidateFontFamilies({family_name});
+  }
+  return true;
+}
+
+bool FontCollection::LoadFontFromFile(const std::string& path,
+                                      std::string family_name) {
+  sk_sp<SkData> font_data = MakeSkDataFromFile(path);
+  if (!font_data) {
+    FML_DLOG(WARNING) << "Could not map the font file " << path;
+    return false;
+  }
+  return LoadFontFromData(std::move(font_data), std::move(family_name));
+}
+
+void FontCollection::BeginLoadBatch() { load_batch_depth_++; }
+
+void FontCollection::EndLoadBatch() {
+  FML_DCHECK(load_batch_depth_ > 0);
+  if (load_batch_depth_ == 0 || --load_batch_depth_ > 0) {
+    return;
+  }
+  if (!loaded_families_.empty()) {
+    InvalidateFontFamilies(loaded_families_);
+    loaded_families_.clear();
+  }
+}
+
+void FontCollection::InvalidateFontFamilies(
+    const std::vector<std::string>& families) {
+  TRACE_EVENT0("uiwidgets", "FontCollection::InvalidateFontFamilies");
+  // txt caches the font collections resolved for lists of families as a
+  // whole, including the fallbacks chosen for families that were missing.
   collection_->ClearFontFamilyCache();
+  ResetWorkerFontCollections();
+  // Only the paragraphs naming one of the families may have been shaped
+  // with fallback fonts, the fallbacks of other paragraphs come from the
+  // platform fonts and are unchanged.
+  ParagraphCache::GetInstance().ClearFamilies(families);
+}
+
+sk_sp<SkTypeface> FontCollection::MatchTypeface(const std::string& family,
+                                                const SkFontStyle& style) {
+  std::vector<sk_sp<SkFontMgr>> font_managers = {dynamic_font_manager_,
+                                                 asset_font_manager_};
+  if (has_default_font_manager_) {
+    font_managers.push_back(SkFontMgr::RefDefault());
+  }
+  for (const sk_sp<SkFontMgr>& font_manager : font_managers) {
+    if (!font_manager) {
+      continue;
+    }
+    sk_sp<SkTypeface> typeface(
+        font_manager->matchFamilyStyle(family.c_str(), style));
+    if (typeface) {
+      return typeface;
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<txt::FontCollection> FontCollection::GetWorkerFontCollection(
+    size_t index) {
+  std::scoped_lock lock(worker_collections_mutex_);
+  if (worker_collections_.size() <= index) {
+    worker_collections_.resize(index + 1);
+  }
+  auto& collection = worker_collections_[index];
+  if (!collection) {
+    collection = std::make_shared<txt::FontCollection>();
+    if (has_default_font_manager_) {
+      collection->SetupDefaultFontManager();
+    }
+    if (asset_font_manager_) {
+      collection->SetAssetFontManager(asset_font_manager_);
+    }
+    collection->SetDynamicFontManager(dynamic_font_manager_);
+  }
+  return collection;
+}
+
+void FontCollection::ResetWorkerFontCollections() {
+  std::scoped_lock lock(worker_collections_mutex_);
+  worker_collections_.clear();
 }
 
 }  // namespace uiwidgets
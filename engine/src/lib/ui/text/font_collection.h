@@ -1,11 +1,16 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include "assets/asset_manager.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/memory/ref_ptr.h"
+#include "include/core/SkData.h"
+#include "include/core/SkFontStyle.h"
+#include "include/core/SkTypeface.h"
 #include "txt/font_collection.h"
 #include "rapidjson/document.h"
 #include "rapidjson/rapidjson.h"
@@ -25,12 +30,52 @@ class FontCollection {
   void RegisterFonts(std::shared_ptr<AssetManager> asset_manager);
   void RegisterFonts(std::shared_ptr<AssetManager> asset_manager, rapidjson::Value::Array fonts);
 
-  void LoadFontFromList(const uint8_t* font_data, int length,
+  // Registers a copy of the font in |font_data|. Returns false if it is not a
+  // font.
+  bool LoadFontFromList(const uint8_t* font_data, int length,
                         std::string family_name);
 
+  // Registers the font in |font_data| without copying it. The data is kept
+  // alive as long as the typeface is in use. Returns false if it is not a
+  // font.
+  bool LoadFontFromData(sk_sp<SkData> font_data, std::string family_name);
+
+  // Registers the font file at |path|, which is memory mapped. Returns false
+  // if the file could not be mapped or is not a font.
+  bool LoadFontFromFile(const std::string& path, std::string family_name);
+
+  // Fonts loaded between these calls invalidate the font caches once, when
+  // the outermost batch ends, instead of after every font.
+  void BeginLoadBatch();
+  void EndLoadBatch();
+
+  // Returns the typeface of |family| closest to |style|, looked up in the
+  // font managers in the order used by paragraphs.
+  sk_sp<SkTypeface> MatchTypeface(const std::string& family,
+                                  const SkFontStyle& style);
+
+  // Returns the font collection used by the |index|th worker thread of a
+  // concurrent layout. The caches of a txt::FontCollection are not thread
+  // safe, so every worker gets a collection of its own, sharing the font
+  // managers of this collection. Collections are kept between layouts and
+  // recreated when the registered fonts change.
+  std::shared_ptr<txt::FontCollection> GetWorkerFontCollection(size_t index);
+
  private:
   std::shared_ptr<txt::FontCollection> collection_;
   sk_sp<txt::DynamicFontManager> dynamic_font_manager_;
+  sk_sp<SkFontMgr> asset_font_manager_;
+  bool has_default_font_manager_ = false;
+  std::mutex worker_collections_mutex_;
+  std::vector<std::shared_ptr<txt::FontCollection>> worker_collections_;
+  int load_batch_depth_ = 0;
+  // Families of the fonts loaded by the current batch.
+  std::vector<std::string> loaded_families_;
+
+  void ResetWorkerFontCollections();
+
+  // Drops what was resolved for |families| before their fonts were loaded.
+  void InvalidateFontFamilies(const std::vector<std::string>& families);
 
   FML_DISALLOW_COPY_AND_ASSIGN(FontCollection);
 };
@@ -0,0 +1,147 @@
+#include "glyph_cache_prewarmer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "flutter/fml/logging.h"
+#include "flutter/fml/trace_event.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkFont.h"
+#include "include/core/SkFontStyle.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkSurface.h"
+#include "include/core/SkTextBlob.h"
+#include "rapidjson/document.h"
+
+namespace uiwidgets {
+
+namespace {
+
+// Glyphs are drawn in a grid on a scratch surface of this size.
+constexpr int kSurfaceSize = 512;
+
+// The largest Unicode code point.
+constexpr int kMaxCodePoint = 0x10FFFF;
+
+// Matches the font settings of the paragraphs painted by txt, so that the
+// glyphs land in the strikes paragraphs use.
+SkFont MakeFont(sk_sp<SkTypeface> typeface, float size) {
+  SkFont font(std::move(typeface), size);
+  font.setEdging(SkFont::Edging::kAntiAlias);
+  font.setSubpixel(true);
+  font.setHinting(SkFontHinting::kSlight);
+  return font;
+}
+
+}  // namespace
+
+std::vector<GlyphCachePrewarmer::Entry> GlyphCachePrewarmer::ParseEntries(
+    const uint8_t* data, size_t size) {
+  std::vector<Entry> entries;
+
+  rapidjson::Document document;
+  static_assert(sizeof(decltype(document)::Ch) == sizeof(uint8_t), "");
+  document.Parse(reinterpret_cast<const decltype(document)::Ch*>(data), size);
+  if (document.HasParseError() || !document.IsArray()) {
+    FML_DLOG(WARNING) << "Error parsing the glyph cache prewarm list.";
+    return entries;
+  }
+
+  for (const auto& strike : document.GetArray()) {
+    if (!strike.IsObject()) {
+      continue;
+    }
+    auto family = strike.FindMember("family");
+    auto font_size = strike.FindMember("size");
+    auto ranges = strike.FindMember("ranges");
+    if (family == strike.MemberEnd() || !family->value.IsString() ||
+        font_size == strike.MemberEnd() || !font_size->value.IsNumber() ||
+        ranges == strike.MemberEnd() || !ranges->value.IsArray()) {
+      continue;
+    }
+
+    Entry entry;
+    entry.family = family->value.GetString();
+    entry.size = font_size->value.GetFloat();
+    for (const auto& range : ranges->value.GetArray()) {
+      if (!range.IsArray() || range.Size() != 2 || !range[0].IsInt() ||
+          !range[1].IsInt() || range[0].GetInt() > range[1].GetInt()) {
+        continue;
+      }
+      if (range[0].GetInt() < 0 || range[1].GetInt() > kMaxCodePoint) {
+        FML_DLOG(WARNING) << "Ignoring a glyph cache prewarm range outside of "
+                             "the Unicode code points.";
+        continue;
+      }
+      entry.ranges.emplace_back(range[0].GetInt(), range[1].GetInt());
+    }
+    if (entry.size > 0 && !entry.ranges.empty()) {
+      entries.push_back(std::move(entry));
+    }
+  }
+  return entries;
+}
+
+GlyphCachePrewarmer::GlyphCachePrewarmer(const std::vector<Entry>& entries,
+                                         FontCollection& font_collection) {
+  for (const Entry& entry : entries) {
+    sk_sp<SkTypeface> typeface =
+        font_collection.MatchTypeface(entry.family, SkFontStyle());
+    if (!typeface) {
+      FML_DLOG(WARNING) << "Could not find the font family " << entry.family
+                        << " to prewarm the glyph cache with.";
+      continue;
+    }
+    strikes_.push_back({std::move(typeface), entry.size, entry.ranges});
+  }
+}
+
+GlyphCachePrewarmer::~GlyphCachePrewarmer() = default;
+
+void GlyphCachePrewarmer::Prewarm() const {
+  TRACE_EVENT0("uiwidgets", "GlyphCachePrewarmer::Prewarm");
+  sk_sp<SkSurface> surface =
+      SkSurface::MakeRasterN32Premul(kSurfaceSize, kSurfaceSize);
+  if (!surface) {
+    return;
+  }
+  SkCanvas* canvas = surface->getCanvas();
+  SkPaint paint;
+  paint.setAntiAlias(true);
+
+  for (const Strike& strike : strikes_) {
+    SkFont font = MakeFont(strike.typeface, strike.size);
+    // Glyphs are drawn fully inside the surface, so that none of them is
+    // culled before being rasterized.
+    const int cell_size =
+        std::min(static_cast<int>(std::ceil(strike.size * 1.5f)), kSurfaceSize);
+    const int cells_per_row = std::max(kSurfaceSize / cell_size, 1);
+    const int cells_per_page = cells_per_row * cells_per_row;
+
+    std::vector<SkGlyphID> glyphs;
+    for (const auto& range : strike.ranges) {
+      for (SkUnichar unichar = range.first; unichar <= range.second;
+           unichar++) {
+        SkGlyphID glyph = strike.typeface->unicharToGlyph(unichar);
+        if (glyph != 0) {
+          glyphs.push_back(glyph);
+        }
+      }
+    }
+
+    for (size_t page = 0; page < glyphs.size(); page += cells_per_page) {
+      const int count = std::min(glyphs.size() - page,
+                                 static_cast<size_t>(cells_per_page));
+      SkTextBlobBuilder builder;
+      const auto& run = builder.allocRunPos(font, count);
+      for (int i = 0; i < count; i++) {
+        run.glyphs[i] = glyphs[page + i];
+        run.points()[i] = SkPoint::Make((i % cells_per_row) * cell_size,
+                                        (i / cells_per_row + 1) * cell_size);
+      }
+      canvas->drawTextBlob(builder.make(), 0, 0, paint);
+    }
+  }
+}
+
+}  // namespace uiwidgets
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkTypeface.h"
+#include "include/core/SkTypes.h"
+#include "lib/ui/text/font_collection.h"
+
+namespace uiwidgets {
+
+// Rasterizes glyphs into Skia's glyph cache ahead of the frames showing them,
+// so that the first frame displaying a new script does not rasterize all of
+// its glyphs on the raster thread.
+//
+// What to rasterize is described by a JSON list of strikes:
+//
+//   [{"family": "Noto Sans SC", "size": 28, "ranges": [[19968, 20479]]}]
+//
+// Sizes are in physical pixels, and ranges are inclusive code point ranges.
+// Glyphs are only kept as long as the glyph cache budget allows, see
+// SkGraphics::SetFontCacheLimit.
+class GlyphCachePrewarmer {
+ public:
+  struct Entry {
+    std::string family;
+    float size = 0;
+    std::vector<std::pair<SkUnichar, SkUnichar>> ranges;
+  };
+
+  // Parses a list of strikes. Malformed entries are skipped.
+  static std::vector<Entry> ParseEntries(const uint8_t* data, size_t size);
+
+  // Resolves the typefaces of |entries|. Must be called on the thread using
+  // |font_collection|, typically the UI thread.
+  GlyphCachePrewarmer(const std::vector<Entry>& entries,
+                      FontCollection& font_collection);
+
+  ~GlyphCachePrewarmer();
+
+  bool empty() const { return strikes_.empty(); }
+
+  // Rasterizes the glyphs of all strikes. Can be called on any thread.
+  void Prewarm() const;
+
+ private:
+  struct Strike {
+    sk_sp<SkTypeface> typeface;
+    float size;
+    std::vector<std::pair<SkUnichar, SkUnichar>> ranges;
+  };
+
+  std::vector<Strike> strikes_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(GlyphCachePrewarmer);
+};
+
+}  // namespace uiwidgets
@@ -0,0 +1,65 @@
+#include "line_metrics_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace uiwidgets {
+
+LineMetricsIndex::LineMetricsIndex(
+    const std::vector<txt::LineMetrics>& metrics) {
+  const size_t line_count = metrics.size();
+  start_indices_.reserve(line_count);
+  end_indices_.reserve(line_count);
+  line_bottoms_.reserve(line_count);
+  encoded_metrics_.reserve(line_count * kValuesPerLine);
+
+  float bottom = 0;
+  for (const txt::LineMetrics& line : metrics) {
+    start_indices_.push_back(static_cast<uint32_t>(line.start_index));
+    end_indices_.push_back(static_cast<uint32_t>(line.end_index));
+    bottom += line.height;
+    line_bottoms_.push_back(bottom);
+
+    encoded_metrics_.push_back(static_cast<float>(line.hard_break));
+    encoded_metrics_.push_back(line.ascent);
+    encoded_metrics_.push_back(line.descent);
+    encoded_metrics_.push_back(line.unscaled_ascent);
+    // We add then round to get the height. The
+    // definition of height here is different
+    // than the one in LibTxt.
+    encoded_metrics_.push_back(round(line.ascent + line.descent));
+    encoded_metrics_.push_back(line.width);
+    encoded_metrics_.push_back(line.left);
+    encoded_metrics_.push_back(line.baseline);
+    encoded_metrics_.push_back(static_cast<float>(line.line_number));
+  }
+}
+
+LineMetricsIndex::~LineMetricsIndex() = default;
+
+int LineMetricsIndex::GetLineForOffset(size_t offset) const {
+  // Lines are sorted by offset, so the first line ending at or after
+  // |offset| is the only candidate.
+  auto it = std::lower_bound(end_indices_.begin(), end_indices_.end(), offset);
+  if (it == end_indices_.end()) {
+    return -1;
+  }
+  const size_t line = it - end_indices_.begin();
+  if (offset < start_indices_[line]) {
+    return -1;
+  }
+  return static_cast<int>(line);
+}
+
+int LineMetricsIndex::GetLineForY(float y) const {
+  if (line_bottoms_.empty()) {
+    return -1;
+  }
+  auto it = std::upper_bound(line_bottoms_.begin(), line_bottoms_.end(), y);
+  if (it == line_bottoms_.end()) {
+    return static_cast<int>(line_bottoms_.size() - 1);
+  }
+  return static_cast<int>(it - line_bottoms_.begin());
+}
+
+}  // namespace uiwidgets
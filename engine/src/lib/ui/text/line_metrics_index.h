@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "txt/line_metrics.h"
+
+namespace uiwidgets {
+
+// The line metrics of a laid out paragraph, stored as parallel arrays so that
+// the line of a text offset or of a vertical position is found by binary
+// search instead of scanning a copy of txt::LineMetrics for every query.
+class LineMetricsIndex {
+ public:
+  // The number of values encoded for each line by encoded_metrics().
+  static constexpr size_t kValuesPerLine = 9;
+
+  explicit LineMetricsIndex(const std::vector<txt::LineMetrics>& metrics);
+
+  ~LineMetricsIndex();
+
+  size_t line_count() const { return start_indices_.size(); }
+
+  size_t start_index(size_t line) const { return start_indices_[line]; }
+
+  size_t end_index(size_t line) const { return end_indices_[line]; }
+
+  // Returns the first line whose range contains |offset|, or -1.
+  int GetLineForOffset(size_t offset) const;
+
+  // Returns the line at the vertical position |y|, clamped to the first and
+  // last lines, or -1 if there are no lines.
+  int GetLineForY(float y) const;
+
+  // The metrics of every line, kValuesPerLine values each, in the layout
+  // returned to managed code by Paragraph::computeLineMetrics.
+  const std::vector<float>& encoded_metrics() const {
+    return encoded_metrics_;
+  }
+
+ private:
+  std::vector<uint32_t> start_indices_;
+  std::vector<uint32_t> end_indices_;
+  // The bottom of each line, the sum of the heights of the lines above it
+  // and its own.
+  std::vector<float> line_bottoms_;
+  std::vector<float> encoded_metrics_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(LineMetricsIndex);
+};
+
+}  // namespace uiwidgets
@@ -1,8 +1,26 @@
 #include "paragraph.h"
 
+#include <algorithm>
+#include <atomic>
+
+#include "flutter/fml/synchronization/count_down_latch.h"
+#include "flutter/fml/trace_event.h"
+
 namespace uiwidgets {
-Paragraph::Paragraph(std::unique_ptr<txt::Paragraph> paragraph)
-    : m_paragraph(std::move(paragraph)) {}
+
+namespace {
+
+// Paragraphs laid out on a worker are built again for the font collection of
+// that worker, so small batches are cheaper to lay out on the calling thread.
+constexpr size_t kMinParagraphsPerChunk = 8;
+
+}  // namespace
+
+Paragraph::Paragraph(
+    std::unique_ptr<txt::Paragraph> paragraph,
+    std::shared_ptr<const ParagraphCache::Content> cache_content)
+    : m_paragraph(std::move(paragraph)),
+      m_cache_content(std::move(cache_content)) {}
 
 Paragraph::~Paragraph() = default;
 
@@ -37,7 +55,148 @@ float Paragraph::ideographicBaseline() {
 
 bool Paragraph::didExceedMaxLines() { return m_paragraph->DidExceedMaxLines(); }
 
-void Paragraph::layout(float width) { m_paragraph->Layout(width); }
+void Paragraph::layout(float width) {
+  m_line_index.reset();
+  if (!m_cache_content) {
+    m_paragraph->Layout(width);
+    return;
+  }
+
+  if (!LayoutFromCache(width)) {
+    LayoutAndCache(width);
+  }
+}
+
+bool Paragraph::LayoutFromCache(float width) {
+  auto cached = ParagraphCache::GetInstance().Get(*m_cache_content, width);
+  if (!cached) {
+    return false;
+  }
+  m_paragraph = std::move(cached);
+  m_paragraph_shared = true;
+  return true;
+}
+
+void Paragraph::LayoutAndCache(float width) {
+  if (m_paragraph_shared) {
+    // The current instance is laid out at another width and may be used by
+    // other paragraphs.
+    m_paragraph = m_cache_content->Build();
+  }
+  m_paragraph->Layout(width);
+  m_paragraph_shared =
+      ParagraphCache::GetInstance().Put(*m_cache_content, width, m_paragraph);
+}
+
+void Paragraph::LayoutBatch(Paragraph** paragraphs, const float* widths,
+                            int count, FontCollection& font_collection,
+                            fml::ConcurrentMessageLoop* loop) {
+  TRACE_EVENT0("uiwidgets", "Paragraph::LayoutBatch");
+
+  struct Job {
+    Paragraph* paragraph;
+    float width;
+    // Set by a worker, which lays out a paragraph built for its own font
+    // collection. Null for the jobs laid out on the calling thread.
+    std::shared_ptr<txt::Paragraph> result;
+  };
+  std::vector<Job> jobs;
+  for (int i = 0; i < count; i++) {
+    Paragraph* paragraph = paragraphs[i];
+    paragraph->m_line_index.reset();
+    if (!paragraph->m_cache_content) {
+      // Without its content, the paragraph can not be built for the font
+      // collection of a worker.
+      paragraph->layout(widths[i]);
+    } else if (!paragraph->LayoutFromCache(widths[i])) {
+      jobs.push_back({paragraph, widths[i], nullptr});
+    }
+  }
+
+  size_t chunk_count = 1;
+  if (loop) {
+    chunk_count = jobs.size() / kMinParagraphsPerChunk;
+  }
+  if (chunk_count <= 1) {
+    for (Job& job : jobs) {
+      job.paragraph->LayoutAndCache(job.width);
+    }
+    return;
+  }
+
+  // The chunks are claimed one at a time by the calling thread and by the
+  // tasks posted to the workers. The calling thread keeps claiming until none
+  // are left, then only waits for the chunks that workers are laying out, so
+  // a pool busy with other work does not stall it. Tasks that start late find
+  // nothing left and return, which is why the batch is shared with them.
+  struct Batch {
+    Batch(std::vector<Job> jobs, size_t chunk_count)
+        : jobs(std::move(jobs)), chunk_count(chunk_count), done(chunk_count) {}
+
+    // Returns false once all chunks were claimed.
+    bool Claim(size_t* begin, size_t* end) {
+      const size_t chunk = next_chunk.fetch_add(1);
+      if (chunk >= chunk_count) {
+        return false;
+      }
+      *begin = jobs.size() * chunk / chunk_count;
+      *end = jobs.size() * (chunk + 1) / chunk_count;
+      return true;
+    }
+
+    std::vector<Job> jobs;
+    const size_t chunk_count;
+    std::atomic<size_t> next_chunk{0};
+    fml::CountDownLatch done;
+  };
+  auto batch = std::make_shared<Batch>(std::move(jobs), chunk_count);
+
+  // The paragraphs laid out on a worker are built again with the font
+  // collection of that worker, one per posted task.
+  const size_t task_count =
+      std::min(loop->GetWorkerCount(), chunk_count - 1);
+  for (size_t task = 0; task < task_count; task++) {
+    loop->GetTaskRunner()->PostTask(
+        [batch, worker_font_collection =
+                    font_collection.GetWorkerFontCollection(task)]() {
+          size_t begin, end;
+          while (batch->Claim(&begin, &end)) {
+            TRACE_EVENT0("uiwidgets", "Paragraph::LayoutBatchChunk");
+            for (size_t i = begin; i < end; i++) {
+              Job& job = batch->jobs[i];
+              job.result = job.paragraph->m_cache_content->Build(
+                  worker_font_collection);
+              job.result->Layout(job.width);
+            }
+            batch->done.CountDown();
+          }
+        });
+  }
+
+  // The calling thread lays out its chunks with the font collection the
+  // paragraphs were built with.
+  size_t begin, end;
+  while (batch->Claim(&begin, &end)) {
+    for (size_t i = begin; i < end; i++) {
+      batch->jobs[i].paragraph->LayoutAndCache(batch->jobs[i].width);
+    }
+    batch->done.CountDown();
+  }
+  batch->done.Wait();
+
+  ParagraphCache& cache = ParagraphCache::GetInstance();
+  for (Job& job : batch->jobs) {
+    if (!job.result) {
+      continue;
+    }
+    Paragraph* paragraph = job.paragraph;
+    paragraph->m_paragraph = std::move(job.result);
+    cache.Put(*paragraph->m_cache_content, job.width, paragraph->m_paragraph);
+    // The worker font collection is used again by the next batch, so the
+    // paragraph is never laid out again on the calling thread.
+    paragraph->m_paragraph_shared = true;
+  }
+}
 
 void Paragraph::paint(Canvas* canvas, float x, float y) {
   SkCanvas* sk_canvas = canvas->canvas();
@@ -98,6 +257,31 @@ Float32List Paragraph::getRectsForPlaceholders() {
   return EncodeTextBoxes(boxes);
 }
 
+static int EncodeTextBoxes(const std::vector<txt::Paragraph::TextBox>& boxes,
+                           float* buffer, int capacity) {
+  int size = boxes.size() * 5;
+  if (size <= capacity) {
+    EncodeTextBoxes(boxes, buffer);
+  }
+  return size;
+}
+
+int Paragraph::getRectsForRange(unsigned start, unsigned end,
+                                unsigned boxHeightStyle,
+                                unsigned boxWidthStyle, float* buffer,
+                                int capacity) {
+  std::vector<txt::Paragraph::TextBox> boxes = m_paragraph->GetRectsForRange(
+      start, end, static_cast<txt::Paragraph::RectHeightStyle>(boxHeightStyle),
+      static_cast<txt::Paragraph::RectWidthStyle>(boxWidthStyle));
+  return EncodeTextBoxes(boxes, buffer, capacity);
+}
+
+int Paragraph::getRectsForPlaceholders(float* buffer, int capacity) {
+  std::vector<txt::Paragraph::TextBox> boxes =
+      m_paragraph->GetRectsForPlaceholders();
+  return EncodeTextBoxes(boxes, buffer, capacity);
+}
+
 void Paragraph::getPositionForOffset(float dx, float dy, int* offset) {
   txt::Paragraph::PositionWithAffinity pos =
       m_paragraph->GetGlyphPositionAtCoordinate(dx, dy);
@@ -111,48 +295,58 @@ void Paragraph::getWordBoundary(unsigned offset, int* boundaryPtr) {
   boundaryPtr[1] = point.end;
 }
 
+const LineMetricsIndex& Paragraph::GetLineIndex() {
+  if (!m_line_index) {
+    m_line_index =
+        std::make_unique<LineMetricsIndex>(m_paragraph->GetLineMetrics());
+  }
+  return *m_line_index;
+}
+
 void Paragraph::getLineBoundary(unsigned offset, int* boundaryPtr) {
-  std::vector<txt::LineMetrics> metrics = m_paragraph->GetLineMetrics();
-  int line_start = -1;
-  int line_end = -1;
-  for (txt::LineMetrics& line : metrics) {
-    if (offset >= line.start_index && offset <= line.end_index) {
-      line_start = line.start_index;
-      line_end = line.end_index;
-      break;
-    }
+  const LineMetricsIndex& index = GetLineIndex();
+  int line = index.GetLineForOffset(offset);
+  if (line < 0) {
+    boundaryPtr[0] = -1;
+    boundaryPtr[1] = -1;
+    return;
   }
-  boundaryPtr[0] = line_start;
-  boundaryPtr[1] = line_end;
+  boundaryPtr[0] = index.start_index(line);
+  boundaryPtr[1] = index.end_index(line);
 }
 
-Float32List Paragraph::computeLineMetrics() {
-  std::vector<txt::LineMetrics> metrics = m_paragraph->GetLineMetrics();
+int Paragraph::getLineForOffset(unsigned offset) {
+  return GetLineIndex().GetLineForOffset(offset);
+}
+
+int Paragraph::getLineForY(float y) { return GetLineIndex().GetLineForY(y); }
 
+Float32List Paragraph::computeLineMetrics() {
   // Layout:
-  // boxes.size() groups of 9 which are the line metrics
+  // line count groups of 9 which are the line metrics
   // properties
-  int size = metrics.size() * 9;
+  const std::vector<float>& metrics = GetLineIndex().encoded_metrics();
+  int size = metrics.size();
   Float32List result = {(float*)malloc(sizeof(float) * size), size};
-  unsigned long position = 0;
-  for (unsigned long i = 0; i < metrics.size(); i++) {
-    const txt::LineMetrics& line = metrics[i];
-    result.data[position++] = static_cast<float>(line.hard_break);
-    result.data[position++] = line.ascent;
-    result.data[position++] = line.descent;
-    result.data[position++] = line.unscaled_ascent;
-    // We add then round to get the height. The
-    // definition of height here is different
-    // than the one in LibTxt.
-    result.data[position++] = round(line.ascent + line.descent);
-    result.data[position++] = line.width;
-    result.data[position++] = line.left;
-    result.data[position++] = line.baseline;
-    result.data[position++] = static_cast<float>(line.line_number);
-  }
+  std::copy(metrics.begin(), metrics.end(), result.data);
   return result;
 }
 
+int Paragraph::computeLineMetrics(float* buffer, int capacity) {
+  const std::vector<float>& metrics = GetLineIndex().encoded_metrics();
+  int size = metrics.size();
+  if (size <= capacity) {
+    std::copy(metrics.begin(), metrics.end(), buffer);
+  }
+  return size;
+}
+
+const float* Paragraph::getLineMetricsView(int* size) {
+  const std::vector<float>& metrics = GetLineIndex().encoded_metrics();
+  *size = metrics.size();
+  return metrics.data();
+}
+
 UIWIDGETS_API(float) Paragraph_width(Paragraph* ptr) { return ptr->width(); }
 
 UIWIDGETS_API(float) Paragraph_height(Paragraph* ptr) { return ptr->height(); }
@@ -185,6 +379,13 @@ UIWIDGETS_API(void) Paragraph_layout(Paragraph* ptr, float width) {
   ptr->layout(width);
 }
 
+UIWIDGETS_API(void)
+Paragraph_layoutBatch(Paragraph** items, float* widths, int count) {
+  WindowClient* client = UIMonoState::Current()->window()->client();
+  Paragraph::LayoutBatch(items, widths, count, client->GetFontCollection(),
+                         client->GetConcurrentMessageLoop().get());
+}
+
 UIWIDGETS_API(Float32List)
 Paragraph_getRectsForRange(Paragraph* ptr, int start, int end,
                            int boxHeightStyle, int boxWidthStyle) {
@@ -196,6 +397,20 @@ Paragraph_getRectsForPlaceholders(Paragraph* ptr) {
   return ptr->getRectsForPlaceholders();
 }
 
+UIWIDGETS_API(int)
+Paragraph_getRectsForRangeIntoBuffer(Paragraph* ptr, int start, int end,
+                                     int boxHeightStyle, int boxWidthStyle,
+                                     float* buffer, int capacity) {
+  return ptr->getRectsForRange(start, end, boxHeightStyle, boxWidthStyle,
+                               buffer, capacity);
+}
+
+UIWIDGETS_API(int)
+Paragraph_getRectsForPlaceholdersIntoBuffer(Paragraph* ptr, float* buffer,
+                                            int capacity) {
+  return ptr->getRectsForPlaceholders(buffer, capacity);
+}
+
 UIWIDGETS_API(void)
 Paragraph_getPositionForOffset(Paragraph* ptr, float dx, float dy,
                                int* offset) {
@@ -212,6 +427,14 @@ Paragraph_getLineBoundary(Paragraph* ptr, int offset, int* boundaryPtr) {
   ptr->getLineBoundary(offset, boundaryPtr);
 }
 
+UIWIDGETS_API(int) Paragraph_getLineForOffset(Paragraph* ptr, int offset) {
+  return ptr->getLineForOffset(offset);
+}
+
+UIWIDGETS_API(int) Paragraph_getLineForY(Paragraph* ptr, float y) {
+  return ptr->getLineForY(y);
+}
+
 UIWIDGETS_API(void)
 Paragraph_paint(Paragraph* ptr, Canvas* canvas, float x, float y) {
   ptr->paint(canvas, x, y);
@@ -222,5 +445,16 @@ Paragraph_computeLineMetrics(Paragraph* ptr, float* data) {
   return ptr->computeLineMetrics();
 }
 
+UIWIDGETS_API(int)
+Paragraph_computeLineMetricsIntoBuffer(Paragraph* ptr, float* buffer,
+                                       int capacity) {
+  return ptr->computeLineMetrics(buffer, capacity);
+}
+
+UIWIDGETS_API(const float*)
+Paragraph_getLineMetricsView(Paragraph* ptr, int* size) {
+  return ptr->getLineMetricsView(size);
+}
+
 UIWIDGETS_API(void) Paragraph_dispose(Paragraph* ptr) { ptr->Release(); }
 }  // namespace uiwidgets
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/memory/ref_counted.h"
 #include "txt/paragraph.h"
 #include "shell/common/lists.h"
 #include "lib/ui/painting/canvas.h"
+#include "lib/ui/text/font_collection.h"
+#include "lib/ui/text/line_metrics_index.h"
+#include "lib/ui/text/paragraph_cache.h"
 #include "lib/ui/ui_mono_state.h"
 
 namespace uiwidgets {
@@ -16,7 +20,16 @@ class Paragraph : public fml::RefCountedThreadSafe<Paragraph> {
 
   static fml::RefPtr<Paragraph> Create(
       std::unique_ptr<txt::Paragraph> txt_paragraph) {
-    return fml::MakeRefCounted<Paragraph>(std::move(txt_paragraph));
+    return fml::MakeRefCounted<Paragraph>(std::move(txt_paragraph), nullptr);
+  }
+
+  // Creates a paragraph whose layouts are shared through the ParagraphCache
+  // with other paragraphs built from the same |content|.
+  static fml::RefPtr<Paragraph> Create(
+      std::unique_ptr<txt::Paragraph> txt_paragraph,
+      std::shared_ptr<const ParagraphCache::Content> content) {
+    return fml::MakeRefCounted<Paragraph>(std::move(txt_paragraph),
+                                          std::move(content));
   }
 
   ~Paragraph();
@@ -31,20 +44,57 @@ class Paragraph : public fml::RefCountedThreadSafe<Paragraph> {
   bool didExceedMaxLines();
 
   void layout(float width);
+
+  // Lays out |paragraphs[i]| at |widths[i]| for each of the |count| distinct
+  // paragraphs, spreading the paragraphs that miss the ParagraphCache over the
+  // workers of |loop|. Blocks until all of them are laid out.
+  static void LayoutBatch(Paragraph** paragraphs, const float* widths,
+                          int count, FontCollection& font_collection,
+                          fml::ConcurrentMessageLoop* loop);
   void paint(Canvas* canvas, float x, float y);
   Float32List getRectsForRange(unsigned start, unsigned end,
                         unsigned boxHeightStyle, unsigned boxWidthStyle);
   Float32List getRectsForPlaceholders();
+  // These overloads write into |buffer|, which can hold |capacity| values,
+  // instead of allocating the result. They return the number of values of
+  // the result, and leave |buffer| untouched if it is too small for them.
+  int getRectsForRange(unsigned start, unsigned end, unsigned boxHeightStyle,
+                       unsigned boxWidthStyle, float* buffer, int capacity);
+  int getRectsForPlaceholders(float* buffer, int capacity);
   void getPositionForOffset(float dx, float dy, int* offset);
   void getWordBoundary(unsigned offset, int* boundaryPtr);
   void getLineBoundary(unsigned offset, int* boundaryPtr);
+  int getLineForOffset(unsigned offset);
+  int getLineForY(float y);
   Float32List computeLineMetrics();
+  int computeLineMetrics(float* buffer, int capacity);
+  // Returns the metrics encoded as by computeLineMetrics without copying
+  // them. The values stay valid until the paragraph is laid out again.
+  const float* getLineMetricsView(int* size);
 
   size_t GetAllocationSize();
-  std::unique_ptr<txt::Paragraph> m_paragraph;
+  std::shared_ptr<txt::Paragraph> m_paragraph;
 
  private:
-  explicit Paragraph(std::unique_ptr<txt::Paragraph> paragraph);
+  Paragraph(std::unique_ptr<txt::Paragraph> paragraph,
+            std::shared_ptr<const ParagraphCache::Content> cache_content);
+
+  // Null when the paragraph can not be cached.
+  std::shared_ptr<const ParagraphCache::Content> m_cache_content;
+  // Whether |m_paragraph| must not be laid out again, because it is held by
+  // the ParagraphCache or was built for the font collection of a worker.
+  bool m_paragraph_shared = false;
+  // Built on the first line query after a layout.
+  std::unique_ptr<LineMetricsIndex> m_line_index;
+
+  const LineMetricsIndex& GetLineIndex();
+
+  // Shares the cached layout at |width|, if there is one.
+  bool LayoutFromCache(float width);
+
+  // Lays out at |width|, building a fresh paragraph if the current one must
+  // not be laid out again, and caches the result.
+  void LayoutAndCache(float width);
 };
 
 }  // namespace uiwidgets
@@ -1,5 +1,6 @@
 #include "paragraph_builder.h"
 
+#include "lib/ui/painting/paint_cache.h"
 #include "lib/ui/ui_mono_state.h"
 #include "unicode/ustring.h"
 
@@ -102,6 +103,36 @@ const int sHeightMask = 1 << sHeightIndex;
 const int sLeadingMask = 1 << sLeadingIndex;
 const int sForceStrutHeightMask = 1 << sForceStrutHeightIndex;
 
+// Paint decoding
+constexpr size_t kPaintDataByteCount = PaintCache::kPaintDataByteCount;
+
+void AppendStringsToKey(ParagraphCache::Content& content,
+                        const std::vector<std::string>& strings) {
+  content.AppendKey(strings.size());
+  for (const auto& string : strings) {
+    content.AppendKeyString(string);
+  }
+}
+
+// Appends the encoded |paint_data| to the key of |content|. The objects the
+// decoded |paint| references are identified by their address, which stays
+// valid as long as a paragraph holding the paint is cached. Shaders and image
+// filters may hold GPU backed images that must not be kept alive by the
+// cache, so paragraphs using them are not cached.
+void AppendPaintToKey(ParagraphCache::Content& content,
+                      const uint8_t* paint_data, const SkPaint* paint) {
+  content.AppendKey(paint != nullptr);
+  if (paint == nullptr) {
+    return;
+  }
+  if (paint->getShader() || paint->getImageFilter()) {
+    content.MarkUncacheable();
+    return;
+  }
+  content.AppendKeyData(paint_data, kPaintDataByteCount);
+  content.AppendKey(paint->getColorFilter());
+}
+
 }  // namespace
 
 fml::RefPtr<ParagraphBuilder> ParagraphBuilder::create(
@@ -257,6 +288,18 @@ ParagraphBuilder::ParagraphBuilder(
 
   m_paragraphBuilder = txt::ParagraphBuilder::CreateTxtBuilder(
       style, font_collection.GetFontCollection());
+
+  m_cacheContent = std::make_shared<ParagraphCache::Content>(
+      style, font_collection.GetFontCollection());
+  ParagraphCache::Content& content = *m_cacheContent;
+  content.AppendKeyData(encoded, sizeof(int) * (psTextHeightBehaviorIndex + 1));
+  content.AppendKeyData(strutData, strutData ? strutData_size : 0);
+  content.AppendKeyString(fontFamily);
+  AppendStringsToKey(content, strutFontFamilies);
+  content.AppendKey(fontSize);
+  content.AppendKey(height);
+  content.AppendKeyData(ellipsis.data(), ellipsis.size() * sizeof(char16_t));
+  content.AppendKeyString(locale);
 }
 
 ParagraphBuilder::~ParagraphBuilder() = default;
@@ -385,9 +428,33 @@ void ParagraphBuilder::pushStyle(
   }
 
   m_paragraphBuilder->PushStyle(style);
+
+  ParagraphCache::Content& content = *m_cacheContent;
+  content.PushStyle(style);
+  content.AppendKeyData(encoded, sizeof(int) * encodedSize);
+  content.AppendKey(fontFamiliesSize);
+  for (int i = 0; i < fontFamiliesSize; i++) {
+    content.AppendKeyString(fontFamilies[i]);
+  }
+  content.AppendKey(fontSize);
+  content.AppendKey(letterSpacing);
+  content.AppendKey(wordSpacing);
+  content.AppendKey(height);
+  content.AppendKey(decorationThickness);
+  content.AppendKeyString(locale);
+  AppendPaintToKey(content, background_data,
+                   style.has_background ? &style.background : nullptr);
+  AppendPaintToKey(content, foreground_data,
+                   style.has_foreground ? &style.foreground : nullptr);
+  content.AppendKeyData(shadows_data, shadows_data ? shadow_data_size : 0);
+  content.AppendKeyData(font_features_data,
+                        font_features_data ? font_feature_data_size : 0);
 }
 
-void ParagraphBuilder::pop() { m_paragraphBuilder->Pop(); }
+void ParagraphBuilder::pop() {
+  m_paragraphBuilder->Pop();
+  m_cacheContent->Pop();
+}
 
 const char* ParagraphBuilder::addText(const std::u16string& text) {
   if (text.empty()) return nullptr;
@@ -402,13 +469,35 @@ const char* ParagraphBuilder::addText(const std::u16string& text) {
     return "string is not well-formed UTF-16";
 
   m_paragraphBuilder->AddText(text);
+  m_cacheContent->AddText(text);
 
   return nullptr;
 }
 
 fml::RefPtr<Paragraph> ParagraphBuilder::build(
     /*Dart_Handle paragraph_handle*/) {
-  return Paragraph::Create(/*paragraph_handle,*/ m_paragraphBuilder->Build());
+  if (!m_cacheContent) {
+    Mono_ThrowException("ParagraphBuilder.build called after being built.");
+    return nullptr;
+  }
+  if (!m_cacheContent->cacheable()) {
+    ParagraphCache::GetInstance().RecordBypass();
+    return Paragraph::Create(m_paragraphBuilder->Build());
+  }
+  return Paragraph::Create(/*paragraph_handle,*/ m_paragraphBuilder->Build(),
+                           std::move(m_cacheContent));
+}
+
+fml::RefPtr<EditableParagraph> ParagraphBuilder::buildEditable() {
+  // build hands the content over to the paragraph.
+  if (!m_cacheContent) {
+    Mono_ThrowException(
+        "ParagraphBuilder.buildEditable called after being built.");
+    return nullptr;
+  }
+  return EditableParagraph::Create(
+      m_cacheContent->paragraph_style(), m_paragraphBuilder->PeekStyle(),
+      m_cacheContent->font_collection(), m_cacheContent->GetText());
 }
 
 const char* ParagraphBuilder::addPlaceholder(float width, float height,
@@ -420,6 +509,7 @@ const char* ParagraphBuilder::addPlaceholder(float width, float height,
       static_cast<txt::TextBaseline>(baseline), baseline_offset);
 
   m_paragraphBuilder->AddPlaceholder(placeholder_run);
+  m_cacheContent->AddPlaceholder(placeholder_run);
 
   return nullptr;
 }
@@ -482,6 +572,19 @@ ParagraphBuilder_addPlaceholder(ParagraphBuilder* ptr, float width,
 UIWIDGETS_API(Paragraph*)
 ParagraphBuilder_build(ParagraphBuilder* ptr) {
   auto paragraph = ptr->build();
+  if (!paragraph) {
+    return nullptr;
+  }
+  paragraph->AddRef();
+  return paragraph.get();
+}
+
+UIWIDGETS_API(EditableParagraph*)
+ParagraphBuilder_buildEditable(ParagraphBuilder* ptr) {
+  auto paragraph = ptr->buildEditable();
+  if (!paragraph) {
+    return nullptr;
+  }
   paragraph->AddRef();
   return paragraph.get();
 }
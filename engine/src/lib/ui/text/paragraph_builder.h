@@ -3,8 +3,10 @@
 #include "flutter/fml/memory/ref_counted.h"
 #include "txt/paragraph.h"
 #include "txt/paragraph_builder.h"
+#include "editable_paragraph.h"
 #include "font_collection.h"
 #include "paragraph.h"
+#include "paragraph_cache.h"
 #include "lib/ui/painting/canvas.h"
 
 namespace uiwidgets {
@@ -32,6 +34,11 @@ class ParagraphBuilder : public fml::RefCountedThreadSafe<ParagraphBuilder> {
   const char* addPlaceholder(float width, float height, unsigned alignment,
                              float baseline_offset, unsigned baseline);
   fml::RefPtr<Paragraph> build(/*Dart_Handle paragraph_handle*/);
+  // Builds an editable paragraph with the paragraph style, the text style on
+  // top of the style stack and the text added so far. Called instead of
+  // build. Throws a managed exception and returns null if the builder was
+  // already built.
+  fml::RefPtr<EditableParagraph> buildEditable();
   ~ParagraphBuilder();
 
   void pop();
@@ -45,5 +52,7 @@ class ParagraphBuilder : public fml::RefCountedThreadSafe<ParagraphBuilder> {
                             const std::string& locale);
 
   std::unique_ptr<txt::ParagraphBuilder> m_paragraphBuilder;
+  // Records the content for the ParagraphCache.
+  std::shared_ptr<ParagraphCache::Content> m_cacheContent;
 };
 }  // namespace uiwidgets
\ No newline at end of file
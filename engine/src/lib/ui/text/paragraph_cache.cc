@@ -0,0 +1,293 @@
+#include "paragraph_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <unordered_set>
+
+#include "flutter/fml/trace_event.h"
+#include "txt/paragraph_builder.h"
+
+namespace uiwidgets {
+
+namespace {
+
+// Estimated memory held by a laid out paragraph: a fixed part (see
+// Paragraph::GetAllocationSize) and the glyph positions, runs and text blobs
+// recorded for each UTF-16 code unit.
+constexpr size_t kParagraphBaseBytes = 2000;
+constexpr size_t kBytesPerCodeUnit = 64;
+
+// The two key digests are seeded and mixed differently, so that contents
+// colliding in one of them are told apart by the other.
+constexpr uint64_t kKeySeeds[2] = {0xCBF29CE484222325ull,
+                                   0x84222325CBF29CE4ull};
+constexpr uint64_t kKeyMultipliers[2] = {0x9E3779B97F4A7C15ull,
+                                         0xC2B2AE3D27D4EB4Full};
+
+// Family names are matched case insensitively, as by the font managers.
+std::string CanonicalFamilyName(std::string family) {
+  std::transform(family.begin(), family.end(), family.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return family;
+}
+
+}  // namespace
+
+ParagraphCache::Content::Content(
+    const txt::ParagraphStyle& style,
+    std::shared_ptr<txt::FontCollection> font_collection)
+    : paragraph_style_(style),
+      font_collection_(std::move(font_collection)),
+      key_digests_{kKeySeeds[0], kKeySeeds[1]} {
+  // Paragraphs shape with the fonts of their collection, which stays alive as
+  // long as a paragraph built from it is cached.
+  AppendKey(font_collection_.get());
+  AddFontFamily(style.font_family);
+  for (const std::string& family : style.strut_font_families) {
+    AddFontFamily(family);
+  }
+}
+
+ParagraphCache::Content::~Content() = default;
+
+std::string ParagraphCache::Content::key() const {
+  return std::string(reinterpret_cast<const char*>(key_digests_),
+                     sizeof(key_digests_));
+}
+
+void ParagraphCache::Content::AppendKeyBytes(const void* data, size_t size) {
+  // Sizes are either fixed by the preceding operation or appended before the
+  // data, so padding the last word with zeros is unambiguous.
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  size_t offset = 0;
+  for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + offset, sizeof(word));
+    MixKeyWord(word);
+  }
+  if (offset < size) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + offset, size - offset);
+    MixKeyWord(word);
+  }
+}
+
+void ParagraphCache::Content::MixKeyWord(uint64_t word) {
+  key_digests_[0] ^= word;
+  key_digests_[0] *= kKeyMultipliers[0];
+  key_digests_[0] ^= key_digests_[0] >> 32;
+
+  key_digests_[1] += word;
+  key_digests_[1] = (key_digests_[1] << 23) | (key_digests_[1] >> 41);
+  key_digests_[1] *= kKeyMultipliers[1];
+}
+
+void ParagraphCache::Content::AppendKeyData(const void* data, size_t size) {
+  AppendKey(size);
+  if (size > 0) {
+    AppendKeyBytes(data, size);
+  }
+}
+
+void ParagraphCache::Content::PushStyle(const txt::TextStyle& style) {
+  AppendKey(OpType::kPushStyle);
+  ops_.push_back({OpType::kPushStyle, styles_.size()});
+  styles_.push_back(style);
+  for (const std::string& family : style.font_families) {
+    AddFontFamily(family);
+  }
+}
+
+void ParagraphCache::Content::AddFontFamily(const std::string& family) {
+  if (family.empty()) {
+    return;
+  }
+  std::string canonical_family = CanonicalFamilyName(family);
+  if (std::find(font_families_.begin(), font_families_.end(),
+                canonical_family) == font_families_.end()) {
+    font_families_.push_back(std::move(canonical_family));
+  }
+}
+
+void ParagraphCache::Content::Pop() {
+  AppendKey(OpType::kPop);
+  ops_.push_back({OpType::kPop, 0});
+}
+
+void ParagraphCache::Content::AddText(const std::u16string& text) {
+  AppendKey(OpType::kAddText);
+  AppendKeyData(text.data(), text.size() * sizeof(char16_t));
+  ops_.push_back({OpType::kAddText, texts_.size()});
+  texts_.push_back(text);
+  text_size_ += text.size();
+}
+
+void ParagraphCache::Content::AddPlaceholder(
+    const txt::PlaceholderRun& placeholder) {
+  AppendKey(OpType::kAddPlaceholder);
+  AppendKey(placeholder.width);
+  AppendKey(placeholder.height);
+  AppendKey(placeholder.alignment);
+  AppendKey(placeholder.baseline);
+  AppendKey(placeholder.baseline_offset);
+  ops_.push_back({OpType::kAddPlaceholder, placeholders_.size()});
+  placeholders_.push_back(placeholder);
+}
+
+std::u16string ParagraphCache::Content::GetText() const {
+  std::u16string text;
+  text.reserve(text_size_);
+  for (const std::u16string& part : texts_) {
+    text += part;
+  }
+  return text;
+}
+
+std::unique_ptr<txt::Paragraph> ParagraphCache::Content::Build(
+    const std::shared_ptr<txt::FontCollection>& font_collection) const {
+  TRACE_EVENT0("uiwidgets", "ParagraphCache::Content::Build");
+  auto builder = txt::ParagraphBuilder::CreateTxtBuilder(paragraph_style_,
+                                                         font_collection);
+  for (const Op& op : ops_) {
+    switch (op.type) {
+      case OpType::kPushStyle:
+        builder->PushStyle(styles_[op.index]);
+        break;
+      case OpType::kPop:
+        builder->Pop();
+        break;
+      case OpType::kAddText:
+        builder->AddText(texts_[op.index]);
+        break;
+      case OpType::kAddPlaceholder: {
+        txt::PlaceholderRun placeholder = placeholders_[op.index];
+        builder->AddPlaceholder(placeholder);
+        break;
+      }
+    }
+  }
+  return builder->Build();
+}
+
+ParagraphCache& ParagraphCache::GetInstance() {
+  static ParagraphCache* instance = new ParagraphCache();
+  return *instance;
+}
+
+ParagraphCache::ParagraphCache() = default;
+
+std::string ParagraphCache::MakeKey(const Content& content, float width) {
+  std::string key = content.key();
+  key.append(reinterpret_cast<const char*>(&width), sizeof(width));
+  return key;
+}
+
+std::shared_ptr<txt::Paragraph> ParagraphCache::Get(const Content& content,
+                                                    float width) {
+  std::string key = MakeKey(content, width);
+
+  std::scoped_lock lock(mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    miss_count_++;
+    return nullptr;
+  }
+  hit_count_++;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->second.paragraph;
+}
+
+bool ParagraphCache::Put(const Content& content, float width,
+                         std::shared_ptr<txt::Paragraph> paragraph) {
+  std::string key = MakeKey(content, width);
+  const size_t bytes = key.size() + kParagraphBaseBytes +
+                       content.text_size() * kBytesPerCodeUnit;
+  if (bytes > kMaxBytes) {
+    return false;
+  }
+
+  std::scoped_lock lock(mutex_);
+  if (index_.find(key) != index_.end()) {
+    return false;
+  }
+  while (bytes_ + bytes > kMaxBytes && !lru_.empty()) {
+    EraseLocked(std::prev(lru_.end()));
+  }
+  lru_.emplace_front(
+      std::move(key),
+      Entry{std::move(paragraph), content.font_collection().get(),
+            content.font_families(), bytes});
+  index_[lru_.front().first] = lru_.begin();
+  bytes_ += bytes;
+  return true;
+}
+
+void ParagraphCache::RecordBypass() {
+  std::scoped_lock lock(mutex_);
+  bypass_count_++;
+}
+
+void ParagraphCache::Clear() {
+  std::scoped_lock lock(mutex_);
+  index_.clear();
+  lru_.clear();
+  bytes_ = 0;
+}
+
+void ParagraphCache::ClearFontCollection(
+    const txt::FontCollection* font_collection) {
+  std::scoped_lock lock(mutex_);
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    auto next = std::next(it);
+    if (it->second.font_collection == font_collection) {
+      EraseLocked(it);
+    }
+    it = next;
+  }
+}
+
+void ParagraphCache::ClearFamilies(const std::vector<std::string>& families) {
+  std::unordered_set<std::string> canonical_families;
+  for (const std::string& family : families) {
+    canonical_families.insert(CanonicalFamilyName(family));
+  }
+
+  std::scoped_lock lock(mutex_);
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    auto next = std::next(it);
+    const std::vector<std::string>& entry_families = it->second.font_families;
+    if (std::any_of(entry_families.begin(), entry_families.end(),
+                    [&](const std::string& family) {
+                      return canonical_families.count(family) > 0;
+                    })) {
+      EraseLocked(it);
+    }
+    it = next;
+  }
+}
+
+void ParagraphCache::EraseLocked(LRUList::iterator it) {
+  bytes_ -= it->second.bytes;
+  index_.erase(it->first);
+  lru_.erase(it);
+}
+
+void ParagraphCache::TraceStatsToTimeline() {
+  std::scoped_lock lock(mutex_);
+#if !UIWidgets_RELEASE
+  FML_TRACE_COUNTER("uiwidgets", "ParagraphCache",
+                    reinterpret_cast<int64_t>(this),  //
+                    "Hits", hit_count_,               //
+                    "Misses", miss_count_,            //
+                    "Bypassed", bypass_count_,        //
+                    "Entries", lru_.size(),           //
+                    "MBytes", bytes_ * 1e-6           //
+  );
+#endif  // !UIWidgets_RELEASE
+  hit_count_ = 0;
+  miss_count_ = 0;
+  bypass_count_ = 0;
+}
+
+}  // namespace uiwidgets
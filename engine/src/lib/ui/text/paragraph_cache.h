@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "txt/font_collection.h"
+#include "txt/paragraph.h"
+#include "txt/paragraph_style.h"
+#include "txt/placeholder_run.h"
+#include "txt/text_style.h"
+
+namespace uiwidgets {
+
+// Shares laid out paragraphs between Paragraph objects built from the same
+// content and laid out at the same width, so that rebuilding a widget with an
+// unchanged text does not shape and break its lines again.
+//
+// Cached paragraphs are immutable: they are painted and queried but never laid
+// out again. A Paragraph holding a cached instance that is laid out at another
+// width builds a fresh instance from its Content.
+class ParagraphCache {
+ public:
+  // Everything a paragraph is built from, recorded by ParagraphBuilder next to
+  // the txt builder. The key is a 128 bit digest of the encoded builder
+  // arguments, hashed as they are recorded so that the arguments are not
+  // copied a second time. Two contents with equal keys build identical
+  // paragraphs.
+  class Content {
+   public:
+    Content(const txt::ParagraphStyle& style,
+            std::shared_ptr<txt::FontCollection> font_collection);
+
+    ~Content();
+
+    template <class T>
+    void AppendKey(const T& value) {
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "Only plain values can be appended to the key.");
+      AppendKeyBytes(&value, sizeof(T));
+    }
+
+    // Appends |size| bytes preceded by their count, so that adjacent variable
+    // sized values can not be confused with each other.
+    void AppendKeyData(const void* data, size_t size);
+
+    void AppendKeyString(const std::string& value) {
+      AppendKeyData(value.data(), value.size());
+    }
+
+    void PushStyle(const txt::TextStyle& style);
+    void Pop();
+    void AddText(const std::u16string& text);
+    void AddPlaceholder(const txt::PlaceholderRun& placeholder);
+
+    // Marks the content as referencing objects that can not be part of a key,
+    // such as shaders. Such paragraphs are never cached.
+    void MarkUncacheable() { cacheable_ = false; }
+
+    bool cacheable() const { return cacheable_; }
+
+    std::string key() const;
+
+    size_t text_size() const { return text_size_; }
+
+    const txt::ParagraphStyle& paragraph_style() const {
+      return paragraph_style_;
+    }
+
+    const std::shared_ptr<txt::FontCollection>& font_collection() const {
+      return font_collection_;
+    }
+
+    // Returns all the text added, without placeholders.
+    std::u16string GetText() const;
+
+    // The canonical names of the font families the paragraph asks for.
+    const std::vector<std::string>& font_families() const {
+      return font_families_;
+    }
+
+    std::unique_ptr<txt::Paragraph> Build() const {
+      return Build(font_collection_);
+    }
+
+    // Builds the paragraph with |font_collection| instead of the collection
+    // the content was recorded with. Safe to call from several threads.
+    std::unique_ptr<txt::Paragraph> Build(
+        const std::shared_ptr<txt::FontCollection>& font_collection) const;
+
+   private:
+    enum class OpType : uint8_t { kPushStyle, kPop, kAddText, kAddPlaceholder };
+
+    struct Op {
+      OpType type;
+      size_t index;
+    };
+
+    txt::ParagraphStyle paragraph_style_;
+    std::shared_ptr<txt::FontCollection> font_collection_;
+    std::vector<Op> ops_;
+    std::vector<txt::TextStyle> styles_;
+    std::vector<std::u16string> texts_;
+    std::vector<txt::PlaceholderRun> placeholders_;
+    std::vector<std::string> font_families_;
+    uint64_t key_digests_[2];
+    size_t text_size_ = 0;
+    bool cacheable_ = true;
+
+    void AppendKeyBytes(const void* data, size_t size);
+
+    void MixKeyWord(uint64_t word);
+
+    void AddFontFamily(const std::string& family);
+
+    FML_DISALLOW_COPY_AND_ASSIGN(Content);
+  };
+
+  // The byte budget of the cache. Paragraphs do not report their memory use,
+  // so entries are accounted with an estimate based on their text length.
+  static constexpr size_t kMaxBytes = 16 * 1024 * 1024;
+
+  static ParagraphCache& GetInstance();
+
+  // Returns the paragraph built from |content| and laid out at |width|, or
+  // null if it is not cached.
+  std::shared_ptr<txt::Paragraph> Get(const Content& content, float width);
+
+  // Caches |paragraph|, which was built from |content| and laid out at
+  // |width|. Returns false if the paragraph was not cached, in which case it
+  // may still be laid out again by its owner.
+  bool Put(const Content& content, float width,
+           std::shared_ptr<txt::Paragraph> paragraph);
+
+  // Counts a paragraph that could not be cached, see Content::MarkUncacheable.
+  void RecordBypass();
+
+  // Drops all entries.
+  void Clear();
+
+  // Drops the entries of paragraphs built with |font_collection|. Called when
+  // the fonts available to its paragraphs change, or when it is destroyed.
+  void ClearFontCollection(const txt::FontCollection* font_collection);
+
+  // Drops the entries of paragraphs asking for one of |families|. Called
+  // when fonts are added to these families.
+  void ClearFamilies(const std::vector<std::string>& families);
+
+  // Reports the hit, miss and bypass counts since the last call, and resets
+  // them. Called once per frame.
+  void TraceStatsToTimeline();
+
+ private:
+  struct Entry {
+    std::shared_ptr<txt::Paragraph> paragraph;
+    const txt::FontCollection* font_collection;
+    std::vector<std::string> font_families;
+    size_t bytes;
+  };
+
+  // Most recently used first. The index refers to the keys stored in the
+  // list, whose nodes never move.
+  using LRUList = std::list<std::pair<std::string, Entry>>;
+
+  std::mutex mutex_;
+  LRUList lru_;
+  std::unordered_map<std::string_view, LRUList::iterator> index_;
+  size_t bytes_ = 0;
+
+  size_t hit_count_ = 0;
+  size_t miss_count_ = 0;
+  size_t bypass_count_ = 0;
+
+  ParagraphCache();
+
+  static std::string MakeKey(const Content& content, float width);
+
+  void EraseLocked(LRUList::iterator it);
+
+  FML_DISALLOW_COPY_AND_ASSIGN(ParagraphCache);
+};
+
+}  // namespace uiwidgets
@@ -1,6 +1,9 @@
 #include "window.h"
 
+#include "common/settings.h"
 #include "lib/ui/compositing/scene.h"
+#include "lib/ui/painting/paint_cache.h"
+#include "lib/ui/text/paragraph_cache.h"
 #include "lib/ui/ui_mono_state.h"
 #include "platform_message_response_mono.h"
 
@@ -59,6 +62,19 @@ Window_hook(
   Window_dispatchPointerDataPacket_ = Window_dispatchPointerDataPacket;
 }
 
+// Receives batches of frame timings, |frame_count| frames of
+// |values_per_frame| values each. See FrameTiming::kReportedValueCount for the
+// layout of a frame.
+typedef void (*Window_reportTimingsCallback)(const int64_t* timings,
+                                             int frame_count,
+                                             int values_per_frame);
+Window_reportTimingsCallback Window_reportTimings_;
+
+UIWIDGETS_API(void)
+Window_hookReportTimings(Window_reportTimingsCallback Window_reportTimings) {
+  Window_reportTimings_ = Window_reportTimings;
+}
+
 UIWIDGETS_API(Mono_Handle) Window_instance() {
   if (!UIMonoState::EnsureCurrentIsolate()) {
     return nullptr;
@@ -227,9 +243,24 @@ void Window::BeginFrame(fml::TimePoint frameTime) {
   UIMonoState::Current()->FlushMicrotasksNow();
 
   Window_drawFrame_();
+
+  PaintCache::GetInstance().TraceStatsToTimeline();
+  ParagraphCache::GetInstance().TraceStatsToTimeline();
 }
 
-void Window::ReportTimings(std::vector<int64_t> timings) {}
+void Window::ReportTimings(std::vector<int64_t> timings) {
+  if (!Window_reportTimings_ || timings.empty()) return;
+
+  std::shared_ptr<MonoState> mono_state = mono_state_.lock();
+  if (!mono_state) return;
+  MonoState::Scope scope(mono_state);
+
+  constexpr size_t kValuesPerFrame = FrameTiming::kReportedValueCount;
+  FML_DCHECK(timings.size() % kValuesPerFrame == 0);
+  Window_reportTimings_(timings.data(),
+                        static_cast<int>(timings.size() / kValuesPerFrame),
+                        static_cast<int>(kValuesPerFrame));
+}
 
 void Window::CompletePlatformMessageEmptyResponse(int response_id) {
   if (!response_id) return;
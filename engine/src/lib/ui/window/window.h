@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/time/time_point.h"
 #include "include/gpu/GrContext.h"
 #include "lib/ui/window/platform_message.h"
@@ -13,6 +14,7 @@
 #include "runtime/mono_state.h"
 
 namespace uiwidgets {
+class AssetManager;
 class FontCollection;
 class Scene;
 
@@ -33,6 +35,9 @@ class WindowClient {
   virtual void HandlePlatformMessage(fml::RefPtr<PlatformMessage> message) = 0;
   virtual FontCollection& GetFontCollection() = 0;
   virtual void SetNeedsReportTimings(bool value) = 0;
+  virtual std::shared_ptr<fml::ConcurrentMessageLoop>
+  GetConcurrentMessageLoop() = 0;
+  virtual std::shared_ptr<AssetManager> GetAssetManager() = 0;
 
  protected:
   virtual ~WindowClient();
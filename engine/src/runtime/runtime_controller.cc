@@ -224,6 +224,17 @@ void RuntimeController::SetNeedsReportTimings(bool value) {
   client_.SetNeedsReportTimings(value);
 }
 
+// |WindowClient|
+std::shared_ptr<fml::ConcurrentMessageLoop>
+RuntimeController::GetConcurrentMessageLoop() {
+  return client_.GetConcurrentMessageLoop();
+}
+
+// |WindowClient|
+std::shared_ptr<AssetManager> RuntimeController::GetAssetManager() {
+  return client_.GetAssetManager();
+}
+
 std::weak_ptr<MonoIsolate> RuntimeController::GetRootIsolate() {
   return root_isolate_;
 }
@@ -104,6 +104,13 @@ class RuntimeController final : public WindowClient {
   // |WindowClient|
   void SetNeedsReportTimings(bool value) override;
 
+  // |WindowClient|
+  std::shared_ptr<fml::ConcurrentMessageLoop> GetConcurrentMessageLoop()
+      override;
+
+  // |WindowClient|
+  std::shared_ptr<AssetManager> GetAssetManager() override;
+
   FML_DISALLOW_COPY_AND_ASSIGN(RuntimeController);
 };
 
@@ -3,7 +3,9 @@
 #include <memory>
 #include <vector>
 
+#include "assets/asset_manager.h"
 #include "flow/layers/layer_tree.h"
+#include "flutter/fml/concurrent_message_loop.h"
 #include "lib/ui/text/font_collection.h"
 
 #include "lib/ui/window/platform_message.h"
@@ -24,6 +26,11 @@ class RuntimeDelegate {
   
   virtual void SetNeedsReportTimings(bool value) = 0;
 
+  virtual std::shared_ptr<fml::ConcurrentMessageLoop>
+  GetConcurrentMessageLoop() = 0;
+
+  virtual std::shared_ptr<AssetManager> GetAssetManager() = 0;
+
  protected:
   virtual ~RuntimeDelegate();
 };
@@ -1,5 +1,7 @@
 #include "animator.h"
 
+#include <algorithm>
+
 #include "flutter/fml/trace_event.h"
 #include "runtime/mono_api.h"
 
@@ -13,28 +15,63 @@ namespace {
 constexpr fml::TimeDelta kNotifyIdleTaskWaitTime =
     fml::TimeDelta::FromMilliseconds(51);
 
+// The number of consecutive frames that must leave the deepest pipeline slot
+// unused before an adaptive pipeline gives that slot up again. About 2 seconds
+// at 60hz, so that a pipeline growing on periodic raster spikes does not
+// oscillate.
+constexpr int kStableFramesBeforeShrink = 120;
+
+bool RasterizesOnPlatformThread(const TaskRunners& task_runners) {
+  return task_runners.GetPlatformTaskRunner() ==
+         task_runners.GetRasterTaskRunner();
+}
+
+uint32_t GetMinPipelineDepth(const TaskRunners& task_runners,
+                             const Settings& settings) {
+  if (RasterizesOnPlatformThread(task_runners)) {
+    return 1;
+  }
+  return std::max<uint32_t>(settings.frame_pipeline_depth, 1);
+}
+
+uint32_t GetMaxPipelineDepth(const TaskRunners& task_runners,
+                             const Settings& settings) {
+  const uint32_t min_depth = GetMinPipelineDepth(task_runners, settings);
+  if (RasterizesOnPlatformThread(task_runners) ||
+      !settings.enable_adaptive_frame_pipeline_depth) {
+    return min_depth;
+  }
+  return std::max(min_depth, settings.max_frame_pipeline_depth);
+}
+
 }  // namespace
 
 Animator::Animator(Delegate& delegate, TaskRunners task_runners,
+                   const Settings& settings,
                    std::unique_ptr<VsyncWaiter> waiter)
     : delegate_(delegate),
       task_runners_(std::move(task_runners)),
       waiter_(std::move(waiter)),
       last_frame_begin_time_(),
+      last_frame_build_start_(),
       last_frame_target_time_(),
       mono_frame_deadline_(0),
       layer_tree_pipeline_(fml::MakeRefCounted<LayerTreePipeline>(
-          task_runners.GetPlatformTaskRunner() ==
-                  task_runners.GetRasterTaskRunner()
-              ? 1
-              : 2)),
+          GetMinPipelineDepth(task_runners_, settings),
+          GetMaxPipelineDepth(task_runners_, settings))),
       pending_frame_semaphore_(1),
       frame_number_(1),
+      last_frame_number_(0),
       paused_(false),
       regenerate_layer_tree_(false),
       frame_scheduled_(false),
       notify_idle_task_id_(0),
       dimension_change_pending_(false),
+      min_pipeline_depth_(layer_tree_pipeline_->GetDepth()),
+      adaptive_pipeline_depth_(layer_tree_pipeline_->GetMaxDepth() >
+                               min_pipeline_depth_),
+      stable_frame_count_(0),
+      dropped_frame_count_(0),
       weak_factory_(this) {}
 
 Animator::~Animator() = default;
@@ -75,6 +112,56 @@ const char* Animator::FrameParity() {
   return (frame_number_ % 2) ? "even" : "odd";
 }
 
+uint32_t Animator::GetPipelineDepth() const {
+  return layer_tree_pipeline_->GetDepth();
+}
+
+Animator::LayerTreePipeline::ProducerContinuation Animator::ProduceFrame() {
+  const uint32_t depth = layer_tree_pipeline_->GetDepth();
+  // The raster thread is keeping up if another frame would still fit after
+  // this one, in which case the deepest slot of the pipeline goes unused.
+  const bool has_spare_slot =
+      layer_tree_pipeline_->GetInflightCount() + 1 < static_cast<int>(depth);
+
+  auto continuation = layer_tree_pipeline_->Produce();
+  if (!adaptive_pipeline_depth_) {
+    return continuation;
+  }
+
+  if (!continuation) {
+    stable_frame_count_ = 0;
+    if (depth < layer_tree_pipeline_->GetMaxDepth()) {
+      // Rasterization fell behind. Trade a frame of latency for not dropping
+      // this frame.
+      TRACE_EVENT_INSTANT0("uiwidgets", "Animator::GrowPipelineDepth");
+      layer_tree_pipeline_->SetDepth(depth + 1);
+      continuation = layer_tree_pipeline_->Produce();
+    }
+    return continuation;
+  }
+
+  if (depth > min_pipeline_depth_ && has_spare_slot) {
+    if (++stable_frame_count_ >= kStableFramesBeforeShrink) {
+      TRACE_EVENT_INSTANT0("uiwidgets", "Animator::ShrinkPipelineDepth");
+      layer_tree_pipeline_->SetDepth(depth - 1);
+      stable_frame_count_ = 0;
+    }
+  } else {
+    stable_frame_count_ = 0;
+  }
+  return continuation;
+}
+
+void Animator::TracePipelineStats() const {
+#if !UIWidgets_RELEASE
+  FML_TRACE_COUNTER("uiwidgets", "Animator",
+                    reinterpret_cast<int64_t>(this),                    //
+                    "PipelineDepth", layer_tree_pipeline_->GetDepth(),  //
+                    "DroppedFrames", dropped_frame_count_               //
+  );
+#endif  // !UIWidgets_RELEASE
+}
+
 static int64_t FmlToMonoOrEarlier(fml::TimePoint time) {
   int64_t mono_now = Mono_TimelineGetMicros();
   fml::TimePoint fml_now = fml::TimePoint::Now();
@@ -83,6 +170,7 @@ static int64_t FmlToMonoOrEarlier(fml::TimePoint time) {
 
 void Animator::BeginFrame(fml::TimePoint frame_start_time,
                           fml::TimePoint frame_target_time) {
+  last_frame_number_ = frame_number_;
   TRACE_EVENT_ASYNC_END0("uiwidgets", "Frame Request Pending", frame_number_++);
 
   TRACE_EVENT0("uiwidgets", "Animator::BeginFrame");
@@ -101,15 +189,18 @@ void Animator::BeginFrame(fml::TimePoint frame_start_time,
     // We may already have a valid pipeline continuation in case a previous
     // begin frame did not result in an Animation::Render. Simply reuse that
     // instead of asking the pipeline for a fresh continuation.
-    producer_continuation_ = layer_tree_pipeline_->Produce();
+    producer_continuation_ = ProduceFrame();
 
     if (!producer_continuation_) {
       // If we still don't have valid continuation, the pipeline is currently
       // full because the consumer is being too slow. Try again at the next
       // frame interval.
+      dropped_frame_count_++;
+      TracePipelineStats();
       RequestFrame();
       return;
     }
+    TracePipelineStats();
   }
 
   // We have acquired a valid continuation from the pipeline and are ready
@@ -119,6 +210,7 @@ void Animator::BeginFrame(fml::TimePoint frame_start_time,
   last_frame_begin_time_ = frame_start_time;
   last_frame_target_time_ = frame_target_time;
   mono_frame_deadline_ = FmlToMonoOrEarlier(frame_target_time);
+  last_frame_build_start_ = fml::TimePoint::Now();
   {
     TRACE_EVENT2("uiwidgets", "Framework Workload", "mode", "basic", "frame",
                  FrameParity());
@@ -163,7 +255,8 @@ void Animator::Render(std::unique_ptr<LayerTree> layer_tree) {
 
   if (layer_tree) {
     // Note the frame time for instrumentation.
-    layer_tree->RecordBuildTime(last_frame_begin_time_,
+    layer_tree->RecordBuildTime(last_frame_number_, last_frame_begin_time_,
+                                last_frame_build_start_,
                                 last_frame_target_time_);
   }
 
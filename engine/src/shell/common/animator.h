@@ -2,6 +2,7 @@
 
 #include <deque>
 
+#include "common/settings.h"
 #include "common/task_runners.h"
 #include "flutter/fml/memory/ref_ptr.h"
 #include "flutter/fml/memory/weak_ptr.h"
@@ -27,7 +28,7 @@ class Animator final {
   };
 
   Animator(Delegate& delegate, TaskRunners task_runners,
-           std::unique_ptr<VsyncWaiter> waiter);
+           const Settings& settings, std::unique_ptr<VsyncWaiter> waiter);
 
   ~Animator();
 
@@ -49,6 +50,14 @@ class Animator final {
   // will be ended during the next |BeginFrame|.
   void EnqueueTraceFlowId(uint64_t trace_flow_id);
 
+  // The number of frames the UI thread may currently build ahead of the
+  // raster thread.
+  uint32_t GetPipelineDepth() const;
+
+  // The number of UI frames that were not built because the pipeline was
+  // full.
+  int64_t GetDroppedFrameCount() const { return dropped_frame_count_; }
+
  private:
   using LayerTreePipeline = Pipeline<LayerTree>;
 
@@ -62,17 +71,25 @@ class Animator final {
 
   const char* FrameParity();
 
+  // Acquires a continuation from the pipeline, growing the pipeline first if
+  // it is full and the adaptive depth allows it.
+  LayerTreePipeline::ProducerContinuation ProduceFrame();
+
+  void TracePipelineStats() const;
+
   Delegate& delegate_;
   TaskRunners task_runners_;
   std::shared_ptr<VsyncWaiter> waiter_;
 
   fml::TimePoint last_frame_begin_time_;
+  fml::TimePoint last_frame_build_start_;
   fml::TimePoint last_frame_target_time_;
   int64_t mono_frame_deadline_;
   fml::RefPtr<LayerTreePipeline> layer_tree_pipeline_;
   fml::Semaphore pending_frame_semaphore_;
   LayerTreePipeline::ProducerContinuation producer_continuation_;
   int64_t frame_number_;
+  int64_t last_frame_number_;
   bool paused_;
   bool regenerate_layer_tree_;
   bool frame_scheduled_;
@@ -80,6 +97,10 @@ class Animator final {
   bool dimension_change_pending_;
   SkISize last_layer_tree_size_;
   std::deque<uint64_t> trace_flow_ids_;
+  const uint32_t min_pipeline_depth_;
+  const bool adaptive_pipeline_depth_;
+  int stable_frame_count_;
+  int64_t dropped_frame_count_;
 
   fml::WeakPtrFactory<Animator> weak_factory_;
 
@@ -15,6 +15,7 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkPictureRecorder.h"
 #include "lib/ui/text/font_collection.h"
+#include "lib/ui/text/glyph_cache_prewarmer.h"
 #include "rapidjson/document.h"
 #include "shell/common/animator.h"
 #include "shell/common/platform_view.h"
@@ -42,7 +43,10 @@ Engine::Engine(Delegate& delegate,
       activity_running_(true),
       have_surface_(false),
       image_decoder_(task_runners, concurrent_message_loop_->GetTaskRunner(),
-                     io_manager),
+                     io_manager, snapshot_delegate,
+                     settings_.decoded_image_cache_max_bytes,
+                     settings_.image_resize_quality,
+                     settings_.image_decoder_max_concurrent_decodes),
       task_runners_(std::move(task_runners)),
       weak_factory_(this) {
   // Runtime controller is initialized here because it takes a reference to this
@@ -91,14 +95,40 @@ bool Engine::UpdateAssetManager(
     if (fontSettings != settings.MemberEnd() && fontSettings->value.IsArray()) {
       rapidjson::Value::Array fontArray = fontSettings->value.GetArray();
       font_collection_.RegisterFonts(asset_manager_, fontArray);
+      PrewarmGlyphCache();
       return true;
     }
   } 
   font_collection_.RegisterFonts(asset_manager_);
-  
+  PrewarmGlyphCache();
+
   return true;
 }
 
+void Engine::PrewarmGlyphCache() {
+  if (settings_.glyph_prewarm_asset.empty()) {
+    return;
+  }
+  std::unique_ptr<fml::Mapping> mapping =
+      asset_manager_->GetAsMapping(settings_.glyph_prewarm_asset);
+  if (mapping == nullptr) {
+    FML_DLOG(WARNING) << "Could not find the glyph prewarm list "
+                      << settings_.glyph_prewarm_asset;
+    return;
+  }
+
+  auto prewarmer = std::make_shared<GlyphCachePrewarmer>(
+      GlyphCachePrewarmer::ParseEntries(mapping->GetMapping(),
+                                        mapping->GetSize()),
+      font_collection_);
+  std::shared_ptr<fml::ConcurrentMessageLoop> loop =
+      GetConcurrentMessageLoop();
+  if (prewarmer->empty() || !loop) {
+    return;
+  }
+  loop->GetTaskRunner()->PostTask([prewarmer]() { prewarmer->Prewarm(); });
+}
+
 bool Engine::Restart(RunConfiguration configuration) {
   TRACE_EVENT0("uiwidgets", "Engine::Restart");
   if (!configuration.IsValid()) {
@@ -159,6 +189,12 @@ Engine::RunStatus Engine::PrepareAndLaunchIsolate(
 void Engine::BeginFrame(fml::TimePoint frame_time) {
   TRACE_EVENT0("uiwidgets", "Engine::BeginFrame");
   runtime_controller_->BeginFrame(frame_time);
+  image_decoder_.TraceStatsToTimeline();
+}
+
+void Engine::NotifyLowMemoryWarning() {
+  TRACE_EVENT0("uiwidgets", "Engine::NotifyLowMemoryWarning");
+  image_decoder_.NotifyLowMemoryWarning();
 }
 
 void Engine::ReportTimings(std::vector<int64_t> timings) {
@@ -369,6 +405,10 @@ std::shared_ptr<fml::ConcurrentMessageLoop> Engine::GetConcurrentMessageLoop() {
   return concurrent_message_loop_;
 }
 
+std::shared_ptr<AssetManager> Engine::GetAssetManager() {
+  return asset_manager_;
+}
+
 void Engine::HandleAssetPlatformMessage(fml::RefPtr<PlatformMessage> message) {
   fml::RefPtr<PlatformMessageResponse> response = message->response();
   if (!response) {
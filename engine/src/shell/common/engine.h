@@ -67,6 +67,9 @@ class Engine final : public RuntimeDelegate, PointerDataDispatcher::Delegate {
 
   void NotifyIdle(int64_t deadline);
 
+  // Releases the memory held by the engine's caches.
+  void NotifyLowMemoryWarning();
+
   void ReportTimings(std::vector<int64_t> timings);
 
   void OnOutputSurfaceCreated();
@@ -93,7 +96,12 @@ class Engine final : public RuntimeDelegate, PointerDataDispatcher::Delegate {
   // |PointerDataDispatcher::Delegate|
   void ScheduleSecondaryVsyncCallback(const fml::closure& callback) override;
 
-	std::shared_ptr<fml::ConcurrentMessageLoop> GetConcurrentMessageLoop();
+  // |RuntimeDelegate|
+  std::shared_ptr<fml::ConcurrentMessageLoop> GetConcurrentMessageLoop()
+      override;
+
+  // |RuntimeDelegate|
+  std::shared_ptr<AssetManager> GetAssetManager() override;
 
  private:
   Delegate& delegate_;
@@ -132,6 +140,10 @@ class Engine final : public RuntimeDelegate, PointerDataDispatcher::Delegate {
 
   void StartAnimatorIfPossible();
 
+  // Rasterizes the glyphs listed by the |glyph_prewarm_asset| setting on a
+  // worker thread.
+  void PrewarmGlyphCache();
+
   bool HandleLifecyclePlatformMessage(PlatformMessage* message);
 
   bool HandleNavigationPlatformMessage(fml::RefPtr<PlatformMessage> message);
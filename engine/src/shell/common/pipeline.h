@@ -5,6 +5,8 @@
 #include "flutter/fml/synchronization/semaphore.h"
 #include "flutter/fml/trace_event.h"
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -83,14 +85,37 @@ class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
     FML_DISALLOW_COPY_AND_ASSIGN(ProducerContinuation);
   };
 
-  explicit Pipeline(uint32_t depth)
-      : depth_(depth), empty_(depth), available_(0), inflight_(0) {}
+  explicit Pipeline(uint32_t depth) : Pipeline(depth, depth) {}
+
+  // Creates a pipeline whose depth can later be raised up to |max_depth|.
+  Pipeline(uint32_t depth, uint32_t max_depth)
+      : depth_(std::min(depth, max_depth)),
+        max_depth_(max_depth),
+        empty_(max_depth),
+        available_(0),
+        inflight_(0) {}
 
   ~Pipeline() = default;
 
   bool IsValid() const { return empty_.IsValid() && available_.IsValid(); }
 
+  uint32_t GetDepth() const { return depth_.load(); }
+
+  uint32_t GetMaxDepth() const { return max_depth_; }
+
+  // Changes how many resources may be in flight at once, clamped to the
+  // maximum depth. Lowering the depth does not drop resources already in
+  // flight, |Produce| fails until enough of them have been consumed.
+  void SetDepth(uint32_t depth) {
+    depth_ = std::clamp<uint32_t>(depth, 1, max_depth_);
+  }
+
+  int GetInflightCount() const { return inflight_.load(); }
+
   ProducerContinuation Produce() {
+    if (inflight_.load() >= static_cast<int>(depth_.load())) {
+      return {};
+    }
     if (!empty_.TryWait()) {
       return {};
     }
@@ -165,7 +190,8 @@ class Pipeline : public fml::RefCountedThreadSafe<Pipeline<R>> {
   }
 
  private:
-  const uint32_t depth_;
+  std::atomic<uint32_t> depth_;
+  const uint32_t max_depth_;
   fml::Semaphore empty_;
   fml::Semaphore available_;
   std::atomic<int> inflight_;
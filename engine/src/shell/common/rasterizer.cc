@@ -1,8 +1,10 @@
 #include "rasterizer.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkGraphics.h"
 #include "include/core/SkImageEncoder.h"
 #include "include/core/SkPictureRecorder.h"
 #include "include/core/SkSerialProcs.h"
@@ -17,6 +19,10 @@ namespace uiwidgets {
 // used within this interval.
 static constexpr std::chrono::milliseconds kSkiaCleanupExpiration(15000);
 
+// The share of the frame budget spent on deferred raster cache population
+// after each frame.
+static constexpr double kRasterCachePopulationBudgetRatio = 0.25;
+
 Rasterizer::Rasterizer(Delegate& delegate, TaskRunners task_runners)
     : Rasterizer(
           delegate, std::move(task_runners),
@@ -30,6 +36,13 @@ Rasterizer::Rasterizer(Delegate& delegate, TaskRunners task_runners,
       user_override_resource_cache_bytes_(false),
       weak_factory_(this) {
   FML_DCHECK(compositor_context_);
+  const Settings& settings = delegate_.GetSettings();
+  compositor_context_->raster_cache().SetRetentionPolicy(
+      settings.raster_cache_max_bytes, settings.raster_cache_max_unused_frames);
+  compositor_context_->raster_cache().SetMaxVariantsPerID(
+      settings.raster_cache_max_variants_per_id);
+  compositor_context_->raster_cache().SetDeferredPopulation(
+      settings.raster_cache_deferred_population);
 }
 
 Rasterizer::~Rasterizer() = default;
@@ -44,6 +57,7 @@ fml::WeakPtr<SnapshotDelegate> Rasterizer::GetSnapshotDelegate() const {
 
 void Rasterizer::Setup(std::unique_ptr<Surface> surface) {
   surface_ = std::move(surface);
+  surface_contents_valid_ = false;
   if (max_cache_bytes_.has_value()) {
     SetResourceCacheMaxBytes(max_cache_bytes_.value(),
                              user_override_resource_cache_bytes_);
@@ -62,9 +76,16 @@ void Rasterizer::Teardown() {
   compositor_context_->OnGrContextDestroyed();
   surface_.reset();
   last_layer_tree_.reset();
+  surface_contents_valid_ = false;
+}
+
+void Rasterizer::InvalidateSurfaceContents() {
+  surface_contents_valid_ = false;
 }
 
 void Rasterizer::NotifyLowMemoryWarning() const {
+  // Entries kept around for reuse are the first thing to give up.
+  compositor_context_->raster_cache().Clear();
   if (!surface_) {
     FML_DLOG(INFO) << "Rasterizer::PurgeCaches called with no surface.";
     return;
@@ -87,7 +108,9 @@ void Rasterizer::DrawLastLayerTree() {
   if (!last_layer_tree_ || !surface_) {
     return;
   }
-  DrawToSurface(*last_layer_tree_);
+  if (DrawToSurface(*last_layer_tree_) == RasterStatus::kSuccess) {
+    surface_contents_valid_ = true;
+  }
   surface_->ClearContext();
 }
 
@@ -217,6 +240,32 @@ sk_sp<SkImage> Rasterizer::ConvertToRasterImage(sk_sp<SkImage> image) {
                               });
 }
 
+sk_sp<SkImage> Rasterizer::MakeCompressedTextureImage(
+    sk_sp<SkData> data, SkISize dimensions, SkImage::CompressionType type) {
+  TRACE_EVENT0("uiwidgets", __FUNCTION__);
+  FML_DCHECK(task_runners_.GetRasterTaskRunner()->RunsTasksOnCurrentThread());
+
+  if (surface_ == nullptr || surface_->GetContext() == nullptr) {
+    return nullptr;
+  }
+
+  if (!surface_->MakeRenderContextCurrent()) {
+    surface_->ClearContext();
+    return nullptr;
+  }
+
+  GrContext* context = surface_->GetContext();
+  sk_sp<SkImage> image;
+  if (context->compressedBackendFormat(type).isValid()) {
+    image = SkImage::MakeFromCompressed(context, std::move(data),
+                                        dimensions.width(),
+                                        dimensions.height(), type);
+  }
+
+  surface_->ClearContext();
+  return image;
+}
+
 RasterStatus Rasterizer::DoDraw(std::unique_ptr<LayerTree> layer_tree) {
   FML_DCHECK(task_runners_.GetRasterTaskRunner()->RunsTasksOnCurrentThread());
 
@@ -225,6 +274,8 @@ RasterStatus Rasterizer::DoDraw(std::unique_ptr<LayerTree> layer_tree) {
   }
 
   FrameTiming timing;
+  timing.set_frame_number(layer_tree->frame_number());
+  timing.Set(FrameTiming::kVsyncStart, layer_tree->vsync_start());
   timing.Set(FrameTiming::kBuildStart, layer_tree->build_start());
   timing.Set(FrameTiming::kBuildFinish, layer_tree->build_finish());
   timing.Set(FrameTiming::kRasterStart, fml::TimePoint::Now());
@@ -232,14 +283,27 @@ RasterStatus Rasterizer::DoDraw(std::unique_ptr<LayerTree> layer_tree) {
   PersistentCache* persistent_cache = PersistentCache::GetCacheForProcess();
   persistent_cache->ResetStoredNewShaders();
 
-  RasterStatus raster_status = DrawToSurface(*layer_tree);
-  surface_->ClearContext();
+  RasterStatus raster_status = RasterStatus::kSuccess;
+  if (IsSameAsLastLayerTree(*layer_tree)) {
+    // The surface still holds the frame painted from an identical tree. That
+    // tree stays the last layer tree, as it is the one the surface contents
+    // were recorded from.
+    TRACE_EVENT_INSTANT0("uiwidgets", "Layer tree unchanged, skipping frame");
+    FireNextFrameCallbackIfPresent();
+  } else {
+    raster_status = DrawToSurface(*layer_tree);
+    surface_->ClearContext();
 
-  if (raster_status == RasterStatus::kSuccess) {
-    last_layer_tree_ = std::move(layer_tree);
-  } else if (raster_status == RasterStatus::kResubmit) {
-    resubmitted_layer_tree_ = std::move(layer_tree);
-    return raster_status;
+    if (raster_status == RasterStatus::kSuccess) {
+      const auto& raster_cache = compositor_context_->raster_cache();
+      timing.set_raster_cache_stats(raster_cache.GetLastFrameHitCount(),
+                                    raster_cache.GetLastFrameMissCount());
+      last_layer_tree_ = std::move(layer_tree);
+      surface_contents_valid_ = true;
+    } else if (raster_status == RasterStatus::kResubmit) {
+      resubmitted_layer_tree_ = std::move(layer_tree);
+      return raster_status;
+    }
   }
 
   if (persistent_cache->IsDumpingSkp() &&
@@ -281,6 +345,25 @@ RasterStatus Rasterizer::DoDraw(std::unique_ptr<LayerTree> layer_tree) {
   return raster_status;
 }
 
+bool Rasterizer::IsSameAsLastLayerTree(const LayerTree& layer_tree) const {
+  // Like partial repaint, skipping the frame relies on the surface keeping
+  // what was painted into it.
+  if (!last_layer_tree_ || !surface_contents_valid_ ||
+      !delegate_.GetSettings().enable_partial_repaint ||
+      !surface_->SupportsPartialRepaint() ||
+      surface_->GetExternalViewEmbedder()) {
+    return false;
+  }
+  const auto& fingerprint = layer_tree.fingerprint();
+  return fingerprint.has_value() &&
+         fingerprint == last_layer_tree_->fingerprint() &&
+         layer_tree.frame_size() == last_layer_tree_->frame_size() &&
+         layer_tree.frame_physical_depth() ==
+             last_layer_tree_->frame_physical_depth() &&
+         layer_tree.frame_device_pixel_ratio() ==
+             last_layer_tree_->frame_device_pixel_ratio();
+}
+
 RasterStatus Rasterizer::DrawToSurface(LayerTree& layer_tree) {
   TRACE_EVENT0("uiwidgets", "Rasterizer::DrawToSurface");
   FML_DCHECK(surface_);
@@ -326,7 +409,22 @@ RasterStatus Rasterizer::DrawToSurface(LayerTree& layer_tree) {
   );
 
   if (compositor_frame) {
+    if (delegate_.GetSettings().enable_partial_repaint &&
+        surface_->SupportsPartialRepaint()) {
+      // Redrawing the last layer tree means the surface contents can not be
+      // trusted anymore, so it is repainted fully, as it is after the render
+      // target was re-created.
+      const LayerTree* previous_layer_tree =
+          surface_contents_valid_ && last_layer_tree_.get() != &layer_tree
+              ? last_layer_tree_.get()
+              : nullptr;
+      compositor_frame->EnablePartialRepaint(previous_layer_tree);
+    }
+
+    const size_t font_cache_used = SkGraphics::GetFontCacheUsed();
+    const int font_cache_count = SkGraphics::GetFontCacheCountUsed();
     RasterStatus raster_status = compositor_frame->Raster(layer_tree, false);
+    TraceGlyphCacheGrowth(font_cache_used, font_cache_count);
     if (raster_status == RasterStatus::kFailed) {
       return raster_status;
     }
@@ -345,6 +443,16 @@ RasterStatus Rasterizer::DrawToSurface(LayerTree& layer_tree) {
 
     FireNextFrameCallbackIfPresent();
 
+    // Populate the raster cache once the frame is out of the way, so that the
+    // frame crossing the access threshold of a picture does not pay for it.
+    auto& raster_cache = compositor_context_->raster_cache();
+    if (raster_cache.HasPendingPopulation()) {
+      fml::TimeDelta population_budget = fml::TimeDelta::FromMicroseconds(
+          static_cast<int64_t>(delegate_.GetFrameBudget().count() *
+                               kRasterCachePopulationBudgetRatio * 1000));
+      raster_cache.PopulatePending(surface_->GetContext(), population_budget);
+    }
+
     if (surface_->GetContext()) {
       TRACE_EVENT0("uiwidgets", "PerformDeferredSkiaCleanup");
       surface_->GetContext()->performDeferredCleanup(kSkiaCleanupExpiration);
@@ -355,6 +463,26 @@ RasterStatus Rasterizer::DrawToSurface(LayerTree& layer_tree) {
   return RasterStatus::kFailed;
 }
 
+void Rasterizer::TraceGlyphCacheGrowth(size_t font_cache_used_before,
+                                       int font_cache_count_before) {
+#if !UIWidgets_RELEASE
+  const size_t font_cache_used = SkGraphics::GetFontCacheUsed();
+  const int font_cache_count = SkGraphics::GetFontCacheCountUsed();
+  // The cache may have purged entries during the frame.
+  const size_t added_bytes = font_cache_used > font_cache_used_before
+                                 ? font_cache_used - font_cache_used_before
+                                 : 0;
+  const int added_strikes =
+      std::max(font_cache_count - font_cache_count_before, 0);
+  FML_TRACE_COUNTER("uiwidgets", "GlyphCache",
+                    reinterpret_cast<int64_t>(this),       //
+                    "AddedKBytes", added_bytes * 1e-3,     //
+                    "AddedStrikes", added_strikes,         //
+                    "UsedMBytes", font_cache_used * 1e-6   //
+  );
+#endif  // !UIWidgets_RELEASE
+}
+
 static sk_sp<SkData> SerializeTypeface(SkTypeface* typeface, void* ctx) {
   return typeface->serialize(SkTypeface::SerializeBehavior::kDoIncludeData);
 }
@@ -23,6 +23,7 @@ class Rasterizer final : public SnapshotDelegate {
    public:
     virtual void OnFrameRasterized(const FrameTiming& frame_timing) = 0;
     virtual fml::Milliseconds GetFrameBudget() = 0;
+    virtual const Settings& GetSettings() const = 0;
   };
 
   Rasterizer(Delegate& delegate, TaskRunners task_runners);
@@ -36,6 +37,11 @@ class Rasterizer final : public SnapshotDelegate {
 
   void Teardown();
 
+  // Called when the render target behind the surface was re-created, so that
+  // the next frame is painted in full instead of only the region that
+  // changed since the last layer tree.
+  void InvalidateSurfaceContents();
+
   void NotifyLowMemoryWarning() const;
 
   fml::WeakPtr<Rasterizer> GetWeakPtr() const;
@@ -87,6 +93,8 @@ class Rasterizer final : public SnapshotDelegate {
   std::unique_ptr<CompositorContext> compositor_context_;
   // This is the last successfully rasterized layer tree.
   std::unique_ptr<LayerTree> last_layer_tree_;
+  // Whether the surface still shows what was painted from |last_layer_tree_|.
+  bool surface_contents_valid_ = false;
   // Set when we need attempt to rasterize the layer tree again. This layer_tree
   // has not successfully rasterized. This can happen due to the change in the
   // thread configuration. This will be inserted to the front of the pipeline.
@@ -104,6 +112,11 @@ class Rasterizer final : public SnapshotDelegate {
   // |SnapshotDelegate|
   sk_sp<SkImage> ConvertToRasterImage(sk_sp<SkImage> image) override;
 
+  // |SnapshotDelegate|
+  sk_sp<SkImage> MakeCompressedTextureImage(
+      sk_sp<SkData> data, SkISize dimensions,
+      SkImage::CompressionType type) override;
+
   sk_sp<SkImage> DoMakeRasterSnapshot(
       SkISize size, std::function<void(SkCanvas*)> draw_callback);
 
@@ -111,8 +124,19 @@ class Rasterizer final : public SnapshotDelegate {
 
   RasterStatus DrawToSurface(LayerTree& layer_tree);
 
+  // Whether |layer_tree| paints exactly what the surface still shows from
+  // the last layer tree, so that rasterizing it can be skipped.
+  bool IsSameAsLastLayerTree(const LayerTree& layer_tree) const;
+
   void FireNextFrameCallbackIfPresent();
 
+  // Reports the growth of Skia's glyph cache while rasterizing a frame,
+  // which approximates the glyphs that frame had to rasterize. Skia does not
+  // count glyph cache misses, and glyphs added by other threads during the
+  // frame are counted as well.
+  void TraceGlyphCacheGrowth(size_t font_cache_used_before,
+                             int font_cache_count_before);
+
   FML_DISALLOW_COPY_AND_ASSIGN(Rasterizer);
 };
 
@@ -140,8 +140,9 @@ std::unique_ptr<Shell> Shell::CreateShellOnPlatformThread(
 
         // The animator is owned by the UI thread but it gets its vsync pulses
         // from the platform.
-        auto animator = std::make_unique<Animator>(*shell, task_runners,
-                                                   std::move(vsync_waiter));
+        auto animator = std::make_unique<Animator>(
+            *shell, task_runners, shell->GetSettings(),
+            std::move(vsync_waiter));
 
         engine_promise.set_value(std::make_unique<Engine>(
             *shell,                         //
@@ -371,6 +372,11 @@ void Shell::NotifyLowMemoryWarning() const {
           rasterizer->NotifyLowMemoryWarning();
         }
       });
+  task_runners_.GetUITaskRunner()->PostTask([engine = weak_engine_]() {
+    if (engine) {
+      engine->NotifyLowMemoryWarning();
+    }
+  });
   // The IO Manager uses resource cache limits of 0, so it is not necessary
   // to purge them.
 }
@@ -444,6 +450,17 @@ bool Shell::Setup(std::unique_ptr<PlatformView> platform_view,
                                       }
                                     });
 
+  if (settings_.enable_parallel_preroll) {
+    fml::TaskRunner::RunNowOrPostTask(
+        task_runners_.GetRasterTaskRunner(),
+        [rasterizer = rasterizer_->GetWeakPtr(),
+         loop = engine_->GetConcurrentMessageLoop()]() {
+          if (rasterizer) {
+            rasterizer->compositor_context()->SetParallelPrerollLoop(loop);
+          }
+        });
+  }
+
   is_setup_ = true;
 
   PersistentCache::GetCacheForProcess()->AddWorkerTaskRunner(
@@ -936,18 +953,22 @@ void Shell::ReportTimings() {
 
   auto timings = std::move(unreported_timings_);
   unreported_timings_ = {};
-  task_runners_.GetUITaskRunner()->PostTask([timings, engine = weak_engine_] {
-    if (engine) {
-      engine->ReportTimings(std::move(timings));
-    }
-  });
+  unreported_timings_.reserve(timings.size());
+  task_runners_.GetUITaskRunner()->PostTask(
+      fml::MakeCopyable([timings = std::move(timings),
+                         engine = weak_engine_]() mutable {
+        if (engine) {
+          engine->ReportTimings(std::move(timings));
+        }
+      }));
 }
 
 size_t Shell::UnreportedFramesCount() const {
   // Check that this is running on the raster thread to avoid race conditions.
   FML_DCHECK(task_runners_.GetRasterTaskRunner()->RunsTasksOnCurrentThread());
-  FML_DCHECK(unreported_timings_.size() % FrameTiming::kCount == 0);
-  return unreported_timings_.size() / FrameTiming::kCount;
+  FML_DCHECK(unreported_timings_.size() % FrameTiming::kReportedValueCount ==
+             0);
+  return unreported_timings_.size() / FrameTiming::kReportedValueCount;
 }
 
 void Shell::OnFrameRasterized(const FrameTiming& timing) {
@@ -964,10 +985,13 @@ void Shell::OnFrameRasterized(const FrameTiming& timing) {
     return;
   }
 
+  unreported_timings_.push_back(timing.frame_number());
   for (auto phase : FrameTiming::kPhases) {
     unreported_timings_.push_back(
         timing.Get(phase).ToEpochDelta().ToMicroseconds());
   }
+  unreported_timings_.push_back(timing.raster_cache_hits());
+  unreported_timings_.push_back(timing.raster_cache_misses());
 
   // In tests using iPhone 6S with profile mode, sending a batch of 1 frame or a
   // batch of 100 frames have roughly the same cost of less than 0.1ms. Sending
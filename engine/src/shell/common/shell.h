@@ -51,7 +51,8 @@ class Shell final : public PlatformView::Delegate,
   void RunEngine(RunConfiguration run_configuration,
                  const std::function<void(Engine::RunStatus)>& result_callback);
 
-  const Settings& GetSettings() const;
+  // |Rasterizer::Delegate|
+  const Settings& GetSettings() const override;
 
   const TaskRunners& GetTaskRunners() const;
 
@@ -104,9 +105,9 @@ class Shell final : public PlatformView::Delegate,
   // ui.Window.onReportTimings.
   bool frame_timings_report_scheduled_ = false;
 
-  // Vector of FrameTiming::kCount * n timestamps for n frames whose timings
-  // have not been reported yet. Vector of ints instead of FrameTiming is stored
-  // here for easier conversions to Dart objects.
+  // Vector of FrameTiming::kReportedValueCount * n values for n frames whose
+  // timings have not been reported yet. Vector of ints instead of FrameTiming
+  // is stored here so that the batch can be handed to managed code as is.
   std::vector<int64_t> unreported_timings_;
 
   // A cache of `Engine::GetDisplayRefreshRate` (only callable in the UI thread)
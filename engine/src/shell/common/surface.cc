@@ -64,4 +64,8 @@ bool Surface::MakeRenderContextCurrent() {
   return true;
 }
 
+bool Surface::SupportsPartialRepaint() const {
+  return false;
+}
+
 }  // namespace uiwidgets
@@ -65,6 +65,11 @@ class Surface {
 
   virtual bool MakeRenderContextCurrent();
 
+  // Whether frames acquired from this surface keep the contents of the
+  // previous frame, so that only the region that changed has to be
+  // repainted.
+  virtual bool SupportsPartialRepaint() const;
+
  private:
   FML_DISALLOW_COPY_AND_ASSIGN(Surface);
 };
@@ -334,4 +334,11 @@ bool GPUSurfaceGL::MakeRenderContextCurrent() {
   return delegate_->GLContextMakeCurrent();
 }
 
+// |Surface|
+bool GPUSurfaceGL::SupportsPartialRepaint() const {
+  // The onscreen surface wraps the same framebuffer for as long as its size
+  // does not change, and frames of another size are always repainted fully.
+  return render_to_surface_;
+}
+
 }  // namespace uiwidgets
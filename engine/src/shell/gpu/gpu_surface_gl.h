@@ -43,6 +43,9 @@ class GPUSurfaceGL : public Surface {
   // |Surface|
   bool MakeRenderContextCurrent() override;
 
+  // |Surface|
+  bool SupportsPartialRepaint() const override;
+
  private:
   GPUSurfaceGLDelegate* delegate_;
   sk_sp<GrContext> context_;
@@ -196,6 +196,20 @@ bool EmbedderEngine::ReloadSystemFonts() {
   return shell_->ReloadSystemFonts();
 }
 
+bool EmbedderEngine::InvalidateSurfaceContents() {
+  if (!IsValid()) {
+    return false;
+  }
+
+  shell_->GetTaskRunners().GetRasterTaskRunner()->PostTask(
+      [rasterizer = shell_->GetRasterizer()]() {
+        if (rasterizer) {
+          rasterizer->InvalidateSurfaceContents();
+        }
+      });
+  return true;
+}
+
 bool EmbedderEngine::PostRenderThreadTask(const fml::closure& task) {
   if (!IsValid()) {
     return false;
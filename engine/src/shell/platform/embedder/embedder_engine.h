@@ -60,6 +60,10 @@ class EmbedderEngine {
 
   bool ReloadSystemFonts();
 
+  // Makes the rasterizer paint the next frame in full, to be called whenever
+  // the render target it draws into was re-created.
+  bool InvalidateSurfaceContents();
+
   bool PostRenderThreadTask(const fml::closure& task);
 
   bool RunTask(const UIWidgetsTask* task);
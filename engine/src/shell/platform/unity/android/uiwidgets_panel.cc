@@ -250,6 +250,7 @@ namespace uiwidgets
 
           surface_manager_->ClearCurrent();
         });
+    reinterpret_cast<EmbedderEngine *>(engine_)->InvalidateSurfaceContents();
 
     ViewportMetrics metrics;
     metrics.physical_width = static_cast<float>(width);
@@ -220,7 +220,10 @@ void* UIWidgetsPanel::OnRenderTexture(void *native_texture_ptr, size_t width,
   metrics.device_pixel_ratio = device_pixel_ratio;
   reinterpret_cast<EmbedderEngine*>(engine_)->SetViewportMetrics(metrics);
 
-  return surface_manager_->CreateRenderTexture(native_texture_ptr, width, height);
+  void* render_texture =
+      surface_manager_->CreateRenderTexture(native_texture_ptr, width, height);
+  reinterpret_cast<EmbedderEngine*>(engine_)->InvalidateSurfaceContents();
+  return render_texture;
 }
 
 bool UIWidgetsPanel::ReleaseNativeRenderTexture() { return surface_manager_->ReleaseNativeRenderTexture(); }
@@ -248,6 +248,7 @@ void* UIWidgetsPanel::OnRenderTexture(size_t width,
   reinterpret_cast<EmbedderEngine*>(engine_)->SetViewportMetrics(metrics);
 
   fbo_ = surface_manager_->CreateRenderSurface(width, height);
+  reinterpret_cast<EmbedderEngine*>(engine_)->InvalidateSurfaceContents();
   return static_cast<void*>(surface_manager_->GetD3DInnerTexture());
 }
 